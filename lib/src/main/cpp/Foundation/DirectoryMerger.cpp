@@ -0,0 +1,210 @@
+#include "DirectoryMerger.h"
+#include "../Substrate/HookRegistry.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+
+#define TAG "DirectoryMerger"
+
+namespace VirtualSpace {
+
+namespace {
+
+// struct dirent与内核的linux_dirent64布局相同，getdents64的结果可以直接交给调用方
+static_assert(offsetof(struct dirent, d_name) == 19, "struct dirent must match linux_dirent64");
+
+struct DirectoryState {
+    std::mutex mutex;               // 同一DIR允许多个线程交替readdir
+    int fd;
+    dev_t device;                   // 登记时fd所指目录，fd号被复用时据此识别旧状态
+    ino_t inode;
+    char* arena;
+    size_t position;
+    size_t length;
+    bool realDone;
+    size_t nextVirtual;
+    std::vector<IORelocator::VirtualEntry> entries;
+};
+
+HookRegistry<DirectoryState*> sDirectories;
+
+inline size_t recordLength(size_t nameLength) {
+    return (offsetof(struct dirent, d_name) + nameLength + 1 + 7) & ~static_cast<size_t>(7);
+}
+
+// 与虚拟子项同名的真实项由虚拟子项代替，重定向后stat看到的也是虚拟目标
+bool isShadowed(const DirectoryState& state, const char* name) {
+    auto it = std::lower_bound(state.entries.begin(), state.entries.end(), name,
+                               [](const IORelocator::VirtualEntry& entry, const char* value) {
+                                   return strcmp(entry.name.c_str(), value) < 0;
+                               });
+    return it != state.entries.end() && strcmp(it->name.c_str(), name) == 0;
+}
+
+// 在缓冲区中生成尽可能多的虚拟子项
+size_t fillVirtual(DirectoryState& state) {
+    size_t used = 0;
+    while (state.nextVirtual < state.entries.size()) {
+        const IORelocator::VirtualEntry& entry = state.entries[state.nextVirtual];
+        size_t length = recordLength(entry.name.length());
+        if (used + length > DirectoryMerger::kArenaSize) {
+            break;
+        }
+        struct dirent* record = reinterpret_cast<struct dirent*>(state.arena + used);
+        record->d_ino = entry.inode;
+        record->d_off = 0;
+        record->d_reclen = static_cast<unsigned short>(length);
+        record->d_type = entry.type;
+        memcpy(record->d_name, entry.name.c_str(), entry.name.length() + 1);
+        used += length;
+        state.nextVirtual++;
+    }
+    return used;
+}
+
+// 查找DIR登记的状态。不经过closedir Hook关闭的DIR会留下旧状态，地址被新DIR复用时
+// fd号也可能相同，因此比较fd所指目录的dev/ino，对不上时丢弃旧状态并按未登记处理
+DirectoryState* findState(DIR* dir) {
+    // 绝大多数DIR没有登记，注册表为空时不做查找
+    if (sDirectories.size() == 0) {
+        return nullptr;
+    }
+    DirectoryState* state = nullptr;
+    if (!sDirectories.find(dir, &state)) {
+        return nullptr;
+    }
+    int fd = dirfd(dir);
+    struct stat fdStat;
+    if (state->fd != fd || fstat(fd, &fdStat) != 0 ||
+        fdStat.st_dev != state->device || fdStat.st_ino != state->inode) {
+        LOGW(TAG, "Dropping stale directory state for %p", dir);
+        DirectoryMerger::detach(dir);
+        return nullptr;
+    }
+    return state;
+}
+
+} // namespace
+
+bool DirectoryMerger::attach(DIR* dir, std::vector<IORelocator::VirtualEntry>&& entries) {
+    if (dir == nullptr || entries.empty()) {
+        return false;
+    }
+
+    struct stat fdStat;
+    if (fstat(dirfd(dir), &fdStat) != 0) {
+        return false;
+    }
+
+    try {
+        char* arena = static_cast<char*>(malloc(kArenaSize));
+        if (arena == nullptr) {
+            return false;
+        }
+
+        DirectoryState* state = new DirectoryState();
+        state->fd = dirfd(dir);
+        state->device = fdStat.st_dev;
+        state->inode = fdStat.st_ino;
+        state->arena = arena;
+        state->position = 0;
+        state->length = 0;
+        state->realDone = false;
+        state->nextVirtual = 0;
+        state->entries = std::move(entries);
+
+        if (!sDirectories.insert(dir, state)) {
+            LOGW(TAG, "Too many merged directories open, listing %p unmerged", dir);
+            free(arena);
+            delete state;
+            return false;
+        }
+        return true;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception attaching directory: %s", e.what());
+        return false;
+    }
+}
+
+bool DirectoryMerger::read(DIR* dir, struct dirent** entry) {
+    DirectoryState* state = findState(dir);
+    if (state == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    while (true) {
+        while (state->position < state->length) {
+            struct dirent* record = reinterpret_cast<struct dirent*>(state->arena + state->position);
+            if (record->d_reclen == 0 || record->d_reclen > state->length - state->position) {
+                state->position = state->length;
+                break;
+            }
+            state->position += record->d_reclen;
+            if (!state->realDone && isShadowed(*state, record->d_name)) {
+                continue;
+            }
+            *entry = record;
+            return true;
+        }
+
+        state->position = 0;
+        state->length = 0;
+        if (!state->realDone) {
+            long bytes = syscall(__NR_getdents64, state->fd, state->arena, kArenaSize);
+            if (bytes < 0) {
+                *entry = nullptr;
+                return true;
+            }
+            if (bytes > 0) {
+                state->length = static_cast<size_t>(bytes);
+                continue;
+            }
+            state->realDone = true;
+        }
+
+        // 读到末尾时errno保持不变
+        state->length = fillVirtual(*state);
+        if (state->length == 0) {
+            *entry = nullptr;
+            return true;
+        }
+    }
+}
+
+bool DirectoryMerger::rewind(DIR* dir) {
+    DirectoryState* state = findState(dir);
+    if (state == nullptr) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(state->mutex);
+    lseek(state->fd, 0, SEEK_SET);
+    state->position = 0;
+    state->length = 0;
+    state->realDone = false;
+    state->nextVirtual = 0;
+    return true;
+}
+
+void DirectoryMerger::detach(DIR* dir) {
+    DirectoryState* state = nullptr;
+    if (sDirectories.size() == 0 || !sDirectories.erase(dir, &state)) {
+        return;
+    }
+    free(state->arena);
+    delete state;
+}
+
+size_t DirectoryMerger::getAttachedCount() {
+    return sDirectories.size();
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,56 @@
+#ifndef DIRECTORY_MERGER_H
+#define DIRECTORY_MERGER_H
+
+#include <dirent.h>
+#include <stddef.h>
+#include <vector>
+#include "IORelocator.h"
+
+namespace VirtualSpace {
+
+/**
+ * 目录列表合并
+ * opendir打开带虚拟子项的目录时为该DIR登记状态，之后的readdir不再经过libc的目录缓冲区：
+ * 每次用getdents64把一大批真实目录项读入该DIR独占、反复使用的缓冲区，遍历时去掉与虚拟子项同名的真实项，
+ * 真实项读完后在同一缓冲区中批量生成虚拟子项。每批只有一次系统调用，每项只在很小的有序表上二分查找一次
+ */
+class DirectoryMerger {
+public:
+    // 每个DIR的目录项缓冲区大小
+    static constexpr size_t kArenaSize = 32 * 1024;
+
+    /**
+     * 为DIR登记要合并的虚拟子项
+     * @param dir opendir()的返回值，尚未读取过；调用前应先detach()同一地址上的旧状态
+     * @param entries 按名称排序的虚拟子项
+     * @return 是否成功，失败时该DIR按原样读取
+     */
+    static bool attach(DIR* dir, std::vector<IORelocator::VirtualEntry>&& entries);
+
+    /**
+     * 读取下一项
+     * @param entry 输出目录项，读完或出错时为nullptr（出错时设置errno）
+     * @return DIR是否已登记；未登记时调用方应交给libc
+     */
+    static bool read(DIR* dir, struct dirent** entry);
+
+    /**
+     * 回到目录开头，虚拟子项重新生成
+     * @return DIR是否已登记
+     */
+    static bool rewind(DIR* dir);
+
+    /**
+     * 注销DIR并释放缓冲区，需在closedir()之前调用
+     */
+    static void detach(DIR* dir);
+
+    /**
+     * 当前登记的DIR数量
+     */
+    static size_t getAttachedCount();
+};
+
+} // namespace VirtualSpace
+
+#endif // DIRECTORY_MERGER_H
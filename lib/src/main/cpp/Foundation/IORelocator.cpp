@@ -2,7 +2,16 @@
 #include "../utils/LogUtils.h"
 #include "../utils/FileUtils.h"
 #include "../utils/StringUtils.h"
+#include "../Substrate/SubstrateHook.h"
+#include "../Substrate/ElfResolver.h"
+#include "SystemCallHook.h"
+#include "IOTracer.h"
+#include "IOStats.h"
+#include "SharedMappingTable.h"
+#include "DirectoryMerger.h"
 #include <android/log.h>
+#include <dlfcn.h>
+#include <stdarg.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <fcntl.h>
@@ -10,6 +19,7 @@
 #include <dirent.h>
 #include <errno.h>
 #include <string.h>
+#include <limits.h>
 #include <map>
 #include <mutex>
 
@@ -17,11 +27,519 @@
 
 namespace VirtualSpace {
 
+namespace {
+
+// 线程重定向缓存：直接映射，按路径哈希定位槽位
+constexpr size_t kRedirectCacheSize = 64;
+constexpr size_t kRedirectCachePathMax = 192;
+constexpr uint32_t kCacheStatsFlushInterval = 64;
+
+struct RedirectCacheEntry {
+    uint64_t generation;
+    uint32_t hash;
+    uint16_t inputLength;
+    uint16_t outputLength;
+    bool redirected;
+    uint16_t virtualLength;
+    int32_t rootFd;
+    uint32_t mappingId;
+    char input[kRedirectCachePathMax];
+    char output[kRedirectCachePathMax];
+};
+
+struct RedirectCache {
+    RedirectCacheEntry entries[kRedirectCacheSize];
+    uint32_t pendingHits;
+    uint32_t pendingMisses;
+};
+
+thread_local RedirectCache tRedirectCache;
+
+// 当前线程切换命名空间时只清空本线程的缓存，代数从1开始，0永远不会命中
+void invalidateThreadCache() {
+    for (RedirectCacheEntry& entry : tRedirectCache.entries) {
+        entry.generation = 0;
+    }
+}
+
+inline uint32_t hashPath(const char* path, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(path[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// 首组件不在过滤器中、且不含可能回到映射目录下的".."时，一定不会命中映射
+inline bool isFilteredOut(const char* path, uint64_t filter) {
+    if (path[0] != '/') {
+        return false;
+    }
+    const char* start = path;
+    while (*start == '/') {
+        start++;
+    }
+    const char* end = start;
+    while (*end != '\0' && *end != '/') {
+        end++;
+    }
+    
+    size_t length = end - start;
+    if (length == 0 || (start[0] == '.' && (length == 1 || (length == 2 && start[1] == '.')))) {
+        return false;
+    }
+    uint64_t bits = PathTrie::componentFilterBits(start, length);
+    if ((filter & bits) == bits) {
+        return false;
+    }
+    return strstr(end, "/..") == nullptr;
+}
+
+// 原始libc函数
+int (*sOrigOpen)(const char*, int, ...) = nullptr;
+int (*sOrigOpen64)(const char*, int, ...) = nullptr;
+int (*sOrigOpen2)(const char*, int) = nullptr;
+int (*sOrigOpenat)(int, const char*, int, ...) = nullptr;
+int (*sOrigOpenat64)(int, const char*, int, ...) = nullptr;
+int (*sOrigOpenat2)(int, const char*, int) = nullptr;
+int (*sOrigStat)(const char*, struct stat*) = nullptr;
+int (*sOrigLstat)(const char*, struct stat*) = nullptr;
+int (*sOrigFstatat)(int, const char*, struct stat*, int) = nullptr;
+int (*sOrigStat64)(const char*, struct stat*) = nullptr;
+int (*sOrigLstat64)(const char*, struct stat*) = nullptr;
+int (*sOrigFstatat64)(int, const char*, struct stat*, int) = nullptr;
+int (*sOrigAccess)(const char*, int) = nullptr;
+int (*sOrigFaccessat)(int, const char*, int, int) = nullptr;
+int (*sOrigUnlink)(const char*) = nullptr;
+int (*sOrigUnlinkat)(int, const char*, int) = nullptr;
+int (*sOrigRename)(const char*, const char*) = nullptr;
+int (*sOrigRenameat)(int, const char*, int, const char*) = nullptr;
+ssize_t (*sOrigReadlink)(const char*, char*, size_t) = nullptr;
+ssize_t (*sOrigReadlinkat)(int, const char*, char*, size_t) = nullptr;
+DIR* (*sOrigOpendir)(const char*) = nullptr;
+struct dirent* (*sOrigReaddir)(DIR*) = nullptr;
+struct dirent64* (*sOrigReaddir64)(DIR*) = nullptr;
+void (*sOrigRewinddir)(DIR*) = nullptr;
+int (*sOrigClosedir)(DIR*) = nullptr;
+int (*sOrigMkdir)(const char*, mode_t) = nullptr;
+int (*sOrigMkdirat)(int, const char*, mode_t) = nullptr;
+int (*sOrigRmdir)(const char*) = nullptr;
+
+// 重定向到栈上缓冲区，未映射时原样返回；路径过长时返回nullptr并设置errno
+inline const char* relocatePath(const char* path, char* buffer, size_t capacity) {
+    if (path == nullptr) {
+        return path;
+    }
+    int length = IORelocator::getInstance()->redirectPath(path, buffer, capacity);
+    if (length < 0) {
+        errno = ENAMETOOLONG;
+        return nullptr;
+    }
+    return length > 0 ? buffer : path;
+}
+
+// 重定向为(目录fd, 路径)：命中根目录fd时改为相对该fd，否则保持调用方的dirfd（绝对路径会忽略dirfd）
+inline const char* relocatePathAt(int dirfd, const char* path, char* buffer, size_t capacity, int* targetDirfd) {
+    *targetDirfd = dirfd;
+    if (path == nullptr) {
+        return path;
+    }
+    int rootFd = -1;
+    int length = IORelocator::getInstance()->redirectPathAt(path, buffer, capacity, &rootFd);
+    if (length < 0) {
+        errno = ENAMETOOLONG;
+        return nullptr;
+    }
+    if (length == 0) {
+        return path;
+    }
+    if (rootFd >= 0) {
+        *targetDirfd = rootFd;
+    }
+    return buffer;
+}
+
+inline bool openNeedsMode(int flags) {
+#ifdef O_TMPFILE
+    if ((flags & O_TMPFILE) == O_TMPFILE) {
+        return true;
+    }
+#endif
+    return (flags & O_CREAT) != 0;
+}
+
+#define RELOCATE_OR_FAIL(path, buffer, failure) \
+    char buffer[PATH_MAX]; \
+    const char* buffer##Path = relocatePath(path, buffer, sizeof(buffer)); \
+    if (buffer##Path == nullptr) { \
+        return failure; \
+    }
+
+// 同时得到buffer##Dirfd；无dirfd参数的Hook传入AT_FDCWD，结果不是AT_FDCWD时需改用*at()调用
+#define RELOCATE_AT_OR_FAIL(dirfd, path, buffer, failure) \
+    char buffer[PATH_MAX]; \
+    int buffer##Dirfd; \
+    const char* buffer##Path = relocatePathAt(dirfd, path, buffer, sizeof(buffer), &buffer##Dirfd); \
+    if (buffer##Path == nullptr) { \
+        return failure; \
+    }
+
+// 相对根目录fd的调用以ENOENT/ESTALE失败时，根目录可能已被删除
+inline bool isRootFdRemoved(int rootFd) {
+    if (errno != ENOENT && errno != ESTALE) {
+        return false;
+    }
+    int savedErrno = errno;
+    struct stat rootStat;
+    bool removed = fstat(rootFd, &rootStat) != 0 || rootStat.st_nlink == 0;
+    errno = savedErrno;
+    return removed;
+}
+
+// 调用function(targetDirfd, targetPath, args...)；经已删除的根目录fd失败时
+// 刷新根目录fd，并按绝对路径再试一次
+template <typename Function, typename... Args>
+inline auto callAt(Function function, int targetDirfd, const char* targetPath, bool viaRoot,
+                   const char* path, Args... args) -> decltype(function(targetDirfd, targetPath, args...)) {
+    auto result = function(targetDirfd, targetPath, args...);
+    if (result >= 0 || !viaRoot || !isRootFdRemoved(targetDirfd)) {
+        return result;
+    }
+    IORelocator::getInstance()->revalidateRootFds();
+    char absolute[PATH_MAX];
+    const char* absolutePath = relocatePath(path, absolute, sizeof(absolute));
+    if (absolutePath == nullptr) {
+        return result;
+    }
+    return function(AT_FDCWD, absolutePath, args...);
+}
+
+// 配合RELOCATE_AT_OR_FAIL使用，dirfd和path为传给它的参数
+#define CALL_AT(function, dirfd, path, buffer, ...) \
+    callAt(function, buffer##Dirfd, buffer##Path, buffer##Dirfd != (dirfd), path, __VA_ARGS__)
+
+// 删除或移动目录后根目录可能已失效，成功时重新校验
+inline int revalidateRootsAfter(int result) {
+    if (result == 0) {
+        int savedErrno = errno;
+        IORelocator::getInstance()->revalidateRootFds();
+        errno = savedErrno;
+    }
+    return result;
+}
+
+int newOpen(const char* path, int flags, ...) {
+    IO_STATS_CALL(SYSCALL_OPEN);
+    IO_TRACE_SCOPE(SYSCALL_OPEN);
+    mode_t mode = 0;
+    if (openNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigOpenat, AT_FDCWD, path, target, flags, mode);
+    }
+    return sOrigOpen(targetPath, flags, mode);
+}
+
+int newOpen64(const char* path, int flags, ...) {
+    IO_STATS_CALL(SYSCALL_OPEN);
+    IO_TRACE_SCOPE(SYSCALL_OPEN);
+    mode_t mode = 0;
+    if (openNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigOpenat64, AT_FDCWD, path, target, flags, mode);
+    }
+    return sOrigOpen64(targetPath, flags, mode);
+}
+
+int newOpen2(const char* path, int flags) {
+    IO_STATS_CALL(SYSCALL_OPEN);
+    IO_TRACE_SCOPE(SYSCALL_OPEN);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigOpenat2, AT_FDCWD, path, target, flags);
+    }
+    return sOrigOpen2(targetPath, flags);
+}
+
+int newOpenat(int dirfd, const char* path, int flags, ...) {
+    IO_STATS_CALL(SYSCALL_OPENAT);
+    IO_TRACE_SCOPE(SYSCALL_OPENAT);
+    mode_t mode = 0;
+    if (openNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigOpenat, dirfd, path, target, flags, mode);
+}
+
+int newOpenat64(int dirfd, const char* path, int flags, ...) {
+    IO_STATS_CALL(SYSCALL_OPENAT);
+    IO_TRACE_SCOPE(SYSCALL_OPENAT);
+    mode_t mode = 0;
+    if (openNeedsMode(flags)) {
+        va_list args;
+        va_start(args, flags);
+        mode = static_cast<mode_t>(va_arg(args, int));
+        va_end(args);
+    }
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigOpenat64, dirfd, path, target, flags, mode);
+}
+
+int newOpenat2(int dirfd, const char* path, int flags) {
+    IO_STATS_CALL(SYSCALL_OPENAT);
+    IO_TRACE_SCOPE(SYSCALL_OPENAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigOpenat2, dirfd, path, target, flags);
+}
+
+int newStat(const char* path, struct stat* buf) {
+    IO_STATS_CALL(SYSCALL_STAT);
+    IO_TRACE_SCOPE(SYSCALL_STAT);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigFstatat, AT_FDCWD, path, target, buf, 0);
+    }
+    return sOrigStat(targetPath, buf);
+}
+
+int newLstat(const char* path, struct stat* buf) {
+    IO_STATS_CALL(SYSCALL_LSTAT);
+    IO_TRACE_SCOPE(SYSCALL_LSTAT);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigFstatat, AT_FDCWD, path, target, buf, AT_SYMLINK_NOFOLLOW);
+    }
+    return sOrigLstat(targetPath, buf);
+}
+
+int newFstatat(int dirfd, const char* path, struct stat* buf, int flags) {
+    IO_STATS_CALL(SYSCALL_FSTATAT);
+    IO_TRACE_SCOPE(SYSCALL_FSTATAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigFstatat, dirfd, path, target, buf, flags);
+}
+
+int newStat64(const char* path, struct stat* buf) {
+    IO_STATS_CALL(SYSCALL_STAT);
+    IO_TRACE_SCOPE(SYSCALL_STAT);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigFstatat64, AT_FDCWD, path, target, buf, 0);
+    }
+    return sOrigStat64(targetPath, buf);
+}
+
+int newLstat64(const char* path, struct stat* buf) {
+    IO_STATS_CALL(SYSCALL_LSTAT);
+    IO_TRACE_SCOPE(SYSCALL_LSTAT);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigFstatat64, AT_FDCWD, path, target, buf, AT_SYMLINK_NOFOLLOW);
+    }
+    return sOrigLstat64(targetPath, buf);
+}
+
+int newFstatat64(int dirfd, const char* path, struct stat* buf, int flags) {
+    IO_STATS_CALL(SYSCALL_FSTATAT);
+    IO_TRACE_SCOPE(SYSCALL_FSTATAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigFstatat64, dirfd, path, target, buf, flags);
+}
+
+int newAccess(const char* path, int mode) {
+    IO_STATS_CALL(SYSCALL_ACCESS);
+    IO_TRACE_SCOPE(SYSCALL_ACCESS);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigFaccessat, AT_FDCWD, path, target, mode, 0);
+    }
+    return sOrigAccess(targetPath, mode);
+}
+
+int newFaccessat(int dirfd, const char* path, int mode, int flags) {
+    IO_STATS_CALL(SYSCALL_FACCESSAT);
+    IO_TRACE_SCOPE(SYSCALL_FACCESSAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigFaccessat, dirfd, path, target, mode, flags);
+}
+
+int newUnlink(const char* path) {
+    IO_STATS_CALL(SYSCALL_UNLINK);
+    IO_TRACE_SCOPE(SYSCALL_UNLINK);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigUnlinkat, AT_FDCWD, path, target, 0);
+    }
+    return sOrigUnlink(targetPath);
+}
+
+int newUnlinkat(int dirfd, const char* path, int flags) {
+    IO_STATS_CALL(SYSCALL_UNLINKAT);
+    IO_TRACE_SCOPE(SYSCALL_UNLINKAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    int result = CALL_AT(sOrigUnlinkat, dirfd, path, target, flags);
+    return (flags & AT_REMOVEDIR) != 0 ? revalidateRootsAfter(result) : result;
+}
+
+// renameat的两个路径各自可能经过根目录fd，任一失败的根目录被删除时两边都按绝对路径重试
+int renameAt(int oldDirfd, const char* oldTarget, bool oldViaRoot, const char* oldPath,
+             int newDirfd, const char* newTarget, bool newViaRoot, const char* newPath) {
+    int result = sOrigRenameat(oldDirfd, oldTarget, newDirfd, newTarget);
+    if (result >= 0 || !((oldViaRoot && isRootFdRemoved(oldDirfd)) || (newViaRoot && isRootFdRemoved(newDirfd)))) {
+        return result;
+    }
+    IORelocator::getInstance()->revalidateRootFds();
+    char oldAbsolute[PATH_MAX];
+    char newAbsolute[PATH_MAX];
+    const char* oldRetry = oldViaRoot ? relocatePath(oldPath, oldAbsolute, sizeof(oldAbsolute)) : oldTarget;
+    const char* newRetry = newViaRoot ? relocatePath(newPath, newAbsolute, sizeof(newAbsolute)) : newTarget;
+    if (oldRetry == nullptr || newRetry == nullptr) {
+        return result;
+    }
+    return sOrigRenameat(oldViaRoot ? AT_FDCWD : oldDirfd, oldRetry, newViaRoot ? AT_FDCWD : newDirfd, newRetry);
+}
+
+int newRename(const char* oldPath, const char* newPath) {
+    IO_STATS_CALL(SYSCALL_RENAME);
+    IO_TRACE_SCOPE(SYSCALL_RENAME);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, oldPath, oldTarget, -1);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, newPath, newTarget, -1);
+    if (oldTargetDirfd != AT_FDCWD || newTargetDirfd != AT_FDCWD) {
+        return revalidateRootsAfter(renameAt(oldTargetDirfd, oldTargetPath, oldTargetDirfd != AT_FDCWD, oldPath,
+                                             newTargetDirfd, newTargetPath, newTargetDirfd != AT_FDCWD, newPath));
+    }
+    return revalidateRootsAfter(sOrigRename(oldTargetPath, newTargetPath));
+}
+
+int newRenameat(int oldDirfd, const char* oldPath, int newDirfd, const char* newPath) {
+    IO_STATS_CALL(SYSCALL_RENAMEAT);
+    IO_TRACE_SCOPE(SYSCALL_RENAMEAT);
+    RELOCATE_AT_OR_FAIL(oldDirfd, oldPath, oldTarget, -1);
+    RELOCATE_AT_OR_FAIL(newDirfd, newPath, newTarget, -1);
+    return revalidateRootsAfter(renameAt(oldTargetDirfd, oldTargetPath, oldTargetDirfd != oldDirfd, oldPath,
+                                         newTargetDirfd, newTargetPath, newTargetDirfd != newDirfd, newPath));
+}
+
+ssize_t newReadlink(const char* path, char* buf, size_t size) {
+    IO_STATS_CALL(SYSCALL_READLINK);
+    IO_TRACE_SCOPE(SYSCALL_READLINK);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigReadlinkat, AT_FDCWD, path, target, buf, size);
+    }
+    return sOrigReadlink(targetPath, buf, size);
+}
+
+ssize_t newReadlinkat(int dirfd, const char* path, char* buf, size_t size) {
+    IO_STATS_CALL(SYSCALL_READLINKAT);
+    IO_TRACE_SCOPE(SYSCALL_READLINKAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigReadlinkat, dirfd, path, target, buf, size);
+}
+
+DIR* newOpendir(const char* path) {
+    IO_STATS_CALL(SYSCALL_OPENDIR);
+    IO_TRACE_SCOPE(SYSCALL_OPENDIR);
+    RELOCATE_OR_FAIL(path, target, nullptr);
+    DIR* dir = sOrigOpendir(targetPath);
+    if (dir != nullptr) {
+        // 按原始路径查找虚拟子项，合并失败不影响opendir结果；
+        // 同一地址上未经closedir Hook关闭的旧DIR可能留有状态，先丢弃
+        int savedErrno = errno;
+        DirectoryMerger::detach(dir);
+        std::vector<IORelocator::VirtualEntry> entries;
+        if (IORelocator::getInstance()->listVirtualEntries(path, &entries) > 0) {
+            DirectoryMerger::attach(dir, std::move(entries));
+        }
+        errno = savedErrno;
+    }
+    return dir;
+}
+
+struct dirent* newReaddir(DIR* dir) {
+    struct dirent* entry = nullptr;
+    if (DirectoryMerger::read(dir, &entry)) {
+        return entry;
+    }
+    return sOrigReaddir(dir);
+}
+
+struct dirent64* newReaddir64(DIR* dir) {
+    struct dirent* entry = nullptr;
+    if (DirectoryMerger::read(dir, &entry)) {
+        return reinterpret_cast<struct dirent64*>(entry);
+    }
+    return sOrigReaddir64(dir);
+}
+
+void newRewinddir(DIR* dir) {
+    if (!DirectoryMerger::rewind(dir)) {
+        sOrigRewinddir(dir);
+    }
+}
+
+int newClosedir(DIR* dir) {
+    DirectoryMerger::detach(dir);
+    return sOrigClosedir(dir);
+}
+
+int newMkdir(const char* path, mode_t mode) {
+    IO_STATS_CALL(SYSCALL_MKDIR);
+    IO_TRACE_SCOPE(SYSCALL_MKDIR);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return CALL_AT(sOrigMkdirat, AT_FDCWD, path, target, mode);
+    }
+    return sOrigMkdir(targetPath, mode);
+}
+
+int newMkdirat(int dirfd, const char* path, mode_t mode) {
+    IO_STATS_CALL(SYSCALL_MKDIRAT);
+    IO_TRACE_SCOPE(SYSCALL_MKDIRAT);
+    RELOCATE_AT_OR_FAIL(dirfd, path, target, -1);
+    return CALL_AT(sOrigMkdirat, dirfd, path, target, mode);
+}
+
+int newRmdir(const char* path) {
+    IO_STATS_CALL(SYSCALL_RMDIR);
+    IO_TRACE_SCOPE(SYSCALL_RMDIR);
+    RELOCATE_AT_OR_FAIL(AT_FDCWD, path, target, -1);
+    if (targetDirfd != AT_FDCWD) {
+        return revalidateRootsAfter(CALL_AT(sOrigUnlinkat, AT_FDCWD, path, target, AT_REMOVEDIR));
+    }
+    return revalidateRootsAfter(sOrigRmdir(targetPath));
+}
+
+} // namespace
+
 IORelocator* IORelocator::sInstance = nullptr;
 std::mutex IORelocator::sMutex;
+thread_local IORelocator::MappingNamespace* IORelocator::tThreadNamespace = nullptr;
 
-IORelocator::IORelocator() : mIsInitialized(false) {
+IORelocator::IORelocator()
+    : mIsInitialized(false), mHookBackend(BACKEND_PLT), mDefaultNamespace(nullptr), mActiveNamespace(nullptr), mGeneration(1), mRootFilter(0), mSharedTable(nullptr), mCacheHits(0), mCacheMisses(0),
+      mRootFdMode(false), mPathTableVersion(0), mPathTableLoaded(false), mInstallMode(INSTALL_SYNC), mHooksReady(false), mHooksFailed(false),
+      mSeccompPending(false) {
     LOGD(TAG, "IORelocator constructor");
+    mDefaultNamespace = findNamespace(kDefaultNamespace, true);
+    mActiveNamespace.store(mDefaultNamespace, std::memory_order_release);
 }
 
 IORelocator::~IORelocator() {
@@ -36,197 +554,1078 @@ IORelocator* IORelocator::getInstance() {
             sInstance = new IORelocator();
         }
     }
-    return sInstance;
+    return sInstance;
+}
+
+void IORelocator::setHookBackend(HookBackend backend) {
+    if (mIsInitialized) {
+        LOGW(TAG, "Hook backend must be selected before initialization");
+        return;
+    }
+    mHookBackend = backend;
+}
+
+void IORelocator::setInstallMode(InstallMode mode) {
+    if (mIsInitialized) {
+        LOGW(TAG, "Install mode must be selected before initialization");
+        return;
+    }
+    mInstallMode = mode;
+}
+
+IORelocator::HookState IORelocator::waitForHooks(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(mReadyMutex);
+    if (timeoutMs < 0) {
+        mReadyCondition.wait(lock, [this] { return mHooksReady; });
+    } else if (!mReadyCondition.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return mHooksReady; })) {
+        LOGW(TAG, "Timed out waiting for deferred hooks");
+        return HOOKS_PENDING;
+    }
+    return mHooksFailed ? HOOKS_FAILED : HOOKS_READY;
+}
+
+void IORelocator::markHooksReady(bool success) {
+    {
+        std::lock_guard<std::mutex> lock(mReadyMutex);
+        mHooksReady = true;
+        mHooksFailed = !success;
+    }
+    mReadyCondition.notify_all();
+}
+
+void IORelocator::setPathTable(const std::string& filePath, uint64_t configVersion) {
+    if (mIsInitialized) {
+        LOGW(TAG, "Path table must be selected before initialization");
+        return;
+    }
+    mPathTableFile = filePath;
+    mPathTableVersion = configVersion;
+}
+
+bool IORelocator::savePathTable() {
+    if (!mIsInitialized || mPathTableFile.empty()) {
+        return false;
+    }
+    
+    try {
+        // 持有mMutex时快照不会被替换，可直接访问
+        std::lock_guard<std::mutex> lock(mMutex);
+        
+        // 空表写入后会被当作有效映射表载入，默认映射从此不再重建
+        if (mDefaultNamespace->mappings.empty()) {
+            LOGW(TAG, "No path mappings, path table not saved");
+            return false;
+        }
+        
+        const MappingSnapshot* snapshot = mDefaultNamespace->snapshot.load(std::memory_order_acquire);
+        if (snapshot == nullptr || !snapshot->trie->writeTo(mPathTableFile, mPathTableVersion)) {
+            return false;
+        }
+        
+        LOGD(TAG, "Saved %zu path mappings to %s", mDefaultNamespace->mappings.size(), mPathTableFile.c_str());
+        return true;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception saving path table: %s", e.what());
+        return false;
+    }
+}
+
+std::map<std::string, std::string> IORelocator::getPathMappings() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mDefaultNamespace->mappings;
+}
+
+bool IORelocator::loadPathTable() {
+    mPathTableLoaded = false;
+    if (mPathTableFile.empty()) {
+        return false;
+    }
+    
+    std::unique_ptr<PathTrie> trie = PathTrie::map(mPathTableFile, mPathTableVersion);
+    if (!trie) {
+        return false;
+    }
+    
+    // 映射表按std::map顺序编号，按序号回填即可与重新编译的结果一致
+    std::map<std::string, std::string>& mappings = mDefaultNamespace->mappings;
+    for (size_t i = 0; i < trie->size(); i++) {
+        std::string originalPath;
+        std::string virtualPath;
+        trie->getMapping(i, &originalPath, &virtualPath);
+        mappings.emplace_hint(mappings.end(), std::move(originalPath), std::move(virtualPath));
+    }
+    publishSnapshot(mDefaultNamespace, std::move(trie));
+    
+    mPathTableLoaded = true;
+    LOGD(TAG, "Loaded %zu path mappings from %s", mappings.size(), mPathTableFile.c_str());
+    return true;
+}
+
+bool IORelocator::initialize() {
+    if (mIsInitialized) {
+        LOGW(TAG, "IORelocator already initialized");
+        return true;
+    }
+    
+    try {
+        LOGD(TAG, "Initializing IORelocator...");
+        
+        // 初始化路径映射
+        initializeMappings();
+        
+        // 初始化系统调用Hook
+        if (!initializeSystemCallHooks()) {
+            LOGE(TAG, "Failed to initialize system call hooks");
+            return false;
+        }
+        
+        mIsInitialized = true;
+        LOGD(TAG, "IORelocator initialized successfully");
+        return true;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception during IORelocator initialization: %s", e.what());
+        markHooksReady(false);
+        return false;
+    }
+}
+
+bool IORelocator::initializePublisher() {
+    if (mIsInitialized) {
+        LOGW(TAG, "IORelocator already initialized");
+        return true;
+    }
+    
+    try {
+        LOGD(TAG, "Initializing IORelocator as mapping publisher...");
+        
+        // 宿主只维护映射并发布给虚拟进程，不安装任何Hook，等待Hook的调用方直接放行
+        initializeMappings();
+        markHooksReady(true);
+        
+        mIsInitialized = true;
+        LOGD(TAG, "IORelocator publisher initialized successfully");
+        return true;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception during IORelocator publisher initialization: %s", e.what());
+        return false;
+    }
+}
+
+void IORelocator::initializeMappings() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mDefaultNamespace->mappings.clear();
+    if (!loadPathTable()) {
+        publishSnapshot(mDefaultNamespace);
+    }
+}
+
+void IORelocator::cleanup() {
+    if (!mIsInitialized) {
+        return;
+    }
+    
+    try {
+        LOGD(TAG, "Cleaning up IORelocator...");
+        
+        // 清理系统调用Hook
+        cleanupSystemCallHooks();
+        
+        // 清理路径映射
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            for (auto& entry : mNamespaces) {
+                entry.second->mappings.clear();
+            }
+            clearSnapshots();
+            closeRootFds();
+        }
+        
+        mIsInitialized = false;
+        LOGD(TAG, "IORelocator cleanup completed");
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception during IORelocator cleanup: %s", e.what());
+    }
+}
+
+bool IORelocator::addPathMapping(const std::string& originalPath, const std::string& virtualPath) {
+    if (!mIsInitialized) {
+        LOGE(TAG, "IORelocator not initialized");
+        return false;
+    }
+    
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+        
+        // 规范化路径
+        std::string normalizedOriginal = FileUtils::normalizePath(originalPath);
+        std::string normalizedVirtual = FileUtils::normalizePath(virtualPath);
+        
+        // 检查路径是否有效
+        if (normalizedOriginal.empty() || normalizedVirtual.empty()) {
+            LOGE(TAG, "Invalid path mapping: %s -> %s", originalPath.c_str(), virtualPath.c_str());
+            return false;
+        }
+        
+        // 添加映射
+        mDefaultNamespace->mappings[normalizedOriginal] = normalizedVirtual;
+        publishSnapshot(mDefaultNamespace);
+        
+        LOGD(TAG, "Added path mapping: %s -> %s", normalizedOriginal.c_str(), normalizedVirtual.c_str());
+        return true;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception adding path mapping: %s", e.what());
+        return false;
+    }
+}
+
+int IORelocator::addPathMappings(const std::vector<std::pair<std::string, std::string>>& mappings) {
+    return addPathMappings(kDefaultNamespace, mappings);
+}
+
+int IORelocator::addPathMappings(const std::string& namespaceName,
+                                 const std::vector<std::pair<std::string, std::string>>& mappings) {
+    if (!mIsInitialized) {
+        LOGE(TAG, "IORelocator not initialized");
+        return -1;
+    }
+    
+    try {
+        // 规范化在锁外完成
+        std::vector<std::pair<std::string, std::string>> normalized;
+        normalized.reserve(mappings.size());
+        for (const auto& mapping : mappings) {
+            std::string normalizedOriginal = FileUtils::normalizePath(mapping.first);
+            std::string normalizedVirtual = FileUtils::normalizePath(mapping.second);
+            if (normalizedOriginal.empty() || normalizedVirtual.empty()) {
+                LOGE(TAG, "Invalid path mapping: %s -> %s", mapping.first.c_str(), mapping.second.c_str());
+                continue;
+            }
+            normalized.emplace_back(std::move(normalizedOriginal), std::move(normalizedVirtual));
+        }
+        
+        if (normalized.empty()) {
+            return 0;
+        }
+        
+        std::lock_guard<std::mutex> lock(mMutex);
+        MappingNamespace* mappingNamespace = findNamespace(namespaceName, true);
+        for (auto& mapping : normalized) {
+            mappingNamespace->mappings[mapping.first] = std::move(mapping.second);
+        }
+        publishSnapshot(mappingNamespace);
+        
+        LOGD(TAG, "Added %zu path mappings to namespace '%s'", normalized.size(), namespaceName.c_str());
+        return static_cast<int>(normalized.size());
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception adding path mappings: %s", e.what());
+        return -1;
+    }
+}
+
+bool IORelocator::removePathMapping(const std::string& originalPath) {
+    return removePathMapping(kDefaultNamespace, originalPath);
+}
+
+bool IORelocator::removePathMapping(const std::string& namespaceName, const std::string& originalPath) {
+    if (!mIsInitialized) {
+        LOGE(TAG, "IORelocator not initialized");
+        return false;
+    }
+    
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+        
+        std::string normalizedPath = FileUtils::normalizePath(originalPath);
+        
+        MappingNamespace* mappingNamespace = findNamespace(namespaceName, false);
+        if (mappingNamespace == nullptr) {
+            LOGW(TAG, "Mapping namespace not found: %s", namespaceName.c_str());
+            return false;
+        }
+        
+        auto it = mappingNamespace->mappings.find(normalizedPath);
+        if (it != mappingNamespace->mappings.end()) {
+            mappingNamespace->mappings.erase(it);
+            publishSnapshot(mappingNamespace);
+            LOGD(TAG, "Removed path mapping: %s", normalizedPath.c_str());
+            return true;
+        } else {
+            LOGW(TAG, "Path mapping not found: %s", normalizedPath.c_str());
+            return false;
+        }
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception removing path mapping: %s", e.what());
+        return false;
+    }
+}
+
+std::string IORelocator::redirectPath(const std::string& originalPath) {
+    if (!mIsInitialized) {
+        return originalPath;
+    }
+    
+    try {
+        char redirectedPath[PATH_MAX];
+        int length = redirectPath(originalPath.c_str(), redirectedPath, sizeof(redirectedPath));
+        if (length <= 0) {
+            // 没有找到映射，返回原始路径
+            return originalPath;
+        }
+        
+        return std::string(redirectedPath, length);
+        
+    } catch (const std::exception& e) {
+        LOGE_SAMPLED(TAG, "Exception redirecting path: %s", e.what());
+        return originalPath;
+    }
+}
+
+int IORelocator::redirectPath(const char* originalPath, char* out, size_t capacity) {
+    size_t virtualLength = 0;
+    int rootFd = -1;
+    return redirectPathInternal(originalPath, out, capacity, &virtualLength, &rootFd);
+}
+
+int IORelocator::redirectPathSignalSafe(const char* originalPath, char* out, size_t capacity) {
+    if (!mIsInitialized || originalPath == nullptr || out == nullptr) {
+        return 0;
+    }
+
+    // 与redirectPathInternal()相同的查找，但去掉线程缓存、线程命名空间和统计：
+    // 它们依赖thread_local，首次访问时emutls会分配内存
+    SharedMappingTable* sharedTable = mSharedTable.load(std::memory_order_acquire);
+    uint64_t rootFilter = mRootFilter.load(std::memory_order_acquire);
+    if (sharedTable != nullptr) {
+        rootFilter |= sharedTable->getRootFilter();
+    }
+    if (isFilteredOut(originalPath, rootFilter)) {
+        return 0;
+    }
+
+    char normalizedPath[PATH_MAX];
+    size_t normalizedLength = FileUtils::normalizePath(originalPath, normalizedPath, sizeof(normalizedPath));
+    if (normalizedLength == 0) {
+        return 0;
+    }
+
+    int result = 0;
+    size_t matchedLength = 0;
+    {
+        RcuDomain::SignalReadGuard guard(mRcu);
+        MappingNamespace* mappingNamespace = mActiveNamespace.load(std::memory_order_acquire);
+        const MappingSnapshot* snapshot = mappingNamespace->snapshot.load(std::memory_order_seq_cst);
+
+        PathTrie::Match match;
+        if (snapshot != nullptr && snapshot->trie->findLongestPrefix(normalizedPath, normalizedLength, &match)) {
+            result = PathTrie::rewrite(match, normalizedPath, normalizedLength, out, capacity);
+            if (result < 0) {
+                return -1;
+            }
+            matchedLength = match.prefixLength;
+        }
+    }
+
+    if (sharedTable != nullptr) {
+        size_t sharedPrefixLength = 0;
+        int sharedResult = sharedTable->redirect(normalizedPath, normalizedLength, matchedLength,
+                                                 out, capacity, &sharedPrefixLength);
+        if (sharedResult != 0) {
+            result = sharedResult;
+        }
+    }
+    return result;
+}
+
+int IORelocator::redirectPathAt(const char* originalPath, char* out, size_t capacity, int* dirfd) {
+    size_t virtualLength = 0;
+    int rootFd = -1;
+    int length = redirectPathInternal(originalPath, out, capacity, &virtualLength, &rootFd);
+    *dirfd = -1;
+    
+    // 恰好是虚拟根目录本身时仍用绝对路径，避免rmdir、rename等对"."的特殊处理
+    if (length <= 0 || rootFd < 0 || static_cast<size_t>(length) <= virtualLength + 1 ||
+        out[virtualLength] != '/') {
+        return length;
+    }
+    
+    // 去掉虚拟前缀和分隔符，只保留相对路径
+    size_t relativeLength = length - virtualLength - 1;
+    memmove(out, out + virtualLength + 1, relativeLength + 1);
+    *dirfd = rootFd;
+    return static_cast<int>(relativeLength);
+}
+
+size_t IORelocator::listVirtualEntries(const char* directoryPath, std::vector<VirtualEntry>* entries) {
+    if (!mIsInitialized || directoryPath == nullptr || entries == nullptr) {
+        return 0;
+    }
+
+    char normalizedPath[PATH_MAX];
+    size_t normalizedLength = FileUtils::normalizePath(directoryPath, normalizedPath, sizeof(normalizedPath));
+    if (normalizedLength == 0) {
+        return 0;
+    }
+
+    // 只在RCU临界区内复制子组件名，stat放到临界区之外
+    std::vector<std::string> names;
+    {
+        RcuDomain::ReadGuard guard(mRcu);
+        MappingNamespace* mappingNamespace = tThreadNamespace;
+        if (mappingNamespace == nullptr) {
+            mappingNamespace = mActiveNamespace.load(std::memory_order_acquire);
+        }
+        const MappingSnapshot* snapshot = mappingNamespace->snapshot.load(std::memory_order_seq_cst);
+
+        std::vector<PathTrie::Child> children;
+        if (snapshot == nullptr || !snapshot->trie->listChildren(normalizedPath, normalizedLength, &children)) {
+            return 0;
+        }
+        for (const PathTrie::Child& child : children) {
+            if (child.length <= NAME_MAX) {
+                names.emplace_back(child.label, child.length);
+            }
+        }
+    }
+
+    // 子项只有在重定向目标存在时才列出，inode和类型取自目标
+    int (*statAt)(int, const char*, struct stat*, int) = sOrigFstatat != nullptr ? sOrigFstatat : fstatat;
+    char childPath[PATH_MAX];
+    char targetPath[PATH_MAX];
+    size_t prefixLength = normalizedLength > 1 ? normalizedLength + 1 : normalizedLength;
+    memcpy(childPath, normalizedPath, normalizedLength);
+    childPath[prefixLength - 1] = '/';
+
+    for (const std::string& name : names) {
+        if (prefixLength + name.length() + 1 > sizeof(childPath)) {
+            continue;
+        }
+        memcpy(childPath + prefixLength, name.c_str(), name.length() + 1);
+
+        int rootFd = -1;
+        if (redirectPathAt(childPath, targetPath, sizeof(targetPath), &rootFd) <= 0) {
+            continue;
+        }
+        struct stat st;
+        if (statAt(rootFd >= 0 ? rootFd : AT_FDCWD, targetPath, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+            continue;
+        }
+        entries->push_back({name, static_cast<uint64_t>(st.st_ino), static_cast<uint8_t>(IFTODT(st.st_mode))});
+    }
+    return entries->size();
+}
+
+int IORelocator::redirectPathInternal(const char* originalPath, char* out, size_t capacity,
+                                      size_t* virtualLength, int* rootFd) {
+    *virtualLength = 0;
+    *rootFd = -1;
+    if (!mIsInitialized || originalPath == nullptr || out == nullptr) {
+        return 0;
+    }
+    
+    // 查找耗时含过滤器放行和线程缓存命中
+    IOStatsLookupTimer lookupTimer;
+    
+    // 绝大多数路径（/system、/proc、/dev等）的首组件不属于任何映射，
+    // 在计算长度、查询缓存和规范化之前直接放行
+    SharedMappingTable* sharedTable = mSharedTable.load(std::memory_order_acquire);
+    uint64_t rootFilter = mRootFilter.load(std::memory_order_acquire);
+    if (sharedTable != nullptr) {
+        rootFilter |= sharedTable->getRootFilter();
+    }
+    if (isFilteredOut(originalPath, rootFilter)) {
+        return 0;
+    }
+    
+    size_t inputLength = strlen(originalPath);
+    
+    // 先读取代数再读取快照，保证缓存项不会标记为比其内容更新的代数
+    // 两者都只增不减，共享映射表的序列号直接累加即可
+    uint64_t generation = mGeneration.load(std::memory_order_acquire);
+    if (sharedTable != nullptr) {
+        generation += sharedTable->getSequence();
+    }
+    
+    // 查询线程缓存，命中时跳过规范化和前缀树查找
+    RedirectCacheEntry* entry = nullptr;
+    uint32_t hash = 0;
+    if (inputLength < kRedirectCachePathMax) {
+        hash = hashPath(originalPath, inputLength);
+        entry = &tRedirectCache.entries[hash & (kRedirectCacheSize - 1)];
+        if (entry->generation == generation && entry->hash == hash &&
+            entry->inputLength == inputLength &&
+            memcmp(entry->input, originalPath, inputLength) == 0) {
+            recordCacheAccess(true);
+            if (!entry->redirected) {
+                return 0;
+            }
+            IO_TRACE_ANNOTATE(hash, entry->mappingId);
+            IO_STATS_MAPPING_HIT(entry->mappingId);
+            *virtualLength = entry->virtualLength;
+            *rootFd = entry->rootFd;
+            if (entry->outputLength + 1u > capacity) {
+                return -1;
+            }
+            memcpy(out, entry->output, entry->outputLength);
+            out[entry->outputLength] = '\0';
+            return entry->outputLength;
+        }
+        recordCacheAccess(false);
+    }
+    
+    // 在栈上规范化
+    char normalizedPath[PATH_MAX];
+    size_t normalizedLength = FileUtils::normalizePath(originalPath, normalizedPath, sizeof(normalizedPath));
+    if (normalizedLength == 0) {
+        return 0;
+    }
+    
+    int result = 0;
+    uint32_t mappingId = 0;
+    size_t matchedLength = 0;
+    {
+        // 读侧不加锁，只在RCU临界区内访问当前快照
+        // 线程指定的命名空间优先，否则使用进程的活动命名空间
+        RcuDomain::ReadGuard guard(mRcu);
+        MappingNamespace* mappingNamespace = tThreadNamespace;
+        if (mappingNamespace == nullptr) {
+            mappingNamespace = mActiveNamespace.load(std::memory_order_acquire);
+        }
+        const MappingSnapshot* snapshot = mappingNamespace->snapshot.load(std::memory_order_seq_cst);
+        
+        // 在前缀树中按组件查找最长匹配的路径映射
+        PathTrie::Match match;
+        if (snapshot != nullptr && snapshot->trie->findLongestPrefix(normalizedPath, normalizedLength, &match)) {
+            // 替换路径，通配映射同时展开$N
+            result = PathTrie::rewrite(match, normalizedPath, normalizedLength, out, capacity);
+            if (result < 0) {
+                return -1;
+            }
+            mappingId = snapshot->mappingIds[match.mappingIndex];
+            matchedLength = match.prefixLength;
+            
+            // 带引用的通配映射每次展开出的根目录不同，按绝对路径处理
+            if (!match.captures && static_cast<size_t>(match.mappingIndex) < snapshot->rootFds.size()) {
+                *virtualLength = match.virtualLength;
+                *rootFd = snapshot->rootFds[match.mappingIndex];
+            }
+        }
+    }
+    
+    // 共享映射表只在前缀比私有映射更长时生效，命中前缀即原始映射路径，哈希作为稳定编号
+    if (sharedTable != nullptr) {
+        size_t sharedPrefixLength = 0;
+        int sharedResult = sharedTable->redirect(normalizedPath, normalizedLength, matchedLength,
+                                                 out, capacity, &sharedPrefixLength);
+        if (sharedResult < 0) {
+            return -1;
+        }
+        if (sharedResult > 0) {
+            // 共享映射的根目录fd无法跨进程传递，按绝对路径处理
+            result = sharedResult;
+            mappingId = hashPath(normalizedPath, sharedPrefixLength);
+            *virtualLength = 0;
+            *rootFd = -1;
+        }
+    }
+    
+    // 写回线程缓存，过长的结果不缓存
+    if (entry != nullptr && static_cast<size_t>(result) < kRedirectCachePathMax) {
+        entry->generation = generation;
+        entry->hash = hash;
+        entry->inputLength = static_cast<uint16_t>(inputLength);
+        memcpy(entry->input, originalPath, inputLength);
+        entry->redirected = result > 0;
+        entry->outputLength = static_cast<uint16_t>(result);
+        entry->virtualLength = static_cast<uint16_t>(*virtualLength);
+        entry->rootFd = *rootFd;
+        entry->mappingId = mappingId;
+        memcpy(entry->output, out, result);
+    }
+    
+    // 热路径上不写日志，重定向事件交给IOTracer和IOStats
+    if (result > 0) {
+        IO_TRACE_ANNOTATE(entry != nullptr ? hash : hashPath(originalPath, inputLength), mappingId);
+        IO_STATS_MAPPING_HIT(mappingId);
+    }
+    
+    return result;
+}
+
+void IORelocator::getRedirectCacheStats(uint64_t* hits, uint64_t* misses) {
+    if (hits != nullptr) {
+        *hits = mCacheHits.load(std::memory_order_relaxed);
+    }
+    if (misses != nullptr) {
+        *misses = mCacheMisses.load(std::memory_order_relaxed);
+    }
+}
+
+void IORelocator::recordCacheAccess(bool hit) {
+    // 先在线程内累计，定期汇总到全局计数，避免热路径上的缓存行争用
+    RedirectCache& cache = tRedirectCache;
+    if (hit) {
+        cache.pendingHits++;
+    } else {
+        cache.pendingMisses++;
+    }
+    
+    if (cache.pendingHits + cache.pendingMisses >= kCacheStatsFlushInterval) {
+        mCacheHits.fetch_add(cache.pendingHits, std::memory_order_relaxed);
+        mCacheMisses.fetch_add(cache.pendingMisses, std::memory_order_relaxed);
+        cache.pendingHits = 0;
+        cache.pendingMisses = 0;
+    }
+}
+
+void IORelocator::publishSnapshot(MappingNamespace* mappingNamespace, std::unique_ptr<PathTrie> trie) {
+    const std::map<std::string, std::string>& mappings = mappingNamespace->mappings;
+    MappingSnapshot* snapshot = new MappingSnapshot();
+    snapshot->trie = trie ? std::move(trie) : PathTrie::build(mappings);
+    
+    // 前缀树按原始路径顺序编号，编号随增删变化，对外使用前缀哈希作为稳定编号
+    snapshot->mappingIds.reserve(mappings.size());
+    for (const auto& mapping : mappings) {
+        snapshot->mappingIds.push_back(hashPath(mapping.first.data(), mapping.first.length()));
+    }
+    openRootFds(snapshot, mappings);
+    snapshot->rootFilter = snapshot->trie->rootFilter();
+    
+    // 过滤器覆盖所有命名空间，线程可能正在使用任意一个；
+    // 先放宽为新旧并集再替换快照，最后收紧，读者不会因过滤器滞后而漏掉映射
+    mRootFilter.fetch_or(snapshot->rootFilter, std::memory_order_release);
+    
+    // 替换后旧快照由RCU延迟回收
+    const MappingSnapshot* oldSnapshot = mappingNamespace->snapshot.exchange(snapshot, std::memory_order_seq_cst);
+    mRootFilter.store(combinedRootFilter(), std::memory_order_release);
+    mGeneration.fetch_add(1, std::memory_order_release);
+    mRcu.retire(oldSnapshot);
+    
+    // 宿主进程把默认命名空间同步发布到共享映射表
+    SharedMappingTable* sharedTable = SharedMappingTable::getInstance();
+    if (mappingNamespace == mDefaultNamespace && sharedTable->isOwner() && !sharedTable->publish(*snapshot->trie)) {
+        LOGE(TAG, "Failed to publish shared mapping table");
+    }
+    
+    installSeccompIfNeeded();
+}
+
+IORelocator::MappingNamespace* IORelocator::findNamespace(const std::string& name, bool create) {
+    auto it = mNamespaces.find(name);
+    if (it != mNamespaces.end()) {
+        return it->second.get();
+    }
+    if (!create) {
+        return nullptr;
+    }
+    
+    std::unique_ptr<MappingNamespace> mappingNamespace(new MappingNamespace());
+    mappingNamespace->name = name;
+    mappingNamespace->snapshot.store(nullptr, std::memory_order_relaxed);
+    MappingNamespace* result = mappingNamespace.get();
+    mNamespaces.emplace(name, std::move(mappingNamespace));
+    return result;
+}
+
+uint64_t IORelocator::combinedRootFilter() const {
+    uint64_t rootFilter = 0;
+    for (const auto& entry : mNamespaces) {
+        const MappingSnapshot* snapshot = entry.second->snapshot.load(std::memory_order_acquire);
+        if (snapshot != nullptr) {
+            rootFilter |= snapshot->rootFilter;
+        }
+    }
+    return rootFilter;
+}
+
+bool IORelocator::hasMappings() const {
+    for (const auto& entry : mNamespaces) {
+        if (!entry.second->mappings.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IORelocator::removeNamespace(const std::string& namespaceName) {
+    if (namespaceName == kDefaultNamespace) {
+        LOGE(TAG, "The default mapping namespace cannot be removed");
+        return false;
+    }
+    
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+        MappingNamespace* mappingNamespace = findNamespace(namespaceName, false);
+        if (mappingNamespace == nullptr) {
+            LOGW(TAG, "Mapping namespace not found: %s", namespaceName.c_str());
+            return false;
+        }
+        
+        // 只清空映射和快照，对象保留给仍指向它的线程
+        mappingNamespace->mappings.clear();
+        MappingNamespace* expected = mappingNamespace;
+        mActiveNamespace.compare_exchange_strong(expected, mDefaultNamespace, std::memory_order_acq_rel);
+        const MappingSnapshot* oldSnapshot = mappingNamespace->snapshot.exchange(nullptr, std::memory_order_seq_cst);
+        mRootFilter.store(combinedRootFilter(), std::memory_order_release);
+        mGeneration.fetch_add(1, std::memory_order_release);
+        mRcu.retire(oldSnapshot);
+        
+        LOGD(TAG, "Removed mapping namespace: %s", namespaceName.c_str());
+        return true;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception removing mapping namespace: %s", e.what());
+        return false;
+    }
+}
+
+bool IORelocator::setActiveNamespace(const std::string& namespaceName) {
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+        MappingNamespace* mappingNamespace = findNamespace(namespaceName, false);
+        if (mappingNamespace == nullptr) {
+            LOGE(TAG, "Mapping namespace not found: %s", namespaceName.c_str());
+            return false;
+        }
+        
+        // 各命名空间的快照已编译好，切换只需替换指针并使线程缓存失效
+        if (mActiveNamespace.exchange(mappingNamespace, std::memory_order_acq_rel) != mappingNamespace) {
+            mGeneration.fetch_add(1, std::memory_order_release);
+        }
+        return true;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception switching mapping namespace: %s", e.what());
+        return false;
+    }
+}
+
+bool IORelocator::setThreadNamespace(const std::string& namespaceName) {
+    MappingNamespace* mappingNamespace = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mappingNamespace = findNamespace(namespaceName, false);
+    }
+    if (mappingNamespace == nullptr) {
+        LOGE(TAG, "Mapping namespace not found: %s", namespaceName.c_str());
+        return false;
+    }
+    
+    if (tThreadNamespace != mappingNamespace) {
+        tThreadNamespace = mappingNamespace;
+        invalidateThreadCache();
+    }
+    return true;
 }
 
-bool IORelocator::initialize() {
-    if (mIsInitialized) {
-        LOGW(TAG, "IORelocator already initialized");
-        return true;
+void IORelocator::clearThreadNamespace() {
+    if (tThreadNamespace != nullptr) {
+        tThreadNamespace = nullptr;
+        invalidateThreadCache();
     }
-    
+}
+
+void IORelocator::setRootFdMode(bool enabled) {
     try {
-        LOGD(TAG, "Initializing IORelocator...");
-        
-        // 初始化路径映射
-        mPathMappings.clear();
-        
-        // 初始化系统调用Hook
-        if (!initializeSystemCallHooks()) {
-            LOGE(TAG, "Failed to initialize system call hooks");
-            return false;
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mRootFdMode.exchange(enabled, std::memory_order_relaxed) == enabled) {
+            return;
         }
         
-        mIsInitialized = true;
-        LOGD(TAG, "IORelocator initialized successfully");
-        return true;
+        // 已有快照的命名空间按新设置重新发布，线程缓存随代数递增失效
+        for (auto& entry : mNamespaces) {
+            if (entry.second->snapshot.load(std::memory_order_acquire) != nullptr) {
+                publishSnapshot(entry.second.get());
+            }
+        }
+        LOGD(TAG, "Root fd mode %s", enabled ? "enabled" : "disabled");
         
     } catch (const std::exception& e) {
-        LOGE(TAG, "Exception during IORelocator initialization: %s", e.what());
-        return false;
+        LOGE(TAG, "Exception setting root fd mode: %s", e.what());
     }
 }
 
-void IORelocator::cleanup() {
-    if (!mIsInitialized) {
+void IORelocator::openRootFds(MappingSnapshot* snapshot, const std::map<std::string, std::string>& mappings) {
+    snapshot->rootFds.assign(mappings.size(), -1);
+    if (!mRootFdMode.load(std::memory_order_relaxed)) {
         return;
     }
     
-    try {
-        LOGD(TAG, "Cleaning up IORelocator...");
-        
-        // 清理系统调用Hook
-        cleanupSystemCallHooks();
+    // 快照序号与mappings的遍历顺序一致，同一虚拟根目录在各命名空间间共用fd
+    size_t index = 0;
+    for (const auto& mapping : mappings) {
+        const std::string& root = mapping.second;
+        int& rootFd = snapshot->rootFds[index++];
         
-        // 清理路径映射
-        mPathMappings.clear();
+        struct stat pathStat;
+        bool exists = stat(root.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
         
-        mIsInitialized = false;
-        LOGD(TAG, "IORelocator cleanup completed");
+        auto it = mRootFds.find(root);
+        if (it != mRootFds.end()) {
+            struct stat fdStat;
+            if (exists && fstat(it->second, &fdStat) == 0 &&
+                fdStat.st_dev == pathStat.st_dev && fdStat.st_ino == pathStat.st_ino) {
+                rootFd = it->second;
+                continue;
+            }
+            // 目录已被删除、移走或重建，旧fd可能仍在使用，推迟到清理时关闭
+            mRetiredRootFds.push_back(it->second);
+            mRootFds.erase(it);
+        }
+        if (!exists) {
+            continue;
+        }
         
-    } catch (const std::exception& e) {
-        LOGE(TAG, "Exception during IORelocator cleanup: %s", e.what());
+        int fd = open(root.c_str(), O_PATH | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0) {
+            LOGW(TAG, "Failed to open mapping root %s: %s", root.c_str(), strerror(errno));
+            continue;
+        }
+        mRootFds[root] = fd;
+        rootFd = fd;
     }
 }
 
-bool IORelocator::addPathMapping(const std::string& originalPath, const std::string& virtualPath) {
-    if (!mIsInitialized) {
-        LOGE(TAG, "IORelocator not initialized");
+bool IORelocator::revalidateRootFds() {
+    if (!mRootFdMode.load(std::memory_order_relaxed)) {
         return false;
     }
     
     try {
         std::lock_guard<std::mutex> lock(mMutex);
-        
-        // 规范化路径
-        std::string normalizedOriginal = FileUtils::normalizePath(originalPath);
-        std::string normalizedVirtual = FileUtils::normalizePath(virtualPath);
-        
-        // 检查路径是否有效
-        if (normalizedOriginal.empty() || normalizedVirtual.empty()) {
-            LOGE(TAG, "Invalid path mapping: %s -> %s", originalPath.c_str(), virtualPath.c_str());
+        bool stale = false;
+        for (const auto& rootFd : mRootFds) {
+            struct stat pathStat;
+            struct stat fdStat;
+            if (fstat(rootFd.second, &fdStat) != 0 || stat(rootFd.first.c_str(), &pathStat) != 0 ||
+                fdStat.st_dev != pathStat.st_dev || fdStat.st_ino != pathStat.st_ino) {
+                stale = true;
+                break;
+            }
+        }
+        if (!stale) {
             return false;
         }
         
-        // 添加映射
-        mPathMappings[normalizedOriginal] = normalizedVirtual;
-        
-        LOGD(TAG, "Added path mapping: %s -> %s", normalizedOriginal.c_str(), normalizedVirtual.c_str());
+        // 重新发布快照时openRootFds()替换失效的fd，线程缓存随代数递增失效
+        for (auto& entry : mNamespaces) {
+            if (entry.second->snapshot.load(std::memory_order_acquire) != nullptr) {
+                publishSnapshot(entry.second.get());
+            }
+        }
+        LOGD(TAG, "Mapping root fds revalidated");
         return true;
         
     } catch (const std::exception& e) {
-        LOGE(TAG, "Exception adding path mapping: %s", e.what());
+        LOGE(TAG, "Exception revalidating root fds: %s", e.what());
         return false;
     }
 }
 
-bool IORelocator::removePathMapping(const std::string& originalPath) {
-    if (!mIsInitialized) {
-        LOGE(TAG, "IORelocator not initialized");
-        return false;
+void IORelocator::closeRootFds() {
+    for (const auto& rootFd : mRootFds) {
+        close(rootFd.second);
     }
-    
+    for (int fd : mRetiredRootFds) {
+        close(fd);
+    }
+    mRootFds.clear();
+    mRetiredRootFds.clear();
+}
+
+bool IORelocator::createSharedTable(size_t slotCapacity) {
     try {
         std::lock_guard<std::mutex> lock(mMutex);
         
-        std::string normalizedPath = FileUtils::normalizePath(originalPath);
-        
-        auto it = mPathMappings.find(normalizedPath);
-        if (it != mPathMappings.end()) {
-            mPathMappings.erase(it);
-            LOGD(TAG, "Removed path mapping: %s", normalizedPath.c_str());
-            return true;
-        } else {
-            LOGW(TAG, "Path mapping not found: %s", normalizedPath.c_str());
+        SharedMappingTable* sharedTable = SharedMappingTable::getInstance();
+        if (!sharedTable->create(slotCapacity)) {
             return false;
         }
         
+        // 发布默认命名空间已有的映射，持有mMutex时快照不会被替换
+        const MappingSnapshot* snapshot = mDefaultNamespace->snapshot.load(std::memory_order_acquire);
+        if (snapshot != nullptr) {
+            sharedTable->publish(*snapshot->trie);
+        }
+        return true;
+        
     } catch (const std::exception& e) {
-        LOGE(TAG, "Exception removing path mapping: %s", e.what());
+        LOGE(TAG, "Exception creating shared mapping table: %s", e.what());
         return false;
     }
 }
 
-std::string IORelocator::redirectPath(const std::string& originalPath) {
-    if (!mIsInitialized) {
-        return originalPath;
-    }
-    
+int IORelocator::getSharedTableFd() {
+    return SharedMappingTable::getInstance()->createReadOnlyFd();
+}
+
+bool IORelocator::attachSharedTable(int fd) {
     try {
         std::lock_guard<std::mutex> lock(mMutex);
         
-        std::string normalizedPath = FileUtils::normalizePath(originalPath);
-        
-        // 查找最长匹配的路径映射
-        std::string bestMatch;
-        std::string bestVirtualPath;
-        size_t bestLength = 0;
-        
-        for (const auto& mapping : mPathMappings) {
-            const std::string& original = mapping.first;
-            const std::string& virtual = mapping.second;
-            
-            // 检查是否是前缀匹配
-            if (normalizedPath.find(original) == 0 && original.length() > bestLength) {
-                bestMatch = original;
-                bestVirtualPath = virtual;
-                bestLength = original.length();
-            }
+        SharedMappingTable* sharedTable = SharedMappingTable::getInstance();
+        if (!sharedTable->attach(fd)) {
+            return false;
         }
         
-        if (!bestMatch.empty()) {
-            // 替换路径
-            std::string redirectedPath = bestVirtualPath + normalizedPath.substr(bestMatch.length());
-            LOGD(TAG, "Path redirected: %s -> %s", normalizedPath.c_str(), redirectedPath.c_str());
-            return redirectedPath;
-        }
+        mSharedTable.store(sharedTable, std::memory_order_release);
+        mGeneration.fetch_add(1, std::memory_order_release);
+        installSeccompIfNeeded();
         
-        // 没有找到映射，返回原始路径
-        return originalPath;
+        LOGD(TAG, "Attached shared mapping table");
+        return true;
         
     } catch (const std::exception& e) {
-        LOGE(TAG, "Exception redirecting path: %s", e.what());
-        return originalPath;
+        LOGE(TAG, "Exception attaching shared mapping table: %s", e.what());
+        return false;
+    }
+}
+
+void IORelocator::clearSnapshots() {
+    mActiveNamespace.store(mDefaultNamespace, std::memory_order_release);
+    mRootFilter.store(0, std::memory_order_release);
+    for (auto& entry : mNamespaces) {
+        mRcu.retire(entry.second->snapshot.exchange(nullptr, std::memory_order_seq_cst));
+    }
+    mGeneration.fetch_add(1, std::memory_order_release);
+    mRcu.synchronize();
+}
+
+void IORelocator::installSeccompIfNeeded() {
+    if (!mSeccompPending || (!hasMappings() && mSharedTable.load(std::memory_order_relaxed) == nullptr)) {
+        return;
+    }
+    
+    if (SystemCallHook::getInstance()->install()) {
+        mSeccompPending = false;
+    } else {
+        LOGE(TAG, "Failed to install seccomp backend");
     }
 }
 
 bool IORelocator::initializeSystemCallHooks() {
+    // 每条失败路径都要标记完成，否则waitForHooks(-1)会一直等待
     try {
         LOGD(TAG, "Initializing system call hooks...");
         
+        // 分阶段安装：只同步安装首次启动必需的Hook，Substrate框架和其余Hook交给后台线程
+        if (mHookBackend == BACKEND_PLT && mInstallMode == INSTALL_STAGED) {
+            if (!installCriticalHooks()) {
+                LOGE(TAG, "Failed to install critical hooks");
+                markHooksReady(false);
+                return false;
+            }
+            mDeferredThread = std::thread(&IORelocator::installDeferredHooks, this, mPltHooks.size());
+            LOGD(TAG, "Critical system call hooks installed, deferring the rest");
+            return true;
+        }
+        
         // 初始化Substrate Hook框架
-        if (!SubstrateHook::initialize()) {
+        if (!SubstrateHook::getInstance()->initialize()) {
             LOGE(TAG, "Failed to initialize Substrate Hook");
+            markHooksReady(false);
             return false;
         }
         
+        // seccomp后端：过滤器无法卸载，等到有映射时再安装
+        if (mHookBackend == BACKEND_SECCOMP) {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mSeccompPending = true;
+            installSeccompIfNeeded();
+            markHooksReady(true);
+            LOGD(TAG, "System call hooks initialized with seccomp backend");
+            return true;
+        }
+        
         // Hook文件操作相关的系统调用
         if (!hookFileOperations()) {
             LOGE(TAG, "Failed to hook file operations");
+            markHooksReady(false);
             return false;
         }
         
         // Hook目录操作相关的系统调用
         if (!hookDirectoryOperations()) {
             LOGE(TAG, "Failed to hook directory operations");
+            markHooksReady(false);
+            return false;
+        }
+        
+        // 批量改写所有已加载镜像的GOT表
+        if (!commitPltHooks()) {
+            LOGE(TAG, "Failed to commit PLT hooks");
+            markHooksReady(false);
             return false;
         }
         
+        markHooksReady(true);
         LOGD(TAG, "System call hooks initialized successfully");
         return true;
         
     } catch (const std::exception& e) {
         LOGE(TAG, "Exception initializing system call hooks: %s", e.what());
+        markHooksReady(false);
         return false;
     }
 }
 
+bool IORelocator::installCriticalHooks() {
+    // 首次启动前的文件访问绝大多数是打开和属性查询
+    return hookOpen() && hookStat() && hookAccess() && commitPltHooks();
+}
+
+void IORelocator::installDeferredHooks(size_t first) {
+    LOGD(TAG, "Installing deferred hooks...");
+    
+    bool success = false;
+    try {
+        if (!SubstrateHook::getInstance()->initialize()) {
+            LOGE(TAG, "Failed to initialize Substrate Hook");
+        } else if (!hookUnlink() || !hookRename() || !hookReadlink() || !hookDirectoryOperations()) {
+            LOGE(TAG, "Failed to register deferred hooks");
+        } else if (!commitPltHooks(first)) {
+            LOGE(TAG, "Failed to commit deferred PLT hooks");
+        } else {
+            success = true;
+        }
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception installing deferred hooks: %s", e.what());
+    }
+    
+    markHooksReady(success);
+    LOGD(TAG, "Deferred hooks installed: %s", success ? "success" : "failed");
+}
+
 void IORelocator::cleanupSystemCallHooks() {
     try {
         LOGD(TAG, "Cleaning up system call hooks...");
         
+        // 等待后台安装结束，避免与恢复GOT表交错
+        if (mDeferredThread.joinable()) {
+            mDeferredThread.join();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mReadyMutex);
+            mHooksReady = false;
+            mHooksFailed = false;
+        }
+        
+        // seccomp过滤器无法卸载，反初始化后处理器对所有路径直接放行
+        mSeccompPending = false;
+        
+        // 恢复GOT表项
+        PltHook::getInstance()->unhookAll();
+        mPltHooks.clear();
+        mPltOriginals.clear();
+        
         // 清理Substrate Hook
-        SubstrateHook::cleanup();
+        SubstrateHook::getInstance()->cleanup();
         
         LOGD(TAG, "System call hooks cleanup completed");
         
@@ -269,6 +1668,12 @@ bool IORelocator::hookFileOperations() {
             return false;
         }
         
+        // Hook readlink系统调用
+        if (!hookReadlink()) {
+            LOGE(TAG, "Failed to hook readlink");
+            return false;
+        }
+        
         LOGD(TAG, "File operations hooked successfully");
         return true;
         
@@ -309,68 +1714,218 @@ bool IORelocator::hookDirectoryOperations() {
     }
 }
 
+bool IORelocator::registerPltHook(const char* symbol, void* replacement, void** original) {
+    // 原函数在提交时统一解析，这里只登记
+    mPltHooks.push_back({symbol, replacement});
+    mPltOriginals.push_back(original);
+    return true;
+}
+
+bool IORelocator::commitPltHooks(size_t first) {
+    // 只提交first之后新登记的表项，已改写的槽位不能再改一次，否则恢复时会记错原值
+    if (first >= mPltHooks.size()) {
+        return true;
+    }
+    
+    // 原函数直接取libc导出地址，而不是GOT中的旧值；整批在libc的哈希表中查找一次
+    std::vector<ElfResolver::SymbolRequest> requests;
+    requests.reserve(mPltHooks.size() - first);
+    for (size_t i = first; i < mPltHooks.size(); i++) {
+        requests.push_back({mPltHooks[i].symbol, nullptr});
+    }
+    ElfResolver::getInstance()->resolve("libc.so", requests.data(), requests.size());
+    
+    size_t kept = first;
+    for (size_t i = first; i < mPltHooks.size(); i++) {
+        void* address = requests[i - first].address;
+        if (address == nullptr) {
+            address = dlsym(RTLD_DEFAULT, mPltHooks[i].symbol);
+        }
+        if (address == nullptr) {
+            // 低版本系统可能没有该符号，跳过即可
+            LOGW(TAG, "Symbol not found, skip hook: %s", mPltHooks[i].symbol);
+            continue;
+        }
+        *mPltOriginals[i] = address;
+        mPltHooks[kept] = mPltHooks[i];
+        mPltOriginals[kept] = mPltOriginals[i];
+        kept++;
+    }
+    mPltHooks.resize(kept);
+    mPltOriginals.resize(kept);
+    
+    if (first >= kept) {
+        return true;
+    }
+    
+    size_t count = kept - first;
+    int patched = PltHook::getInstance()->hookAll(mPltHooks.data() + first, count);
+    if (patched < 0) {
+        return false;
+    }
+    
+    LOGD(TAG, "Installed %zu PLT hooks, %d slots patched", count, patched);
+    return true;
+}
+
 // Hook实现函数
 bool IORelocator::hookOpen() {
-    // TODO: 实现open系统调用Hook
     LOGD(TAG, "Hook open system call");
-    return true;
+    return registerPltHook("open", reinterpret_cast<void*>(newOpen), reinterpret_cast<void**>(&sOrigOpen)) &&
+           registerPltHook("open64", reinterpret_cast<void*>(newOpen64), reinterpret_cast<void**>(&sOrigOpen64)) &&
+           registerPltHook("__open_2", reinterpret_cast<void*>(newOpen2), reinterpret_cast<void**>(&sOrigOpen2)) &&
+           registerPltHook("openat", reinterpret_cast<void*>(newOpenat), reinterpret_cast<void**>(&sOrigOpenat)) &&
+           registerPltHook("openat64", reinterpret_cast<void*>(newOpenat64), reinterpret_cast<void**>(&sOrigOpenat64)) &&
+           registerPltHook("__openat_2", reinterpret_cast<void*>(newOpenat2), reinterpret_cast<void**>(&sOrigOpenat2));
 }
 
 bool IORelocator::hookStat() {
-    // TODO: 实现stat系统调用Hook
     LOGD(TAG, "Hook stat system call");
-    return true;
+    return registerPltHook("stat", reinterpret_cast<void*>(newStat), reinterpret_cast<void**>(&sOrigStat)) &&
+           registerPltHook("lstat", reinterpret_cast<void*>(newLstat), reinterpret_cast<void**>(&sOrigLstat)) &&
+           registerPltHook("fstatat", reinterpret_cast<void*>(newFstatat), reinterpret_cast<void**>(&sOrigFstatat)) &&
+           registerPltHook("stat64", reinterpret_cast<void*>(newStat64), reinterpret_cast<void**>(&sOrigStat64)) &&
+           registerPltHook("lstat64", reinterpret_cast<void*>(newLstat64), reinterpret_cast<void**>(&sOrigLstat64)) &&
+           registerPltHook("fstatat64", reinterpret_cast<void*>(newFstatat64), reinterpret_cast<void**>(&sOrigFstatat64));
 }
 
 bool IORelocator::hookAccess() {
-    // TODO: 实现access系统调用Hook
     LOGD(TAG, "Hook access system call");
-    return true;
+    return registerPltHook("access", reinterpret_cast<void*>(newAccess), reinterpret_cast<void**>(&sOrigAccess)) &&
+           registerPltHook("faccessat", reinterpret_cast<void*>(newFaccessat), reinterpret_cast<void**>(&sOrigFaccessat));
 }
 
 bool IORelocator::hookUnlink() {
-    // TODO: 实现unlink系统调用Hook
     LOGD(TAG, "Hook unlink system call");
-    return true;
+    return registerPltHook("unlink", reinterpret_cast<void*>(newUnlink), reinterpret_cast<void**>(&sOrigUnlink)) &&
+           registerPltHook("unlinkat", reinterpret_cast<void*>(newUnlinkat), reinterpret_cast<void**>(&sOrigUnlinkat));
 }
 
 bool IORelocator::hookRename() {
-    // TODO: 实现rename系统调用Hook
     LOGD(TAG, "Hook rename system call");
-    return true;
+    return registerPltHook("rename", reinterpret_cast<void*>(newRename), reinterpret_cast<void**>(&sOrigRename)) &&
+           registerPltHook("renameat", reinterpret_cast<void*>(newRenameat), reinterpret_cast<void**>(&sOrigRenameat));
+}
+
+bool IORelocator::hookReadlink() {
+    LOGD(TAG, "Hook readlink system call");
+    return registerPltHook("readlink", reinterpret_cast<void*>(newReadlink), reinterpret_cast<void**>(&sOrigReadlink)) &&
+           registerPltHook("readlinkat", reinterpret_cast<void*>(newReadlinkat), reinterpret_cast<void**>(&sOrigReadlinkat));
 }
 
 bool IORelocator::hookOpendir() {
-    // TODO: 实现opendir系统调用Hook
-    LOGD(TAG, "Hook opendir system call");
-    return true;
+    LOGD(TAG, "Hook opendir/readdir/rewinddir/closedir system calls");
+    return registerPltHook("opendir", reinterpret_cast<void*>(newOpendir), reinterpret_cast<void**>(&sOrigOpendir)) &&
+           registerPltHook("readdir", reinterpret_cast<void*>(newReaddir), reinterpret_cast<void**>(&sOrigReaddir)) &&
+           registerPltHook("readdir64", reinterpret_cast<void*>(newReaddir64), reinterpret_cast<void**>(&sOrigReaddir64)) &&
+           registerPltHook("rewinddir", reinterpret_cast<void*>(newRewinddir), reinterpret_cast<void**>(&sOrigRewinddir)) &&
+           registerPltHook("closedir", reinterpret_cast<void*>(newClosedir), reinterpret_cast<void**>(&sOrigClosedir));
 }
 
 bool IORelocator::hookMkdir() {
-    // TODO: 实现mkdir系统调用Hook
     LOGD(TAG, "Hook mkdir system call");
-    return true;
+    return registerPltHook("mkdir", reinterpret_cast<void*>(newMkdir), reinterpret_cast<void**>(&sOrigMkdir)) &&
+           registerPltHook("mkdirat", reinterpret_cast<void*>(newMkdirat), reinterpret_cast<void**>(&sOrigMkdirat));
 }
 
 bool IORelocator::hookRmdir() {
-    // TODO: 实现rmdir系统调用Hook
     LOGD(TAG, "Hook rmdir system call");
-    return true;
+    return registerPltHook("rmdir", reinterpret_cast<void*>(newRmdir), reinterpret_cast<void**>(&sOrigRmdir));
 }
 
 // JNI接口函数
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_lody_virtual_IORelocator_nativeInitialize(JNIEnv* env, jobject thiz) {
+Java_com_lody_virtual_IOUniformer_nativeInitialize(JNIEnv* env, jobject thiz) {
     return IORelocator::getInstance()->initialize();
 }
 
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeInitializePublisher(JNIEnv* env, jobject thiz) {
+    return IORelocator::getInstance()->initializePublisher();
+}
+
 extern "C" JNIEXPORT void JNICALL
-Java_com_lody_virtual_IORelocator_nativeCleanup(JNIEnv* env, jobject thiz) {
+Java_com_lody_virtual_IOUniformer_nativeCleanup(JNIEnv* env, jobject thiz) {
     IORelocator::getInstance()->cleanup();
 }
 
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_IOUniformer_nativeSetPathTable(JNIEnv* env, jobject thiz, jstring filePath, jlong configVersion) {
+    const char* path = env->GetStringUTFChars(filePath, nullptr);
+    
+    IORelocator::getInstance()->setPathTable(path, static_cast<uint64_t>(configVersion));
+    
+    env->ReleaseStringUTFChars(filePath, path);
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeIsPathTableLoaded(JNIEnv* env, jobject thiz) {
+    return IORelocator::getInstance()->isPathTableLoaded() ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeSavePathTable(JNIEnv* env, jobject thiz) {
+    return IORelocator::getInstance()->savePathTable() ? JNI_TRUE : JNI_FALSE;
+}
+
+// 以{原始路径, 虚拟路径, ...}交替排列的数组返回
+extern "C" JNIEXPORT jobjectArray JNICALL
+Java_com_lody_virtual_IOUniformer_nativeGetPathMappings(JNIEnv* env, jobject thiz) {
+    std::map<std::string, std::string> mappings = IORelocator::getInstance()->getPathMappings();
+    
+    jclass stringClass = env->FindClass("java/lang/String");
+    jobjectArray result = env->NewObjectArray(static_cast<jsize>(mappings.size() * 2), stringClass, nullptr);
+    if (result == nullptr) {
+        return nullptr;
+    }
+    
+    jsize index = 0;
+    for (const auto& mapping : mappings) {
+        jstring originalPath = env->NewStringUTF(mapping.first.c_str());
+        jstring virtualPath = env->NewStringUTF(mapping.second.c_str());
+        env->SetObjectArrayElement(result, index++, originalPath);
+        env->SetObjectArrayElement(result, index++, virtualPath);
+        env->DeleteLocalRef(originalPath);
+        env->DeleteLocalRef(virtualPath);
+    }
+    return result;
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_IOUniformer_nativeSetStagedInstall(JNIEnv* env, jobject thiz, jboolean staged) {
+    IORelocator::getInstance()->setInstallMode(staged == JNI_TRUE ? IORelocator::INSTALL_STAGED : IORelocator::INSTALL_SYNC);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_IOUniformer_nativeSetRootFdMode(JNIEnv* env, jobject thiz, jboolean enabled) {
+    IORelocator::getInstance()->setRootFdMode(enabled == JNI_TRUE);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_IOUniformer_nativeWaitForHooks(JNIEnv* env, jobject thiz, jint timeoutMs) {
+    return static_cast<jint>(IORelocator::getInstance()->waitForHooks(timeoutMs));
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeCreateSharedTable(JNIEnv* env, jobject thiz, jint slotCapacity) {
+    if (slotCapacity <= 0) {
+        return JNI_FALSE;
+    }
+    return IORelocator::getInstance()->createSharedTable(static_cast<size_t>(slotCapacity)) ? JNI_TRUE : JNI_FALSE;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_IOUniformer_nativeGetSharedTableFd(JNIEnv* env, jobject thiz) {
+    return IORelocator::getInstance()->getSharedTableFd();
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeAttachSharedTable(JNIEnv* env, jobject thiz, jint fd) {
+    return IORelocator::getInstance()->attachSharedTable(fd) ? JNI_TRUE : JNI_FALSE;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_lody_virtual_IORelocator_nativeAddPathMapping(JNIEnv* env, jobject thiz, 
+Java_com_lody_virtual_IOUniformer_nativeAddPathMapping(JNIEnv* env, jobject thiz, 
                                                       jstring originalPath, jstring virtualPath) {
     const char* origPath = env->GetStringUTFChars(originalPath, nullptr);
     const char* virtPath = env->GetStringUTFChars(virtualPath, nullptr);
@@ -383,8 +1938,100 @@ Java_com_lody_virtual_IORelocator_nativeAddPathMapping(JNIEnv* env, jobject thiz
     return result;
 }
 
+// 读取Java层传来的两个等长路径数组，直接拷贝到std::string，不经过GetStringUTFChars的临时副本
+static bool readPathMappings(JNIEnv* env, jobjectArray originalPaths, jobjectArray virtualPaths,
+                             std::vector<std::pair<std::string, std::string>>* mappings) {
+    if (originalPaths == nullptr || virtualPaths == nullptr) {
+        return false;
+    }
+    
+    jsize count = env->GetArrayLength(originalPaths);
+    if (env->GetArrayLength(virtualPaths) != count) {
+        LOGE(TAG, "Path mapping arrays differ in length");
+        return false;
+    }
+    
+    auto readString = [env](jstring str, std::string* out) {
+        jsize length = env->GetStringLength(str);
+        jsize utfLength = env->GetStringUTFLength(str);
+        // 部分实现会额外写入结尾'\0'，多留一个字节
+        out->resize(utfLength + 1);
+        env->GetStringUTFRegion(str, 0, length, &(*out)[0]);
+        out->resize(utfLength);
+    };
+    
+    mappings->resize(count);
+    for (jsize i = 0; i < count; i++) {
+        jstring original = static_cast<jstring>(env->GetObjectArrayElement(originalPaths, i));
+        jstring virtualPath = static_cast<jstring>(env->GetObjectArrayElement(virtualPaths, i));
+        if (original != nullptr && virtualPath != nullptr) {
+            readString(original, &(*mappings)[i].first);
+            readString(virtualPath, &(*mappings)[i].second);
+        }
+        env->DeleteLocalRef(original);
+        env->DeleteLocalRef(virtualPath);
+    }
+    return true;
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_IOUniformer_nativeAddPathMappings(JNIEnv* env, jobject thiz,
+                                                       jobjectArray originalPaths, jobjectArray virtualPaths) {
+    std::vector<std::pair<std::string, std::string>> mappings;
+    if (!readPathMappings(env, originalPaths, virtualPaths, &mappings)) {
+        return -1;
+    }
+    return IORelocator::getInstance()->addPathMappings(mappings);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_IOUniformer_nativeAddNamespaceMappings(JNIEnv* env, jobject thiz, jstring namespaceName,
+                                                            jobjectArray originalPaths, jobjectArray virtualPaths) {
+    std::vector<std::pair<std::string, std::string>> mappings;
+    if (namespaceName == nullptr || !readPathMappings(env, originalPaths, virtualPaths, &mappings)) {
+        return -1;
+    }
+    
+    const char* name = env->GetStringUTFChars(namespaceName, nullptr);
+    int result = IORelocator::getInstance()->addPathMappings(name, mappings);
+    env->ReleaseStringUTFChars(namespaceName, name);
+    return result;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeRemoveNamespace(JNIEnv* env, jobject thiz, jstring namespaceName) {
+    const char* name = env->GetStringUTFChars(namespaceName, nullptr);
+    bool result = IORelocator::getInstance()->removeNamespace(name);
+    env->ReleaseStringUTFChars(namespaceName, name);
+    return result;
+}
+
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeSetActiveNamespace(JNIEnv* env, jobject thiz, jstring namespaceName) {
+    const char* name = env->GetStringUTFChars(namespaceName, nullptr);
+    bool result = IORelocator::getInstance()->setActiveNamespace(name);
+    env->ReleaseStringUTFChars(namespaceName, name);
+    return result;
+}
+
+/**
+ * 为调用线程指定命名空间，传null取消
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_lody_virtual_IOUniformer_nativeSetThreadNamespace(JNIEnv* env, jobject thiz, jstring namespaceName) {
+    if (namespaceName == nullptr) {
+        IORelocator::getInstance()->clearThreadNamespace();
+        return JNI_TRUE;
+    }
+    
+    const char* name = env->GetStringUTFChars(namespaceName, nullptr);
+    bool result = IORelocator::getInstance()->setThreadNamespace(name);
+    env->ReleaseStringUTFChars(namespaceName, name);
+    return result;
+}
+
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_lody_virtual_IORelocator_nativeRemovePathMapping(JNIEnv* env, jobject thiz, jstring originalPath) {
+Java_com_lody_virtual_IOUniformer_nativeRemovePathMapping(JNIEnv* env, jobject thiz, jstring originalPath) {
     const char* origPath = env->GetStringUTFChars(originalPath, nullptr);
     
     bool result = IORelocator::getInstance()->removePathMapping(origPath);
@@ -394,15 +2041,61 @@ Java_com_lody_virtual_IORelocator_nativeRemovePathMapping(JNIEnv* env, jobject t
     return result;
 }
 
+// 未命中映射时直接返回传入的引用，Java层可用==判断，只有命中时才创建新字符串
 extern "C" JNIEXPORT jstring JNICALL
-Java_com_lody_virtual_IORelocator_nativeRedirectPath(JNIEnv* env, jobject thiz, jstring originalPath) {
-    const char* origPath = env->GetStringUTFChars(originalPath, nullptr);
+Java_com_lody_virtual_IOUniformer_nativeRedirectPath(JNIEnv* env, jobject thiz, jstring originalPath) {
+    if (originalPath == nullptr) {
+        return nullptr;
+    }
+    
+    // 拷贝到栈上缓冲区，不经过GetStringUTFChars的堆上副本
+    jsize utfLength = env->GetStringUTFLength(originalPath);
+    if (utfLength <= 0 || utfLength >= PATH_MAX) {
+        return originalPath;
+    }
+    char path[PATH_MAX];
+    env->GetStringUTFRegion(originalPath, 0, env->GetStringLength(originalPath), path);
+    path[utfLength] = '\0';
     
-    std::string redirectedPath = IORelocator::getInstance()->redirectPath(origPath);
+    char redirectedPath[PATH_MAX];
+    int length = IORelocator::getInstance()->redirectPath(path, redirectedPath, sizeof(redirectedPath));
+    if (length <= 0) {
+        return originalPath;
+    }
     
-    env->ReleaseStringUTFChars(originalPath, origPath);
+    return env->NewStringUTF(redirectedPath);
+}
+
+/**
+ * 基于直接ByteBuffer的重定向，供Java层每线程复用同一块缓冲区
+ * 缓冲区前length字节为UTF-8路径，命中时重定向结果原地写回
+ * @return 重定向后的长度；未映射时返回0；缓冲区不足时返回-1
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_IOUniformer_nativeRedirectPathBuffer(JNIEnv* env, jobject thiz, jobject buffer, jint length) {
+    char* data = static_cast<char*>(env->GetDirectBufferAddress(buffer));
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (data == nullptr || length <= 0 || length >= PATH_MAX || length > capacity) {
+        return 0;
+    }
+    
+    // 输入先拷贝出来，重定向结果会覆盖缓冲区
+    char path[PATH_MAX];
+    memcpy(path, data, length);
+    path[length] = '\0';
+    
+    size_t outCapacity = capacity < PATH_MAX ? static_cast<size_t>(capacity) : PATH_MAX;
+    return IORelocator::getInstance()->redirectPath(path, data, outCapacity);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_IOUniformer_nativeGetRedirectCacheStats(JNIEnv* env, jobject thiz, jlongArray stats) {
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    IORelocator::getInstance()->getRedirectCacheStats(&hits, &misses);
     
-    return env->NewStringUTF(redirectedPath.c_str());
+    jlong values[2] = {static_cast<jlong>(hits), static_cast<jlong>(misses)};
+    env->SetLongArrayRegion(stats, 0, 2, values);
 }
 
 } // namespace VirtualSpace 
\ No newline at end of file
@@ -4,11 +4,21 @@
 #include <string>
 #include <map>
 #include <mutex>
+#include <memory>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <utility>
 #include <jni.h>
+#include "PathTrie.h"
+#include "RcuDomain.h"
+#include "../Substrate/PltHook.h"
 
 // 前向声明
 namespace VirtualSpace {
     class SubstrateHook;
+    class SharedMappingTable;
 }
 
 namespace VirtualSpace {
@@ -19,13 +29,110 @@ namespace VirtualSpace {
  */
 class IORelocator {
 public:
+    // 系统调用拦截后端
+    enum HookBackend {
+        BACKEND_PLT = 0,        // 改写已加载镜像的GOT表
+        BACKEND_SECCOMP = 1     // seccomp-BPF过滤器 + SIGSYS处理器
+    };
+    
+    // Hook安装方式
+    enum InstallMode {
+        INSTALL_SYNC = 0,       // 全部在initialize()中同步安装
+        INSTALL_STAGED = 1      // 只同步安装首次启动必需的Hook，其余在后台线程安装
+    };
+    
+    // Hook安装状态，与IOUniformer.HOOKS_*一致
+    enum HookState {
+        HOOKS_READY = 0,        // 全部安装成功
+        HOOKS_PENDING = 1,      // 超时时仍在后台安装
+        HOOKS_FAILED = 2        // 安装失败
+    };
+    
+    // 目录中由映射产生的子项
+    struct VirtualEntry {
+        std::string name;
+        uint64_t inode;
+        uint8_t type;           // DT_*
+    };
+    
+    // 默认映射命名空间，不带命名空间参数的接口都作用于它
+    static constexpr const char* kDefaultNamespace = "";
+    
     static IORelocator* getInstance();
     
+    /**
+     * 选择系统调用拦截后端，需在initialize()之前调用，默认BACKEND_PLT
+     * BACKEND_SECCOMP安装后无法卸载，并且进程之后的exec都会以EPERM失败
+     * （Runtime.exec、ProcessBuilder等），只应为不启动其他程序的应用开启
+     * @param backend 拦截后端
+     */
+    void setHookBackend(HookBackend backend);
+    
+    /**
+     * 指定预编译映射表文件，需在initialize()之前调用
+     * initialize()会直接只读映射该文件，省去从Java层逐条重建
+     * @param filePath 映射表文件路径
+     * @param configVersion 配置版本，安装或配置变化后应随之改变
+     */
+    void setPathTable(const std::string& filePath, uint64_t configVersion);
+    
+    /**
+     * 选择Hook安装方式，需在initialize()之前调用；seccomp后端忽略该设置
+     * @param mode 安装方式
+     */
+    void setInstallMode(InstallMode mode);
+    
+    /**
+     * 开启/关闭根目录fd重定向
+     * 开启后为每个映射的虚拟根目录保持一个O_PATH目录fd，Hook中的调用改为相对该fd的*at()系统调用，
+     * 内核不再逐级解析完整的虚拟路径。虚拟根目录被删除、移走或重建后由revalidateRootFds()重新打开
+     * @param enabled 是否开启
+     */
+    void setRootFdMode(bool enabled);
+    
+    /**
+     * 重新校验根目录fd：虚拟根目录被删除、移走或重建后重新打开并发布快照
+     * 由rmdir、rename、unlinkat(AT_REMOVEDIR)的Hook在成功后调用，
+     * 经根目录fd的调用因目录已删除而失败时也会调用并按绝对路径重试
+     * @return 是否有fd被替换
+     */
+    bool revalidateRootFds();
+    
+    /**
+     * 等待全部Hook安装完成，启动虚拟应用前调用
+     * @param timeoutMs 超时时间，小于0表示一直等待
+     * @return 安装状态，超时返回HOOKS_PENDING
+     */
+    HookState waitForHooks(int timeoutMs);
+    
+    /**
+     * 初始化时是否已从映射表文件载入映射
+     */
+    bool isPathTableLoaded() const { return mPathTableLoaded; }
+    
+    /**
+     * 将当前映射写入setPathTable()指定的文件
+     * @return 是否成功
+     */
+    bool savePathTable();
+    
+    /**
+     * 获取默认命名空间的全部映射，包括从映射表文件载入的映射
+     * @return 原始路径 -> 虚拟路径
+     */
+    std::map<std::string, std::string> getPathMappings();
+    
     /**
      * 初始化IO重定向器
      */
     bool initialize();
     
+    /**
+     * 宿主进程：只载入映射并通过共享映射表发布给虚拟进程，不在本进程安装任何Hook
+     * 之后可以照常增删映射和调用createSharedTable()，cleanup()同样适用
+     */
+    bool initializePublisher();
+    
     /**
      * 清理资源
      */
@@ -33,12 +140,21 @@ public:
     
     /**
      * 添加路径映射
+     * 原始路径中的"*"组件匹配任意单个组件，虚拟路径中可用$1~$9引用，第N个"*"所匹配的组件替换$N；
+     * 同样长度的前缀上字面量映射优先于通配映射
      * @param originalPath 原始路径
      * @param virtualPath 虚拟路径
      * @return 是否成功
      */
     bool addPathMapping(const std::string& originalPath, const std::string& virtualPath);
     
+    /**
+     * 批量添加路径映射，所有映射只规范化一次、只重建并发布一次快照
+     * @param mappings 原始路径 -> 虚拟路径
+     * @return 成功添加的映射数，未初始化时返回-1
+     */
+    int addPathMappings(const std::vector<std::pair<std::string, std::string>>& mappings);
+    
     /**
      * 移除路径映射
      * @param originalPath 原始路径
@@ -46,6 +162,51 @@ public:
      */
     bool removePathMapping(const std::string& originalPath);
     
+    /**
+     * 向指定命名空间批量添加映射，命名空间不存在时创建
+     * 每个命名空间独立编译快照，修改非活动的命名空间不影响当前的重定向
+     * @param namespaceName 命名空间名，如虚拟应用包名
+     * @param mappings 原始路径 -> 虚拟路径
+     * @return 成功添加的映射数，未初始化时返回-1
+     */
+    int addPathMappings(const std::string& namespaceName,
+                        const std::vector<std::pair<std::string, std::string>>& mappings);
+    
+    /**
+     * 从指定命名空间移除路径映射
+     * @param namespaceName 命名空间名
+     * @param originalPath 原始路径
+     * @return 是否成功
+     */
+    bool removePathMapping(const std::string& namespaceName, const std::string& originalPath);
+    
+    /**
+     * 清空并停用命名空间，默认命名空间不能移除
+     * 正在使用它的线程之后不再按私有映射重定向，活动命名空间被移除时切回默认命名空间
+     * @param namespaceName 命名空间名
+     * @return 是否成功
+     */
+    bool removeNamespace(const std::string& namespaceName);
+    
+    /**
+     * 切换进程的活动命名空间，只替换指针，不重新编译
+     * @param namespaceName 命名空间名，必须已存在
+     * @return 是否成功
+     */
+    bool setActiveNamespace(const std::string& namespaceName);
+    
+    /**
+     * 为当前线程指定命名空间，优先于进程的活动命名空间
+     * @param namespaceName 命名空间名，必须已存在
+     * @return 是否成功
+     */
+    bool setThreadNamespace(const std::string& namespaceName);
+    
+    /**
+     * 取消当前线程的命名空间，回到进程的活动命名空间
+     */
+    void clearThreadNamespace();
+    
     /**
      * 重定向路径
      * @param originalPath 原始路径
@@ -53,6 +214,74 @@ public:
      */
     std::string redirectPath(const std::string& originalPath);
     
+    /**
+     * 重定向路径到调用方提供的缓冲区，整个过程不分配堆内存，
+     * 供libc Hook等不能重入malloc的场景使用
+     * @param originalPath 原始路径（以'\0'结尾）
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小（含结尾'\0'）
+     * @return 重定向后的长度；0表示无需重定向；-1表示缓冲区不足
+     */
+    int redirectPath(const char* originalPath, char* out, size_t capacity);
+    
+    /**
+     * 可在信号处理器中调用的重定向：不使用线程缓存和线程命名空间，不记录统计和日志，
+     * RCU临界区只增减原子计数，整个过程无锁、不分配内存
+     * @param originalPath 原始路径（以'\0'结尾）
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小（含结尾'\0'）
+     * @return 重定向后的长度；0表示无需重定向；-1表示缓冲区不足
+     */
+    int redirectPathSignalSafe(const char* originalPath, char* out, size_t capacity);
+    
+    /**
+     * 重定向为(目录fd, 相对路径)，供改写为*at()调用的Hook使用，同样不分配堆内存
+     * @param originalPath 原始路径（以'\0'结尾）
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小（含结尾'\0'）
+     * @param dirfd 命中已打开根目录fd的映射时输出该fd，out为相对该目录的路径；否则输出-1，out为绝对路径
+     * @return 输出路径的长度；0表示无需重定向；-1表示缓冲区不足
+     */
+    int redirectPathAt(const char* originalPath, char* out, size_t capacity, int* dirfd);
+    
+    /**
+     * 列出目录下由映射产生的虚拟子项：子路径被重定向且重定向目标存在
+     * 供readdir Hook把它们合并到真实目录的列表中；通配映射和共享映射表中的子项无法枚举
+     * @param directoryPath 目录的原始路径
+     * @param entries 输出，按名称排序
+     * @return 子项数量
+     */
+    size_t listVirtualEntries(const char* directoryPath, std::vector<VirtualEntry>* entries);
+    
+    /**
+     * 宿主进程：创建跨进程共享映射表，之后每次映射变更都会发布到共享内存
+     * @param slotCapacity 共享映射表最大字节数
+     * @return 是否成功
+     */
+    bool createSharedTable(size_t slotCapacity);
+    
+    /**
+     * 宿主进程：生成交给虚拟进程的共享映射表只读fd，由调用方负责关闭
+     * @return 文件描述符，未创建共享映射表时返回-1
+     */
+    int getSharedTableFd();
+    
+    /**
+     * 虚拟进程：映射宿主的共享映射表，重定向时与本进程的私有映射合并查找，
+     * 宿主发布的变更直接可见，无需经过JNI
+     * @param fd 宿主传来的文件描述符，成功后由共享映射表持有
+     * @return 是否成功
+     */
+    bool attachSharedTable(int fd);
+    
+    /**
+     * 获取线程重定向缓存的命中统计
+     * 各线程的计数分批汇总，可能略有滞后
+     * @param hits 命中次数输出
+     * @param misses 未命中次数输出
+     */
+    void getRedirectCacheStats(uint64_t* hits, uint64_t* misses);
+    
 private:
     IORelocator();
     ~IORelocator();
@@ -67,9 +296,69 @@ private:
     
     // 成员变量
     bool mIsInitialized;
-    std::map<std::string, std::string> mPathMappings;
+    HookBackend mHookBackend;
     std::mutex mMutex;
     
+    // 已发布的只读映射快照，读路径无锁访问
+    struct MappingSnapshot {
+        std::unique_ptr<PathTrie> trie;
+        std::vector<uint32_t> mappingIds;   // 按前缀树映射序号索引的稳定编号
+        std::vector<int> rootFds;           // 按前缀树映射序号索引的虚拟根目录fd，-1表示未打开
+        uint64_t rootFilter;                // trie->rootFilter()
+    };
+    RcuDomain mRcu;
+    
+    // 映射命名空间：各自维护映射并发布快照，对象在进程生命周期内不释放，线程局部指针始终有效
+    struct MappingNamespace {
+        std::string name;
+        std::map<std::string, std::string> mappings;
+        std::atomic<const MappingSnapshot*> snapshot;
+    };
+    std::map<std::string, std::unique_ptr<MappingNamespace>> mNamespaces;
+    MappingNamespace* mDefaultNamespace;
+    std::atomic<MappingNamespace*> mActiveNamespace;
+    static thread_local MappingNamespace* tThreadNamespace;
+    MappingNamespace* findNamespace(const std::string& name, bool create);
+    uint64_t combinedRootFilter() const;
+    bool hasMappings() const;
+    
+    // 映射代数，每次发布快照后递增，用于使线程缓存失效
+    std::atomic<uint64_t> mGeneration;
+    
+    // 本进程映射的首组件过滤器，随快照一起更新
+    std::atomic<uint64_t> mRootFilter;
+    
+    // 已映射的宿主共享映射表，只在虚拟进程中设置；其序列号计入缓存代数
+    std::atomic<SharedMappingTable*> mSharedTable;
+    
+    // 线程缓存统计
+    std::atomic<uint64_t> mCacheHits;
+    std::atomic<uint64_t> mCacheMisses;
+    void recordCacheAccess(bool hit);
+    
+    // 根目录fd：按虚拟路径缓存，正在进行的调用可能仍在使用，清理前不关闭
+    std::atomic<bool> mRootFdMode;
+    std::map<std::string, int> mRootFds;
+    std::vector<int> mRetiredRootFds;
+    void openRootFds(MappingSnapshot* snapshot, const std::map<std::string, std::string>& mappings);
+    void closeRootFds();
+    
+    // 重定向的公共实现，额外输出虚拟路径前缀长度和根目录fd
+    int redirectPathInternal(const char* originalPath, char* out, size_t capacity,
+                             size_t* virtualLength, int* rootFd);
+    
+    // 映射变更后编译并发布命名空间的新快照，trie为空时按其映射重新编译（调用方需持有mMutex）
+    void publishSnapshot(MappingNamespace* mappingNamespace, std::unique_ptr<PathTrie> trie = nullptr);
+    void clearSnapshots();
+    
+    // 预编译映射表
+    std::string mPathTableFile;
+    uint64_t mPathTableVersion;
+    bool mPathTableLoaded;
+    bool loadPathTable();
+    // 载入映射表文件，失败时发布空快照
+    void initializeMappings();
+    
     // 系统调用Hook相关
     bool initializeSystemCallHooks();
     void cleanupSystemCallHooks();
@@ -82,9 +371,31 @@ private:
     bool hookAccess();
     bool hookUnlink();
     bool hookRename();
+    bool hookReadlink();
     bool hookOpendir();
     bool hookMkdir();
     bool hookRmdir();
+    
+    // PLT Hook表，各hookXxx()只负责登记，最后统一解析原函数并批量安装
+    std::vector<PltHook::HookEntry> mPltHooks;
+    std::vector<void**> mPltOriginals;
+    bool registerPltHook(const char* symbol, void* replacement, void** original);
+    bool commitPltHooks(size_t first = 0);
+    
+    // 分阶段安装：后台线程安装其余Hook，完成后唤醒等待者
+    InstallMode mInstallMode;
+    std::thread mDeferredThread;
+    std::mutex mReadyMutex;
+    std::condition_variable mReadyCondition;
+    bool mHooksReady;
+    bool mHooksFailed;
+    bool installCriticalHooks();
+    void installDeferredHooks(size_t first);
+    void markHooksReady(bool success);
+    
+    // seccomp后端在存在映射之后才安装过滤器（调用方需持有mMutex）
+    bool mSeccompPending;
+    void installSeccompIfNeeded();
 };
 
 } // namespace VirtualSpace
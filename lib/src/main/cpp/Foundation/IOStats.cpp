@@ -0,0 +1,211 @@
+#include "IOStats.h"
+#include "IORelocator.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <jni.h>
+
+#define TAG "IOStats"
+
+namespace VirtualSpace {
+
+IOStats* IOStats::sInstance = nullptr;
+std::mutex IOStats::sMutex;
+
+// 静态存储期对象先零初始化，Hook在构造单例之前记录也是安全的
+std::atomic<bool> IOStats::sEnabled(false);
+std::atomic<uint32_t> IOStats::sNextStripe(0);
+thread_local IOStats::Stripe* IOStats::tStripe = nullptr;
+IOStats::Stripe IOStats::sStripes[IOStats::kStripes];
+IOStats::MappingSlot IOStats::sMappings[IOStats::kMappingSlots];
+std::atomic<uint64_t> IOStats::sMappingDropped(0);
+
+IOStats::IOStats() {
+    LOGD(TAG, "IOStats constructor");
+}
+
+IOStats::~IOStats() {
+    LOGD(TAG, "IOStats destructor");
+}
+
+IOStats* IOStats::getInstance() {
+    if (sInstance == nullptr) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (sInstance == nullptr) {
+            sInstance = new IOStats();
+        }
+    }
+    return sInstance;
+}
+
+void IOStats::setEnabled(bool enabled) {
+    sEnabled.store(enabled, std::memory_order_relaxed);
+    LOGD(TAG, "IO stats %s", enabled ? "enabled" : "disabled");
+}
+
+void IOStats::reset() {
+    // 与正在进行的记录并发时，少量计数可能落在清零之前或之后
+    for (Stripe& stripe : sStripes) {
+        for (auto& calls : stripe.calls) {
+            calls.store(0, std::memory_order_relaxed);
+        }
+        for (auto& latency : stripe.latency) {
+            latency.store(0, std::memory_order_relaxed);
+        }
+        stripe.lookupCount.store(0, std::memory_order_relaxed);
+        stripe.lookupTotalNs.store(0, std::memory_order_relaxed);
+    }
+
+    // 映射编号保留，只清命中数，避免与并发插入竞争槽位
+    for (MappingSlot& slot : sMappings) {
+        slot.hits.store(0, std::memory_order_relaxed);
+    }
+    sMappingDropped.store(0, std::memory_order_relaxed);
+}
+
+IOStats::Stripe& IOStats::currentStripe() {
+    // 按线程而非按CPU分配条带：arm64上sched_getcpu()是一次系统调用，比计数本身还贵
+    Stripe* stripe = tStripe;
+    if (stripe == nullptr) {
+        uint32_t index = sNextStripe.fetch_add(1, std::memory_order_relaxed);
+        stripe = &sStripes[index % kStripes];
+        tStripe = stripe;
+    }
+    return *stripe;
+}
+
+void IOStats::recordCall(uint32_t syscallId) {
+    if (syscallId >= kSyscallSlots) {
+        return;
+    }
+    currentStripe().calls[syscallId].fetch_add(1, std::memory_order_relaxed);
+}
+
+void IOStats::recordLookup(uint64_t latencyNs) {
+    Stripe& stripe = currentStripe();
+    stripe.latency[latencyBucket(latencyNs)].fetch_add(1, std::memory_order_relaxed);
+    stripe.lookupCount.fetch_add(1, std::memory_order_relaxed);
+    stripe.lookupTotalNs.fetch_add(latencyNs, std::memory_order_relaxed);
+}
+
+void IOStats::recordMappingHit(uint32_t mappingId) {
+    if (mappingId == 0) {
+        return;
+    }
+
+    // 线性探测，空槽用CAS占用；映射数远小于容量，通常第一次探测即命中
+    size_t index = mappingId & (kMappingSlots - 1);
+    for (size_t probe = 0; probe < kMappingSlots; probe++) {
+        MappingSlot& slot = sMappings[(index + probe) & (kMappingSlots - 1)];
+        uint32_t current = slot.mappingId.load(std::memory_order_acquire);
+        if (current == 0) {
+            if (slot.mappingId.compare_exchange_strong(current, mappingId, std::memory_order_acq_rel)) {
+                current = mappingId;
+            }
+        }
+        if (current == mappingId) {
+            slot.hits.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    sMappingDropped.fetch_add(1, std::memory_order_relaxed);
+}
+
+size_t IOStats::fill(int64_t* out, size_t capacity, uint64_t cacheHits, uint64_t cacheMisses) const {
+    size_t mappingCount = 0;
+    for (const MappingSlot& slot : sMappings) {
+        if (slot.mappingId.load(std::memory_order_acquire) != 0) {
+            mappingCount++;
+        }
+    }
+    size_t required = kFixedLength + mappingCount * 2;
+    if (out == nullptr || capacity < kFixedLength) {
+        return required;
+    }
+
+    uint64_t lookupCount = 0;
+    uint64_t lookupTotalNs = 0;
+    int64_t* calls = out + HEADER_FIELDS;
+    int64_t* latency = calls + kSyscallSlots;
+    for (size_t i = 0; i < kSyscallSlots; i++) {
+        calls[i] = 0;
+    }
+    for (size_t i = 0; i < kLatencyBuckets; i++) {
+        latency[i] = 0;
+    }
+    for (const Stripe& stripe : sStripes) {
+        for (size_t i = 0; i < kSyscallSlots; i++) {
+            calls[i] += static_cast<int64_t>(stripe.calls[i].load(std::memory_order_relaxed));
+        }
+        for (size_t i = 0; i < kLatencyBuckets; i++) {
+            latency[i] += static_cast<int64_t>(stripe.latency[i].load(std::memory_order_relaxed));
+        }
+        lookupCount += stripe.lookupCount.load(std::memory_order_relaxed);
+        lookupTotalNs += stripe.lookupTotalNs.load(std::memory_order_relaxed);
+    }
+
+    // 映射对写到放不下为止，两次遍历之间新增的映射下次再取
+    size_t written = 0;
+    int64_t* pairs = out + kFixedLength;
+    size_t maxPairs = (capacity - kFixedLength) / 2;
+    for (const MappingSlot& slot : sMappings) {
+        if (written >= maxPairs) {
+            break;
+        }
+        uint32_t mappingId = slot.mappingId.load(std::memory_order_acquire);
+        if (mappingId == 0) {
+            continue;
+        }
+        pairs[written * 2] = mappingId;
+        pairs[written * 2 + 1] = static_cast<int64_t>(slot.hits.load(std::memory_order_relaxed));
+        written++;
+    }
+
+    out[FIELD_VERSION] = kLayoutVersion;
+    out[FIELD_CACHE_HITS] = static_cast<int64_t>(cacheHits);
+    out[FIELD_CACHE_MISSES] = static_cast<int64_t>(cacheMisses);
+    out[FIELD_LOOKUP_COUNT] = static_cast<int64_t>(lookupCount);
+    out[FIELD_LOOKUP_TOTAL_NS] = static_cast<int64_t>(lookupTotalNs);
+    out[FIELD_MAPPING_COUNT] = static_cast<int64_t>(written);
+    out[FIELD_MAPPING_DROPPED] = static_cast<int64_t>(sMappingDropped.load(std::memory_order_relaxed));
+    return required;
+}
+
+// JNI接口函数
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_optimization_PerformanceMonitor_nativeSetIOStatsEnabled(JNIEnv* env, jobject thiz, jboolean enabled) {
+    IOStats::getInstance()->setEnabled(enabled == JNI_TRUE);
+}
+
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_optimization_PerformanceMonitor_nativeResetIOStats(JNIEnv* env, jobject thiz) {
+    IOStats::getInstance()->reset();
+}
+
+/**
+ * 把统计直接写入Java的long[]，不创建任何Java对象
+ * @return 完整写入所需的长度，大于数组长度时Java层应扩容重取
+ */
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_optimization_PerformanceMonitor_nativeGetIOStats(JNIEnv* env, jobject thiz, jlongArray stats) {
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    IORelocator::getInstance()->getRedirectCacheStats(&cacheHits, &cacheMisses);
+
+    jsize length = stats != nullptr ? env->GetArrayLength(stats) : 0;
+    if (length < static_cast<jsize>(IOStats::kFixedLength)) {
+        return static_cast<jint>(IOStats::getInstance()->fill(nullptr, 0, cacheHits, cacheMisses));
+    }
+
+    // 临界区内只做内存读写，不调用其他JNI函数
+    jlong* values = static_cast<jlong*>(env->GetPrimitiveArrayCritical(stats, nullptr));
+    if (values == nullptr) {
+        return -1;
+    }
+    static_assert(sizeof(jlong) == sizeof(int64_t), "jlong must be 64-bit");
+    size_t required = IOStats::getInstance()->fill(reinterpret_cast<int64_t*>(values), static_cast<size_t>(length),
+                                                    cacheHits, cacheMisses);
+    env->ReleasePrimitiveArrayCritical(stats, values, 0);
+    return static_cast<jint>(required);
+}
+
+} // namespace VirtualSpace
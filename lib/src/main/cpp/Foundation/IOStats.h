@@ -0,0 +1,184 @@
+#ifndef IO_STATS_H
+#define IO_STATS_H
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include "IOTracer.h"
+
+namespace VirtualSpace {
+
+/**
+ * 重定向热路径统计
+ * 累计各系统调用Hook的调用次数、路径查找耗时直方图和各映射的命中次数。
+ * 计数分散在按线程分配的条带上，Hook中只做relaxed原子加，不加锁、不分配内存；
+ * 读取时汇总所有条带，结果可能略有滞后。与IOTracer不同，统计只保留累计值，
+ * 由PerformanceMonitor通过一次JNI调用取走
+ */
+class IOStats {
+public:
+    // long[]布局版本，布局变化时递增
+    static constexpr int64_t kLayoutVersion = 1;
+
+    // 头部字段下标
+    enum HeaderField {
+        FIELD_VERSION = 0,
+        FIELD_CACHE_HITS = 1,
+        FIELD_CACHE_MISSES = 2,
+        FIELD_LOOKUP_COUNT = 3,
+        FIELD_LOOKUP_TOTAL_NS = 4,
+        FIELD_MAPPING_COUNT = 5,        // 之后写入的(映射编号, 命中次数)对数
+        FIELD_MAPPING_DROPPED = 6,      // 映射表已满而未能单独统计的命中数
+        HEADER_FIELDS = 7
+    };
+
+    // 系统调用计数按IOTracer::SyscallId索引，0号不用
+    static constexpr size_t kSyscallSlots = IOTracer::SYSCALL_RMDIR + 1;
+
+    // 耗时直方图：HDR式对数-线性分桶，每个2的幂区间再分8档，相对误差不超过12.5%，
+    // 最大到2^36ns（约68秒），更长的计入最后一档
+    static constexpr unsigned kSubBucketBits = 3;
+    static constexpr unsigned kMaxExponent = 35;
+    static constexpr size_t kLatencyBuckets = (kMaxExponent - 1) * (1u << kSubBucketBits);
+
+    // 映射命中表容量，按映射编号开放寻址
+    static constexpr size_t kMappingSlots = 256;
+
+    // 固定部分长度，其后为映射对
+    static constexpr size_t kFixedLength = HEADER_FIELDS + kSyscallSlots + kLatencyBuckets;
+
+    static IOStats* getInstance();
+
+    /**
+     * 开启/关闭统计，关闭时保留已累计的数据
+     */
+    void setEnabled(bool enabled);
+
+    static inline bool isEnabled() {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 清零所有计数
+     */
+    void reset();
+
+    /**
+     * 记录一次Hook调用
+     */
+    static void recordCall(uint32_t syscallId);
+
+    /**
+     * 记录一次路径查找（含线程缓存命中）的耗时
+     */
+    static void recordLookup(uint64_t latencyNs);
+
+    /**
+     * 记录一次映射命中
+     * @param mappingId 映射编号，与IOTracer记录中的一致
+     */
+    static void recordMappingHit(uint32_t mappingId);
+
+    /**
+     * 汇总写入long[]，不分配内存
+     * 布局：头部HEADER_FIELDS个字段，kSyscallSlots个调用计数，kLatencyBuckets个直方图计数，
+     * 然后是(映射编号, 命中次数)对，放不下的映射对被截断
+     * @param out 输出数组
+     * @param capacity 输出数组长度
+     * @param cacheHits 线程重定向缓存命中次数
+     * @param cacheMisses 线程重定向缓存未命中次数
+     * @return 完整写入所需的长度，大于capacity时调用方应扩容重取
+     */
+    size_t fill(int64_t* out, size_t capacity, uint64_t cacheHits, uint64_t cacheMisses) const;
+
+    /**
+     * 直方图分档下标
+     */
+    static inline size_t latencyBucket(uint64_t latencyNs) {
+        const uint64_t subBuckets = 1u << kSubBucketBits;
+        if (latencyNs < subBuckets) {
+            return static_cast<size_t>(latencyNs);
+        }
+        unsigned exponent = 63 - static_cast<unsigned>(__builtin_clzll(latencyNs));
+        if (exponent > kMaxExponent) {
+            return kLatencyBuckets - 1;
+        }
+        uint64_t sub = (latencyNs >> (exponent - kSubBucketBits)) & (subBuckets - 1);
+        return (exponent - kSubBucketBits + 1) * subBuckets + sub;
+    }
+
+private:
+    IOStats();
+    ~IOStats();
+
+    // 禁用拷贝构造和赋值
+    IOStats(const IOStats&) = delete;
+    IOStats& operator=(const IOStats&) = delete;
+
+    // 单例相关
+    static IOStats* sInstance;
+    static std::mutex sMutex;
+
+    // 条带：线程首次记录时轮流分配，同一条带上的线程共享缓存行
+    static constexpr size_t kStripes = 16;
+
+    struct alignas(64) Stripe {
+        std::atomic<uint64_t> calls[kSyscallSlots];
+        std::atomic<uint64_t> latency[kLatencyBuckets];
+        std::atomic<uint64_t> lookupCount;
+        std::atomic<uint64_t> lookupTotalNs;
+    };
+
+    struct MappingSlot {
+        std::atomic<uint32_t> mappingId;    // 0表示空槽
+        std::atomic<uint64_t> hits;
+    };
+
+    static Stripe& currentStripe();
+
+    static std::atomic<bool> sEnabled;
+    static std::atomic<uint32_t> sNextStripe;
+    static thread_local Stripe* tStripe;
+    static Stripe sStripes[kStripes];
+    static MappingSlot sMappings[kMappingSlots];
+    static std::atomic<uint64_t> sMappingDropped;
+};
+
+/**
+ * 查找耗时计时：构造时记下开始时间，析构时计入直方图，统计关闭时不读时钟
+ */
+class IOStatsLookupTimer {
+public:
+    IOStatsLookupTimer() : mStart(IOStats::isEnabled() ? IOTracer::now() : 0) {}
+
+    ~IOStatsLookupTimer() {
+        if (mStart != 0) {
+            IOStats::recordLookup(IOTracer::now() - mStart);
+        }
+    }
+
+    IOStatsLookupTimer(const IOStatsLookupTimer&) = delete;
+    IOStatsLookupTimer& operator=(const IOStatsLookupTimer&) = delete;
+
+private:
+    uint64_t mStart;
+};
+
+} // namespace VirtualSpace
+
+#define IO_STATS_CALL(syscallId) \
+    do { \
+        if (VirtualSpace::IOStats::isEnabled()) { \
+            VirtualSpace::IOStats::recordCall(VirtualSpace::IOTracer::syscallId); \
+        } \
+    } while (0)
+
+#define IO_STATS_MAPPING_HIT(mappingId) \
+    do { \
+        if (VirtualSpace::IOStats::isEnabled()) { \
+            VirtualSpace::IOStats::recordMappingHit(mappingId); \
+        } \
+    } while (0)
+
+#endif // IO_STATS_H
@@ -0,0 +1,238 @@
+#include "IOTracer.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <jni.h>
+#include <new>
+
+#define TAG "IOTracer"
+
+namespace VirtualSpace {
+
+IOTracer* IOTracer::sInstance = nullptr;
+std::mutex IOTracer::sMutex;
+
+std::atomic<bool> IOTracer::sEnabled(false);
+std::atomic<IOTracer::Ring*> IOTracer::sRings(nullptr);
+thread_local IOTracer::Scope* IOTracer::tCurrentScope = nullptr;
+
+namespace {
+
+// 线程退出时归还环形缓冲区
+struct RingHolder {
+    void* ring = nullptr;
+    bool released = false;
+    std::atomic<bool>* owned = nullptr;
+
+    ~RingHolder() {
+        if (owned != nullptr) {
+            owned->store(false, std::memory_order_release);
+        }
+        released = true;
+    }
+};
+
+thread_local RingHolder tRingHolder;
+
+} // namespace
+
+IOTracer::IOTracer() : mBufferDropped(0), mStopDrain(false) {
+    LOGD(TAG, "IOTracer constructor");
+}
+
+IOTracer::~IOTracer() {
+    LOGD(TAG, "IOTracer destructor");
+    setEnabled(false);
+}
+
+IOTracer* IOTracer::getInstance() {
+    if (sInstance == nullptr) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (sInstance == nullptr) {
+            sInstance = new IOTracer();
+        }
+    }
+    return sInstance;
+}
+
+void IOTracer::setEnabled(bool enabled) {
+    std::lock_guard<std::mutex> lock(mThreadMutex);
+
+    if (enabled) {
+        sEnabled.store(true, std::memory_order_relaxed);
+        if (!mDrainThread.joinable()) {
+            mStopDrain = false;
+            mDrainThread = std::thread(&IOTracer::drainLoop, this);
+        }
+        LOGD(TAG, "IO tracing enabled");
+        return;
+    }
+
+    sEnabled.store(false, std::memory_order_relaxed);
+    if (mDrainThread.joinable()) {
+        {
+            std::lock_guard<std::mutex> bufferLock(mBufferMutex);
+            mStopDrain = true;
+        }
+        mDrainCondition.notify_all();
+        mDrainThread.join();
+    }
+    collectRings();
+    LOGD(TAG, "IO tracing disabled");
+}
+
+IOTracer::Ring* IOTracer::acquireRing() {
+    RingHolder& holder = tRingHolder;
+    if (holder.ring != nullptr) {
+        return static_cast<Ring*>(holder.ring);
+    }
+    if (holder.released) {
+        return nullptr;
+    }
+
+    // 优先复用已退出线程留下的缓冲区
+    Ring* ring = sRings.load(std::memory_order_acquire);
+    for (; ring != nullptr; ring = ring->next) {
+        bool expected = false;
+        if (ring->owned.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            break;
+        }
+    }
+
+    if (ring == nullptr) {
+        ring = new (std::nothrow) Ring();
+        if (ring == nullptr) {
+            return nullptr;
+        }
+        ring->head.store(0, std::memory_order_relaxed);
+        ring->tail.store(0, std::memory_order_relaxed);
+        ring->dropped.store(0, std::memory_order_relaxed);
+        ring->owned.store(true, std::memory_order_relaxed);
+
+        // 只在表头插入，收集线程遍历时不会看到半初始化的节点
+        Ring* head = sRings.load(std::memory_order_relaxed);
+        do {
+            ring->next = head;
+        } while (!sRings.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    holder.ring = ring;
+    holder.owned = &ring->owned;
+    return ring;
+}
+
+void IOTracer::record(uint32_t syscallId, uint32_t mappingId, uint64_t pathHash, uint64_t latencyNs) {
+    Ring* ring = acquireRing();
+    if (ring == nullptr) {
+        return;
+    }
+
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t tail = ring->tail.load(std::memory_order_acquire);
+    if (head - tail >= kRingSize) {
+        ring->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record& slot = ring->records[head & (kRingSize - 1)];
+    slot.syscallId = syscallId;
+    slot.mappingId = mappingId;
+    slot.pathHash = pathHash;
+    slot.latencyNs = latencyNs;
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void IOTracer::collectRings() {
+    std::lock_guard<std::mutex> lock(mBufferMutex);
+
+    for (Ring* ring = sRings.load(std::memory_order_acquire); ring != nullptr; ring = ring->next) {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        uint32_t head = ring->head.load(std::memory_order_acquire);
+
+        for (; tail != head; tail++) {
+            if (mBuffer.size() >= kMaxBufferedRecords) {
+                mBufferDropped += head - tail;
+                tail = head;
+                break;
+            }
+            mBuffer.push_back(ring->records[tail & (kRingSize - 1)]);
+        }
+        ring->tail.store(tail, std::memory_order_release);
+        mBufferDropped += ring->dropped.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void IOTracer::drainLoop() {
+    LOGD(TAG, "Drain thread started");
+
+    std::unique_lock<std::mutex> lock(mBufferMutex);
+    while (!mStopDrain) {
+        mDrainCondition.wait_for(lock, std::chrono::milliseconds(kDrainIntervalMs));
+        if (mStopDrain) {
+            break;
+        }
+        lock.unlock();
+        collectRings();
+        lock.lock();
+    }
+
+    LOGD(TAG, "Drain thread stopped");
+}
+
+size_t IOTracer::drain(Record* out, size_t capacity) {
+    if (out == nullptr || capacity == 0) {
+        return 0;
+    }
+
+    collectRings();
+
+    std::lock_guard<std::mutex> lock(mBufferMutex);
+    size_t count = mBuffer.size() < capacity ? mBuffer.size() : capacity;
+    for (size_t i = 0; i < count; i++) {
+        out[i] = mBuffer[i];
+    }
+    mBuffer.erase(mBuffer.begin(), mBuffer.begin() + count);
+    return count;
+}
+
+uint64_t IOTracer::getDroppedCount() const {
+    std::lock_guard<std::mutex> lock(mBufferMutex);
+    return mBufferDropped;
+}
+
+// JNI接口函数
+extern "C" JNIEXPORT void JNICALL
+Java_com_lody_virtual_optimization_PerformanceMonitor_nativeSetIOTraceEnabled(JNIEnv* env, jobject thiz, jboolean enabled) {
+    IOTracer::getInstance()->setEnabled(enabled == JNI_TRUE);
+}
+
+extern "C" JNIEXPORT jint JNICALL
+Java_com_lody_virtual_optimization_PerformanceMonitor_nativeDrainIOTrace(JNIEnv* env, jobject thiz, jlongArray records) {
+    // 每条记录占4个long：syscallId, mappingId, pathHash, latencyNs
+    jsize length = env->GetArrayLength(records);
+    size_t capacity = static_cast<size_t>(length) / 4;
+    if (capacity == 0) {
+        return 0;
+    }
+
+    std::vector<IOTracer::Record> drained(capacity);
+    size_t count = IOTracer::getInstance()->drain(drained.data(), capacity);
+
+    std::vector<jlong> values(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        values[i * 4] = drained[i].syscallId;
+        values[i * 4 + 1] = drained[i].mappingId;
+        values[i * 4 + 2] = static_cast<jlong>(drained[i].pathHash);
+        values[i * 4 + 3] = static_cast<jlong>(drained[i].latencyNs);
+    }
+    if (count > 0) {
+        env->SetLongArrayRegion(records, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    return static_cast<jint>(count);
+}
+
+extern "C" JNIEXPORT jlong JNICALL
+Java_com_lody_virtual_optimization_PerformanceMonitor_nativeGetIOTraceDropped(JNIEnv* env, jobject thiz) {
+    return static_cast<jlong>(IOTracer::getInstance()->getDroppedCount());
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,195 @@
+#ifndef IO_TRACER_H
+#define IO_TRACER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+// 编译期开关：为0时追踪宏展开为空语句，Hook热路径上没有任何额外开销
+#ifndef VIRTUALSPACE_IO_TRACE
+#define VIRTUALSPACE_IO_TRACE 1
+#endif
+
+namespace VirtualSpace {
+
+/**
+ * 重定向系统调用追踪器
+ * 每个线程写入自己的无锁单生产者环形缓冲区，后台线程分批收集，
+ * 再由Java层PerformanceMonitor通过JNI取走。环满时丢弃新记录并计数
+ */
+class IOTracer {
+public:
+    // 被追踪的系统调用
+    enum SyscallId {
+        SYSCALL_OPEN = 1,
+        SYSCALL_OPENAT = 2,
+        SYSCALL_STAT = 3,
+        SYSCALL_LSTAT = 4,
+        SYSCALL_FSTATAT = 5,
+        SYSCALL_ACCESS = 6,
+        SYSCALL_FACCESSAT = 7,
+        SYSCALL_UNLINK = 8,
+        SYSCALL_UNLINKAT = 9,
+        SYSCALL_RENAME = 10,
+        SYSCALL_RENAMEAT = 11,
+        SYSCALL_READLINK = 12,
+        SYSCALL_READLINKAT = 13,
+        SYSCALL_OPENDIR = 14,
+        SYSCALL_MKDIR = 15,
+        SYSCALL_MKDIRAT = 16,
+        SYSCALL_RMDIR = 17
+    };
+
+    // 追踪记录
+    struct Record {
+        uint32_t syscallId;
+        uint32_t mappingId;     // 映射编号：原始路径前缀的FNV-1a哈希
+        uint64_t pathHash;      // 原始路径哈希
+        uint64_t latencyNs;     // 从进入Hook到原函数返回的耗时
+    };
+
+    /**
+     * 追踪范围：构造时记下开始时间，析构时若本次调用发生了重定向则写入记录
+     */
+    class Scope {
+    public:
+        explicit Scope(uint32_t syscallId)
+            : mSyscallId(syscallId), mMappingId(0), mPathHash(0), mStart(0), mRedirected(false), mPrevious(nullptr) {
+            if (isEnabled()) {
+                mStart = now();
+                mPrevious = tCurrentScope;
+                tCurrentScope = this;
+            }
+        }
+
+        ~Scope() {
+            if (mStart == 0) {
+                return;
+            }
+            tCurrentScope = mPrevious;
+            if (mRedirected) {
+                record(mSyscallId, mMappingId, mPathHash, now() - mStart);
+            }
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        friend class IOTracer;
+
+        uint32_t mSyscallId;
+        uint32_t mMappingId;
+        uint64_t mPathHash;
+        uint64_t mStart;
+        bool mRedirected;
+        Scope* mPrevious;
+    };
+
+    static IOTracer* getInstance();
+
+    /**
+     * 开启/关闭追踪，开启时启动后台收集线程
+     */
+    void setEnabled(bool enabled);
+
+    static inline bool isEnabled() {
+        return sEnabled.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 标注当前追踪范围命中的映射，由redirectPath调用
+     */
+    static inline void annotate(uint64_t pathHash, uint32_t mappingId) {
+        Scope* scope = tCurrentScope;
+        if (scope != nullptr) {
+            scope->mPathHash = pathHash;
+            scope->mMappingId = mappingId;
+            scope->mRedirected = true;
+        }
+    }
+
+    /**
+     * 写入当前线程的环形缓冲区，不加锁、不分配内存（线程首次写入除外）
+     */
+    static void record(uint32_t syscallId, uint32_t mappingId, uint64_t pathHash, uint64_t latencyNs);
+
+    /**
+     * 取出已收集的记录
+     * @param out 输出数组
+     * @param capacity 最多取出的条数
+     * @return 实际取出的条数
+     */
+    size_t drain(Record* out, size_t capacity);
+
+    /**
+     * 因缓冲区满而丢弃的记录数
+     */
+    uint64_t getDroppedCount() const;
+
+    static inline uint64_t now() {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+    }
+
+private:
+    IOTracer();
+    ~IOTracer();
+
+    // 禁用拷贝构造和赋值
+    IOTracer(const IOTracer&) = delete;
+    IOTracer& operator=(const IOTracer&) = delete;
+
+    // 单例相关
+    static IOTracer* sInstance;
+    static std::mutex sMutex;
+
+    // 每线程环形缓冲区，线程退出后留给新线程复用，不释放
+    static constexpr uint32_t kRingSize = 1024;
+    static constexpr size_t kMaxBufferedRecords = 64 * 1024;
+    static constexpr int kDrainIntervalMs = 200;
+
+    struct Ring {
+        alignas(64) std::atomic<uint32_t> head;     // 生产者写入位置
+        alignas(64) std::atomic<uint32_t> tail;     // 收集线程读取位置
+        std::atomic<uint64_t> dropped;
+        std::atomic<bool> owned;
+        Ring* next;
+        Record records[kRingSize];
+    };
+
+    static Ring* acquireRing();
+    void collectRings();
+    void drainLoop();
+
+    static std::atomic<bool> sEnabled;
+    static std::atomic<Ring*> sRings;
+    static thread_local Scope* tCurrentScope;
+
+    mutable std::mutex mBufferMutex;
+    std::vector<Record> mBuffer;
+    uint64_t mBufferDropped;
+
+    std::mutex mThreadMutex;
+    std::condition_variable mDrainCondition;
+    std::thread mDrainThread;
+    bool mStopDrain;
+};
+
+} // namespace VirtualSpace
+
+#if VIRTUALSPACE_IO_TRACE
+#define IO_TRACE_SCOPE(syscallId) VirtualSpace::IOTracer::Scope ioTraceScope(VirtualSpace::IOTracer::syscallId)
+#define IO_TRACE_ANNOTATE(pathHash, mappingId) VirtualSpace::IOTracer::annotate(pathHash, mappingId)
+#else
+#define IO_TRACE_SCOPE(syscallId) do {} while (0)
+#define IO_TRACE_ANNOTATE(pathHash, mappingId) do {} while (0)
+#endif
+
+#endif // IO_TRACER_H
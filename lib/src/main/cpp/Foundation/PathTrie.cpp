@@ -0,0 +1,634 @@
+#include "PathTrie.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#define TAG "PathTrie"
+
+namespace VirtualSpace {
+
+namespace {
+
+constexpr uint32_t kTableMagic = 0x54505356;    // "VSPT"
+constexpr uint32_t kTableFormatVersion = 2;
+constexpr size_t kMaxCaptures = 9;
+
+// 构建期使用的临时节点（非确定），std::map保证子节点按标签有序
+struct BuildNode {
+    std::map<std::string, std::unique_ptr<BuildNode>> children;
+    std::unique_ptr<BuildNode> wildcard;
+    int32_t mapping = -1;
+    uint32_t wildcards = 0;     // 从根到该节点经过的通配边数
+};
+
+// 虚拟路径是否引用了通配组件（$1~$9）
+bool hasCaptureReference(const std::string& target) {
+    for (size_t i = 0; i + 1 < target.length(); i++) {
+        if (target[i] == '$' && target[i + 1] >= '1' && target[i + 1] <= '9') {
+            return true;
+        }
+    }
+    return false;
+}
+
+int compareLabel(const char* a, size_t aLength, const char* b, size_t bLength) {
+    int result = memcmp(a, b, std::min(aLength, bLength));
+    if (result != 0) {
+        return result;
+    }
+    if (aLength == bLength) {
+        return 0;
+    }
+    return aLength < bLength ? -1 : 1;
+}
+
+uint32_t checksum(const char* data, size_t length) {
+    // FNV-1a
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= static_cast<uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+bool writeFully(int fd, const char* data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(fd, data, length);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+} // namespace
+
+PathTrie::PathTrie()
+    : mNodeData(nullptr), mEdgeData(nullptr), mMappingData(nullptr), mPoolData(nullptr),
+      mNodeCount(0), mEdgeCount(0), mMappingCount(0), mPoolSize(0), mMapBase(nullptr), mMapSize(0) {
+}
+
+PathTrie::~PathTrie() {
+    if (mMapBase != nullptr) {
+        munmap(mMapBase, mMapSize);
+    }
+}
+
+std::unique_ptr<PathTrie> PathTrie::build(const std::map<std::string, std::string>& mappings) {
+    std::unique_ptr<PathTrie> trie(new PathTrie());
+
+    // 按路径组件插入临时树，"*"组件单独挂在通配边上
+    BuildNode root;
+    for (const auto& mapping : mappings) {
+        const std::string& original = mapping.first;
+        const std::string& target = mapping.second;
+
+        BuildNode* node = &root;
+        uint32_t wildcards = 0;
+        size_t pos = 0;
+        while (pos < original.length()) {
+            size_t end = original.find('/', pos);
+            if (end == std::string::npos) {
+                end = original.length();
+            }
+            if (end > pos) {
+                bool wildcard = end - pos == 1 && original[pos] == '*';
+                std::unique_ptr<BuildNode>& child = wildcard ? node->wildcard
+                                                             : node->children[original.substr(pos, end - pos)];
+                if (wildcard) {
+                    wildcards++;
+                }
+                if (!child) {
+                    child.reset(new BuildNode());
+                    child->wildcards = wildcards;
+                }
+                node = child.get();
+            }
+            pos = end + 1;
+        }
+
+        Mapping entry;
+        entry.originalOffset = trie->addString(original.data(), original.length());
+        entry.originalLength = static_cast<uint32_t>(original.length());
+        entry.virtualOffset = trie->addString(target.data(), target.length());
+        entry.virtualLength = static_cast<uint32_t>(target.length());
+        entry.flags = (wildcards > 0 && hasCaptureReference(target)) ? kMappingCaptures : 0;
+        node->mapping = static_cast<int32_t>(trie->mMappings.size());
+        trie->mMappings.push_back(entry);
+    }
+
+    // 子集构造：每个状态是同一深度上的一组临时节点，按层展开，每个节点的子边连续存放
+    typedef std::vector<const BuildNode*> State;
+    std::map<State, uint32_t> stateIds;
+    std::vector<State> states;
+    auto stateOf = [&stateIds, &states](State state) {
+        std::sort(state.begin(), state.end());
+        state.erase(std::unique(state.begin(), state.end()), state.end());
+        auto it = stateIds.find(state);
+        if (it != stateIds.end()) {
+            return it->second;
+        }
+        uint32_t id = static_cast<uint32_t>(states.size());
+        stateIds.emplace(state, id);
+        states.push_back(std::move(state));
+        return id;
+    };
+    stateOf(State(1, &root));
+
+    for (size_t i = 0; i < states.size(); i++) {
+        // stateOf()会向states追加，先拷贝出来
+        State state = states[i];
+
+        Node node;
+        node.mapping = -1;
+        uint32_t bestWildcards = 0;
+        State wildcardState;
+        std::map<std::string, State> transitions;
+        for (const BuildNode* member : state) {
+            // 同一深度上经过的通配边越少越具体，再按映射序号
+            if (member->mapping >= 0 &&
+                (node.mapping < 0 || member->wildcards < bestWildcards ||
+                 (member->wildcards == bestWildcards && member->mapping < node.mapping))) {
+                node.mapping = member->mapping;
+                bestWildcards = member->wildcards;
+            }
+            if (member->wildcard) {
+                wildcardState.push_back(member->wildcard.get());
+            }
+            for (const auto& child : member->children) {
+                transitions[child.first].push_back(child.second.get());
+            }
+        }
+
+        // 字面量组件同样可以被通配边接受
+        for (auto& transition : transitions) {
+            transition.second.insert(transition.second.end(), wildcardState.begin(), wildcardState.end());
+        }
+
+        node.wildcardChild = wildcardState.empty() ? kNoChild : stateOf(wildcardState);
+        node.firstEdge = static_cast<uint32_t>(trie->mEdges.size());
+        node.edgeCount = static_cast<uint32_t>(transitions.size());
+        for (auto& transition : transitions) {
+            Edge edge;
+            edge.labelOffset = trie->addString(transition.first.data(), transition.first.length());
+            edge.labelLength = static_cast<uint32_t>(transition.first.length());
+            edge.child = stateOf(std::move(transition.second));
+            trie->mEdges.push_back(edge);
+        }
+        trie->mNodes.push_back(node);
+    }
+
+    trie->bindStorage();
+    return trie;
+}
+
+std::unique_ptr<PathTrie> PathTrie::map(const std::string& filePath, uint64_t configVersion) {
+    int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return nullptr;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(TableHeader))) {
+        close(fd);
+        return nullptr;
+    }
+
+    // 私有只读映射：各进程共享页缓存，fork出的虚拟进程直接继承
+    size_t mapSize = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, mapSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        LOGW(TAG, "Failed to map path table %s: %s", filePath.c_str(), strerror(errno));
+        return nullptr;
+    }
+
+    std::unique_ptr<PathTrie> trie(new PathTrie());
+    trie->mMapBase = base;
+    trie->mMapSize = mapSize;
+
+    const TableHeader* header = static_cast<const TableHeader*>(base);
+    if (header->configVersion != configVersion) {
+        LOGD(TAG, "Path table is stale: %s", filePath.c_str());
+        return nullptr;
+    }
+    if (!trie->attach(base, mapSize)) {
+        LOGW(TAG, "Invalid path table: %s", filePath.c_str());
+        return nullptr;
+    }
+
+    const char* payload = static_cast<const char*>(base) + sizeof(TableHeader);
+    if (checksum(payload, mapSize - sizeof(TableHeader)) != header->checksum) {
+        LOGW(TAG, "Path table checksum mismatch: %s", filePath.c_str());
+        return nullptr;
+    }
+
+    // 校验和只防损坏，下标在载入时再整体检查一遍
+    if (!trie->validate()) {
+        LOGW(TAG, "Path table is inconsistent: %s", filePath.c_str());
+        return nullptr;
+    }
+
+    return trie;
+}
+
+bool PathTrie::writeTo(const std::string& filePath, uint64_t configVersion) const {
+    std::string table(serializedSize(), '\0');
+    serialize(&table[0], table.size(), configVersion);
+
+    // 宿主和虚拟进程可能同时保存，临时文件按进程和线程区分，各自写完后再原子替换
+    std::string tempPath = filePath + "." + std::to_string(getpid()) + "." + std::to_string(gettid()) + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        LOGE(TAG, "Failed to create path table %s: %s", tempPath.c_str(), strerror(errno));
+        return false;
+    }
+
+    bool success = writeFully(fd, table.data(), table.size()) && fsync(fd) == 0;
+    close(fd);
+
+    if (!success || rename(tempPath.c_str(), filePath.c_str()) != 0) {
+        LOGE(TAG, "Failed to write path table %s: %s", filePath.c_str(), strerror(errno));
+        unlink(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+size_t PathTrie::serializedSize() const {
+    return sizeof(TableHeader) + mNodeCount * sizeof(Node) + mEdgeCount * sizeof(Edge) +
+           mMappingCount * sizeof(Mapping) + mPoolSize;
+}
+
+size_t PathTrie::serialize(void* out, size_t capacity, uint64_t configVersion) const {
+    size_t size = serializedSize();
+    if (out == nullptr || capacity < size) {
+        return 0;
+    }
+
+    char* payload = static_cast<char*>(out) + sizeof(TableHeader);
+    char* cursor = payload;
+    memcpy(cursor, mNodeData, mNodeCount * sizeof(Node));
+    cursor += mNodeCount * sizeof(Node);
+    memcpy(cursor, mEdgeData, mEdgeCount * sizeof(Edge));
+    cursor += mEdgeCount * sizeof(Edge);
+    memcpy(cursor, mMappingData, mMappingCount * sizeof(Mapping));
+    cursor += mMappingCount * sizeof(Mapping);
+    memcpy(cursor, mPoolData, mPoolSize);
+
+    TableHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = kTableMagic;
+    header.formatVersion = kTableFormatVersion;
+    header.configVersion = configVersion;
+    header.nodeCount = mNodeCount;
+    header.edgeCount = mEdgeCount;
+    header.mappingCount = mMappingCount;
+    header.poolSize = mPoolSize;
+    header.checksum = checksum(payload, size - sizeof(TableHeader));
+    memcpy(out, &header, sizeof(header));
+    return size;
+}
+
+bool PathTrie::findInTable(const void* table, size_t size, const char* path, size_t length, Match* match) {
+    // 栈上的视图只指向外部内存，不持有也不分配任何存储
+    PathTrie view;
+    if (!view.attach(table, size)) {
+        return false;
+    }
+    return view.findLongestPrefix(path, length, match);
+}
+
+bool PathTrie::getMapping(size_t index, std::string* originalPath, std::string* virtualPath) const {
+    if (index >= mMappingCount) {
+        return false;
+    }
+    const Mapping& mapping = mMappingData[index];
+    originalPath->assign(mPoolData + mapping.originalOffset, mapping.originalLength);
+    virtualPath->assign(mPoolData + mapping.virtualOffset, mapping.virtualLength);
+    return true;
+}
+
+bool PathTrie::findLongestPrefix(const char* path, size_t length, Match* match) const {
+    if (path == nullptr || length == 0 || path[0] != '/') {
+        return false;
+    }
+
+    const Node* node = &mNodeData[0];
+    int32_t bestMapping = node->mapping;
+    size_t bestLength = (length == 1) ? 1 : 0;
+
+    size_t pos = 0;
+    while (pos < length) {
+        while (pos < length && path[pos] == '/') {
+            pos++;
+        }
+        if (pos >= length) {
+            break;
+        }
+
+        size_t start = pos;
+        while (pos < length && path[pos] != '/') {
+            pos++;
+        }
+
+        // 字面量边的目标状态已包含通配边，找不到时才走通配边
+        const Edge* edge = findEdge(*node, path + start, pos - start);
+        uint32_t child = edge != nullptr ? edge->child : node->wildcardChild;
+
+        // 越界判断只比较已载入的计数，映射文件或共享内存被改写时也不会越界访问
+        if (child >= mNodeCount) {
+            break;
+        }
+        node = &mNodeData[child];
+        if (node->mapping >= 0 && static_cast<uint32_t>(node->mapping) < mMappingCount) {
+            bestMapping = node->mapping;
+            bestLength = pos;
+        }
+    }
+
+    if (bestMapping < 0 || static_cast<uint32_t>(bestMapping) >= mMappingCount) {
+        return false;
+    }
+
+    const Mapping& mapping = mMappingData[bestMapping];
+    if (mapping.virtualOffset > mPoolSize || mapping.virtualLength > mPoolSize - mapping.virtualOffset ||
+        mapping.originalOffset > mPoolSize || mapping.originalLength > mPoolSize - mapping.originalOffset) {
+        return false;
+    }
+    match->virtualPath = mPoolData + mapping.virtualOffset;
+    match->virtualLength = mapping.virtualLength;
+    match->prefixLength = bestLength;
+    match->mappingIndex = bestMapping;
+    match->pattern = mPoolData + mapping.originalOffset;
+    match->patternLength = mapping.originalLength;
+    match->captures = (mapping.flags & kMappingCaptures) != 0;
+    return true;
+}
+
+int PathTrie::rewrite(const Match& match, const char* path, size_t length, char* out, size_t capacity) {
+    size_t suffixLength = length - match.prefixLength;
+    if (!match.captures) {
+        size_t redirectedLength = match.virtualLength + suffixLength;
+        if (redirectedLength + 1 > capacity) {
+            return -1;
+        }
+        memcpy(out, match.virtualPath, match.virtualLength);
+        memcpy(out + match.virtualLength, path + match.prefixLength, suffixLength);
+        out[redirectedLength] = '\0';
+        return static_cast<int>(redirectedLength);
+    }
+
+    // 按组件对齐模式和被匹配的前缀，依次取出通配组件
+    const char* captures[kMaxCaptures];
+    size_t captureLengths[kMaxCaptures];
+    size_t captureCount = 0;
+    size_t patternPos = 0;
+    size_t pathPos = 0;
+    while (captureCount < kMaxCaptures) {
+        while (patternPos < match.patternLength && match.pattern[patternPos] == '/') {
+            patternPos++;
+        }
+        while (pathPos < match.prefixLength && path[pathPos] == '/') {
+            pathPos++;
+        }
+        if (patternPos >= match.patternLength || pathPos >= match.prefixLength) {
+            break;
+        }
+
+        size_t patternStart = patternPos;
+        while (patternPos < match.patternLength && match.pattern[patternPos] != '/') {
+            patternPos++;
+        }
+        size_t pathStart = pathPos;
+        while (pathPos < match.prefixLength && path[pathPos] != '/') {
+            pathPos++;
+        }
+        if (patternPos - patternStart == 1 && match.pattern[patternStart] == '*') {
+            captures[captureCount] = path + pathStart;
+            captureLengths[captureCount] = pathPos - pathStart;
+            captureCount++;
+        }
+    }
+
+    // 展开虚拟路径中的$N，引用不存在的组件时按原样输出
+    size_t written = 0;
+    for (size_t i = 0; i < match.virtualLength; i++) {
+        char c = match.virtualPath[i];
+        if (c == '$' && i + 1 < match.virtualLength && match.virtualPath[i + 1] >= '1' &&
+            match.virtualPath[i + 1] <= '9') {
+            size_t index = static_cast<size_t>(match.virtualPath[i + 1] - '1');
+            if (index < captureCount) {
+                if (written + captureLengths[index] >= capacity) {
+                    return -1;
+                }
+                memcpy(out + written, captures[index], captureLengths[index]);
+                written += captureLengths[index];
+                i++;
+                continue;
+            }
+        }
+        if (written + 1 >= capacity) {
+            return -1;
+        }
+        out[written++] = c;
+    }
+
+    if (written + suffixLength + 1 > capacity) {
+        return -1;
+    }
+    memcpy(out + written, path + match.prefixLength, suffixLength);
+    written += suffixLength;
+    out[written] = '\0';
+    return static_cast<int>(written);
+}
+
+bool PathTrie::listChildren(const char* path, size_t length, std::vector<Child>* children) const {
+    if (path == nullptr || length == 0 || path[0] != '/' || mNodeCount == 0) {
+        return false;
+    }
+
+    // 与findLongestPrefix()相同的遍历，但要求整条路径都有对应节点
+    const Node* node = &mNodeData[0];
+    size_t pos = 0;
+    while (pos < length) {
+        while (pos < length && path[pos] == '/') {
+            pos++;
+        }
+        if (pos >= length) {
+            break;
+        }
+
+        size_t start = pos;
+        while (pos < length && path[pos] != '/') {
+            pos++;
+        }
+
+        const Edge* edge = findEdge(*node, path + start, pos - start);
+        uint32_t child = edge != nullptr ? edge->child : node->wildcardChild;
+        if (child >= mNodeCount) {
+            return false;
+        }
+        node = &mNodeData[child];
+    }
+
+    if (node->firstEdge > mEdgeCount || node->edgeCount > mEdgeCount - node->firstEdge) {
+        return false;
+    }
+    for (uint32_t i = node->firstEdge; i < node->firstEdge + node->edgeCount; i++) {
+        const Edge& edge = mEdgeData[i];
+        if (edge.labelOffset > mPoolSize || edge.labelLength > mPoolSize - edge.labelOffset) {
+            return false;
+        }
+        children->push_back({mPoolData + edge.labelOffset, edge.labelLength});
+    }
+    return true;
+}
+
+uint64_t PathTrie::rootFilter() const {
+    if (mNodeCount == 0) {
+        return 0;
+    }
+
+    const Node& root = mNodeData[0];
+    if (root.mapping >= 0 || root.wildcardChild != kNoChild) {
+        return ~0ULL;
+    }
+    if (root.firstEdge > mEdgeCount || root.edgeCount > mEdgeCount - root.firstEdge) {
+        return ~0ULL;
+    }
+
+    uint64_t filter = 0;
+    for (uint32_t i = root.firstEdge; i < root.firstEdge + root.edgeCount; i++) {
+        const Edge& edge = mEdgeData[i];
+        if (edge.labelOffset > mPoolSize || edge.labelLength > mPoolSize - edge.labelOffset) {
+            return ~0ULL;
+        }
+        filter |= componentFilterBits(mPoolData + edge.labelOffset, edge.labelLength);
+    }
+    return filter;
+}
+
+const PathTrie::Edge* PathTrie::findEdge(const Node& node, const char* label, size_t length) const {
+    if (node.firstEdge > mEdgeCount || node.edgeCount > mEdgeCount - node.firstEdge) {
+        return nullptr;
+    }
+
+    // 子边按标签有序，二分查找
+    size_t low = node.firstEdge;
+    size_t high = node.firstEdge + node.edgeCount;
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        const Edge& edge = mEdgeData[mid];
+        if (edge.labelOffset > mPoolSize || edge.labelLength > mPoolSize - edge.labelOffset) {
+            return nullptr;
+        }
+        int result = compareLabel(label, length, mPoolData + edge.labelOffset, edge.labelLength);
+        if (result == 0) {
+            return &edge;
+        }
+        if (result < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+void PathTrie::bindStorage() {
+    mNodeData = mNodes.data();
+    mEdgeData = mEdges.data();
+    mMappingData = mMappings.data();
+    mPoolData = mPool.data();
+    mNodeCount = static_cast<uint32_t>(mNodes.size());
+    mEdgeCount = static_cast<uint32_t>(mEdges.size());
+    mMappingCount = static_cast<uint32_t>(mMappings.size());
+    mPoolSize = static_cast<uint32_t>(mPool.size());
+}
+
+bool PathTrie::attach(const void* data, size_t size) {
+    if (data == nullptr || size < sizeof(TableHeader)) {
+        return false;
+    }
+
+    // 头部先拷贝出来，内存被并发改写时也只按同一份计数计算边界
+    TableHeader header;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != kTableMagic || header.formatVersion != kTableFormatVersion) {
+        return false;
+    }
+
+    uint64_t expectedSize = sizeof(TableHeader) +
+                            static_cast<uint64_t>(header.nodeCount) * sizeof(Node) +
+                            static_cast<uint64_t>(header.edgeCount) * sizeof(Edge) +
+                            static_cast<uint64_t>(header.mappingCount) * sizeof(Mapping) +
+                            header.poolSize;
+    if (header.nodeCount == 0 || expectedSize > size) {
+        return false;
+    }
+
+    const char* payload = static_cast<const char*>(data) + sizeof(TableHeader);
+    mNodeCount = header.nodeCount;
+    mEdgeCount = header.edgeCount;
+    mMappingCount = header.mappingCount;
+    mPoolSize = header.poolSize;
+    mNodeData = reinterpret_cast<const Node*>(payload);
+    mEdgeData = reinterpret_cast<const Edge*>(mNodeData + mNodeCount);
+    mMappingData = reinterpret_cast<const Mapping*>(mEdgeData + mEdgeCount);
+    mPoolData = reinterpret_cast<const char*>(mMappingData + mMappingCount);
+    return true;
+}
+
+bool PathTrie::validate() const {
+    auto inPool = [this](uint32_t offset, uint32_t length) {
+        return offset <= mPoolSize && length <= mPoolSize - offset;
+    };
+
+    for (uint32_t i = 0; i < mNodeCount; i++) {
+        const Node& node = mNodeData[i];
+        if (node.firstEdge > mEdgeCount || node.edgeCount > mEdgeCount - node.firstEdge) {
+            return false;
+        }
+        if (node.mapping >= 0 && static_cast<uint32_t>(node.mapping) >= mMappingCount) {
+            return false;
+        }
+        if (node.wildcardChild != kNoChild && node.wildcardChild >= mNodeCount) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < mEdgeCount; i++) {
+        const Edge& edge = mEdgeData[i];
+        if (edge.child >= mNodeCount || !inPool(edge.labelOffset, edge.labelLength)) {
+            return false;
+        }
+    }
+    for (uint32_t i = 0; i < mMappingCount; i++) {
+        const Mapping& mapping = mMappingData[i];
+        if (!inPool(mapping.originalOffset, mapping.originalLength) ||
+            !inPool(mapping.virtualOffset, mapping.virtualLength)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t PathTrie::addString(const char* str, size_t length) {
+    uint32_t offset = static_cast<uint32_t>(mPool.size());
+    mPool.append(str, length);
+    return offset;
+}
+
+} // namespace VirtualSpace
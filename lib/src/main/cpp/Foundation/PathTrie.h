@@ -0,0 +1,220 @@
+#ifndef PATH_TRIE_H
+#define PATH_TRIE_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * 路径组件前缀树
+ * 以'/'切分的路径组件为边，编译为只读的扁平数组，
+ * 一次遍历即可找到最长前缀映射，且只在组件边界上匹配。
+ * 原始路径中单独的"*"组件匹配任意一个组件，虚拟路径中的$1~$9依次引用这些组件。
+ * 编译时按组件做子集构造，字面量边和通配边合并为确定的状态机，
+ * 查找仍是一次遍历，与通配映射的数量无关；同一长度上字面量映射优先。
+ * 扁平数组可原样写入文件，之后直接只读mmap使用，无需重新编译
+ */
+class PathTrie {
+public:
+    // 匹配结果
+    struct Match {
+        const char* virtualPath;    // 虚拟路径（不以'\0'结尾）
+        size_t virtualLength;       // 虚拟路径长度
+        size_t prefixLength;        // 原始路径中被匹配的前缀长度
+        int32_t mappingIndex;       // 映射序号
+        const char* pattern;        // 映射的原始路径（不以'\0'结尾）
+        size_t patternLength;
+        bool captures;              // 虚拟路径引用了通配组件，需经rewrite()展开
+    };
+
+    /**
+     * 从规范化后的映射表编译前缀树
+     * @param mappings 原始路径 -> 虚拟路径
+     * @return 编译结果
+     */
+    static std::unique_ptr<PathTrie> build(const std::map<std::string, std::string>& mappings);
+
+    /**
+     * 只读映射预编译的映射表文件，数组直接指向映射内存
+     * @param filePath 由writeTo()生成的文件
+     * @param configVersion 期望的配置版本，与文件记录的不一致时视为过期
+     * @return 映射结果，文件不存在、过期或校验失败时返回nullptr
+     */
+    static std::unique_ptr<PathTrie> map(const std::string& filePath, uint64_t configVersion);
+
+    ~PathTrie();
+
+    // 禁用拷贝构造和赋值，数组指针指向自身存储
+    PathTrie(const PathTrie&) = delete;
+    PathTrie& operator=(const PathTrie&) = delete;
+
+    /**
+     * 写入可直接mmap的映射表文件，先写临时文件再rename，读者不会看到半写的文件
+     * @param filePath 目标文件
+     * @param configVersion 配置版本
+     * @return 是否成功
+     */
+    bool writeTo(const std::string& filePath, uint64_t configVersion) const;
+
+    /**
+     * 序列化后的字节数，与writeTo()写入的文件大小一致
+     */
+    size_t serializedSize() const;
+
+    /**
+     * 序列化到调用方提供的内存，格式与writeTo()相同
+     * @return 写入的字节数，空间不足时返回0
+     */
+    size_t serialize(void* out, size_t capacity, uint64_t configVersion) const;
+
+    /**
+     * 直接在序列化后的内存上查找，不分配内存、不做校验和检查。
+     * 所有下标都做越界判断，内存被并发改写时结果无意义但不会越界访问，
+     * 调用方需自行判断内容是否一致（如共享内存的序列锁）
+     */
+    static bool findInTable(const void* table, size_t size, const char* path, size_t length, Match* match);
+
+    /**
+     * 按匹配结果写出重定向后的路径：虚拟路径（展开$N引用）+ 未匹配的后缀
+     * 只依赖match和path，可用于findInTable()的结果
+     * @param match 对path的匹配结果
+     * @param path 规范化后的绝对路径
+     * @param length 路径长度
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小（含结尾'\0'）
+     * @return 输出长度，缓冲区不足时返回-1
+     */
+    static int rewrite(const Match& match, const char* path, size_t length, char* out, size_t capacity);
+
+    /**
+     * 查找最长前缀映射
+     * @param path 规范化后的绝对路径
+     * @param length 路径长度
+     * @param match 匹配结果输出
+     * @return 是否找到映射
+     */
+    bool findLongestPrefix(const char* path, size_t length, Match* match) const;
+
+    // 子组件，标签指向字符串池，不以'\0'结尾
+    struct Child {
+        const char* label;
+        size_t length;
+    };
+
+    /**
+     * 列出目录在树中的字面量子组件，即映射原始路径中紧跟在该目录之后的组件
+     * 通配组件无法枚举，不包含在内
+     * @param path 规范化后的绝对路径
+     * @param length 路径长度
+     * @param children 输出，按标签排序
+     * @return 目录在树中是否有对应节点
+     */
+    bool listChildren(const char* path, size_t length, std::vector<Child>* children) const;
+
+    /**
+     * 路径组件的过滤位，每个组件置两位
+     */
+    static inline uint64_t componentFilterBits(const char* label, size_t length) {
+        // FNV-1a
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= static_cast<uint8_t>(label[i]);
+            hash *= 16777619u;
+        }
+        return (1ULL << (hash & 63)) | (1ULL << ((hash >> 6) & 63));
+    }
+
+    /**
+     * 首组件过滤器：根节点各子边过滤位的并集，根路径本身有映射时全部置位。
+     * 首组件的过滤位不全在其中的路径一定不会匹配任何映射
+     */
+    uint64_t rootFilter() const;
+
+    /**
+     * 映射数量
+     */
+    size_t size() const { return mMappingCount; }
+
+    /**
+     * 按映射序号取出映射，序号与build()时std::map的遍历顺序一致
+     * @return 序号是否有效
+     */
+    bool getMapping(size_t index, std::string* originalPath, std::string* virtualPath) const;
+
+private:
+    PathTrie();
+
+    // 节点：子边在mEdges中连续存放并按标签排序，没有匹配的字面量边时走通配边
+    struct Node {
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+        int32_t mapping;
+        uint32_t wildcardChild;     // kNoChild表示没有通配边
+    };
+
+    static constexpr uint32_t kNoChild = 0xffffffffu;
+    static constexpr uint32_t kMappingCaptures = 1;
+
+    // 边：标签为单个路径组件
+    struct Edge {
+        uint32_t labelOffset;
+        uint32_t labelLength;
+        uint32_t child;
+    };
+
+    // 映射：字符串均存放在字符串池中
+    struct Mapping {
+        uint32_t originalOffset;
+        uint32_t originalLength;
+        uint32_t virtualOffset;
+        uint32_t virtualLength;
+        uint32_t flags;
+    };
+
+    // 映射表文件头，其后依次存放节点、边、映射数组和字符串池
+    struct TableHeader {
+        uint32_t magic;
+        uint32_t formatVersion;
+        uint64_t configVersion;
+        uint32_t nodeCount;
+        uint32_t edgeCount;
+        uint32_t mappingCount;
+        uint32_t poolSize;
+        uint32_t checksum;      // 头部之后全部内容的FNV-1a哈希
+        uint32_t reserved;
+    };
+
+    const Edge* findEdge(const Node& node, const char* label, size_t length) const;
+    uint32_t addString(const char* str, size_t length);
+    void bindStorage();
+    bool attach(const void* data, size_t size);
+    bool validate() const;
+
+    // 编译期存储，map()得到的实例不使用
+    std::vector<Node> mNodes;
+    std::vector<Edge> mEdges;
+    std::vector<Mapping> mMappings;
+    std::string mPool;
+
+    // 查找只通过以下视图访问，指向上面的存储或映射内存
+    const Node* mNodeData;
+    const Edge* mEdgeData;
+    const Mapping* mMappingData;
+    const char* mPoolData;
+    uint32_t mNodeCount;
+    uint32_t mEdgeCount;
+    uint32_t mMappingCount;
+    uint32_t mPoolSize;
+
+    void* mMapBase;
+    size_t mMapSize;
+};
+
+} // namespace VirtualSpace
+
+#endif // PATH_TRIE_H
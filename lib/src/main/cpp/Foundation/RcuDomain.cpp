@@ -0,0 +1,183 @@
+#include "RcuDomain.h"
+#include <sched.h>
+
+namespace VirtualSpace {
+
+namespace {
+constexpr int kMaxDomainsPerThread = 4;
+constexpr int kSlotNone = -1;
+constexpr int kSlotOverflow = -2;
+} // namespace
+
+// 线程私有状态：记录当前线程在各回收域中的槽位和嵌套深度
+struct RcuDomain::ThreadState {
+    struct Entry {
+        RcuDomain* domain;
+        int slot;
+        uint32_t depth;
+    };
+
+    Entry entries[kMaxDomainsPerThread];
+    int count = 0;
+
+    ~ThreadState() {
+        for (int i = 0; i < count; i++) {
+            if (entries[i].slot >= 0) {
+                entries[i].domain->releaseSlot(entries[i].slot);
+            }
+        }
+    }
+
+    Entry& entryFor(RcuDomain* domain) {
+        for (int i = 0; i < count; i++) {
+            if (entries[i].domain == domain) {
+                return entries[i];
+            }
+        }
+        if (count < kMaxDomainsPerThread) {
+            entries[count] = {domain, kSlotNone, 0};
+            return entries[count++];
+        }
+        // 超出线程可记录的域数量时退化为兜底计数
+        static thread_local Entry overflow = {nullptr, kSlotOverflow, 0};
+        if (overflow.domain != domain && overflow.depth == 0) {
+            overflow.domain = domain;
+        }
+        return overflow;
+    }
+};
+
+RcuDomain::RcuDomain() : mGlobalEpoch(1), mOverflowReaders(0) {
+    for (int i = 0; i < kMaxReaders; i++) {
+        mSlots[i].epoch.store(0, std::memory_order_relaxed);
+        mSlots[i].used.store(false, std::memory_order_relaxed);
+    }
+}
+
+RcuDomain::~RcuDomain() {
+    std::lock_guard<std::mutex> lock(mRetiredMutex);
+    for (const Retired& retired : mRetired) {
+        retired.deleter(retired.object);
+    }
+    mRetired.clear();
+}
+
+RcuDomain::ThreadState& RcuDomain::threadState() {
+    static thread_local ThreadState state;
+    return state;
+}
+
+void RcuDomain::readLock() {
+    ThreadState::Entry& entry = threadState().entryFor(this);
+    if (entry.depth++ > 0) {
+        return;
+    }
+
+    if (entry.slot == kSlotNone) {
+        entry.slot = acquireSlot();
+        if (entry.slot < 0) {
+            entry.slot = kSlotOverflow;
+        }
+    }
+
+    if (entry.slot == kSlotOverflow) {
+        mOverflowReaders.fetch_add(1, std::memory_order_seq_cst);
+        return;
+    }
+
+    // 先登记纪元再读取快照指针，保证写者扫描时能看到本线程
+    mSlots[entry.slot].epoch.store(mGlobalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+}
+
+void RcuDomain::readUnlock() {
+    ThreadState::Entry& entry = threadState().entryFor(this);
+    if (entry.depth == 0 || --entry.depth > 0) {
+        return;
+    }
+
+    if (entry.slot == kSlotOverflow) {
+        mOverflowReaders.fetch_sub(1, std::memory_order_release);
+        return;
+    }
+
+    mSlots[entry.slot].epoch.store(0, std::memory_order_release);
+}
+
+void RcuDomain::retire(void* object, void (*deleter)(void*)) {
+    if (object == nullptr) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mRetiredMutex);
+        // 记录推进前的纪元，此后进入的读者只能看到新快照
+        uint64_t epoch = mGlobalEpoch.fetch_add(1, std::memory_order_seq_cst);
+        mRetired.push_back({object, deleter, epoch});
+    }
+
+    reclaim();
+}
+
+void RcuDomain::reclaim() {
+    std::lock_guard<std::mutex> lock(mRetiredMutex);
+    if (mRetired.empty()) {
+        return;
+    }
+
+    uint64_t minEpoch = minActiveEpoch();
+    size_t kept = 0;
+    for (size_t i = 0; i < mRetired.size(); i++) {
+        if (mRetired[i].epoch < minEpoch) {
+            mRetired[i].deleter(mRetired[i].object);
+        } else {
+            mRetired[kept++] = mRetired[i];
+        }
+    }
+    mRetired.resize(kept);
+}
+
+void RcuDomain::synchronize() {
+    for (;;) {
+        reclaim();
+        {
+            std::lock_guard<std::mutex> lock(mRetiredMutex);
+            if (mRetired.empty()) {
+                return;
+            }
+        }
+        sched_yield();
+    }
+}
+
+int RcuDomain::acquireSlot() {
+    for (int i = 0; i < kMaxReaders; i++) {
+        bool expected = false;
+        if (!mSlots[i].used.load(std::memory_order_relaxed) &&
+            mSlots[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+            return i;
+        }
+    }
+    return kSlotNone;
+}
+
+void RcuDomain::releaseSlot(int slot) {
+    mSlots[slot].epoch.store(0, std::memory_order_release);
+    mSlots[slot].used.store(false, std::memory_order_release);
+}
+
+uint64_t RcuDomain::minActiveEpoch() {
+    if (mOverflowReaders.load(std::memory_order_seq_cst) != 0) {
+        return 0;
+    }
+
+    uint64_t minEpoch = UINT64_MAX;
+    for (int i = 0; i < kMaxReaders; i++) {
+        uint64_t epoch = mSlots[i].epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0 && epoch < minEpoch) {
+            minEpoch = epoch;
+        }
+    }
+    return minEpoch;
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,113 @@
+#ifndef RCU_DOMAIN_H
+#define RCU_DOMAIN_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * 基于纪元的RCU回收域
+ * 读者只写自己独占缓存行的槽位，不加锁、不互相竞争；
+ * 写者发布新快照后把旧对象挂到回收队列，确认没有读者仍处于旧纪元后再释放
+ */
+class RcuDomain {
+public:
+    // 读侧临界区
+    class ReadGuard {
+    public:
+        explicit ReadGuard(RcuDomain& domain) : mDomain(domain) { mDomain.readLock(); }
+        ~ReadGuard() { mDomain.readUnlock(); }
+
+        ReadGuard(const ReadGuard&) = delete;
+        ReadGuard& operator=(const ReadGuard&) = delete;
+
+    private:
+        RcuDomain& mDomain;
+    };
+
+    // 信号处理器中的读侧临界区：不访问线程私有状态、不分配槽位，
+    // 只增减兜底计数，期间写者把所有旧纪元都视为仍被占用
+    class SignalReadGuard {
+    public:
+        explicit SignalReadGuard(RcuDomain& domain) : mDomain(domain) {
+            mDomain.mOverflowReaders.fetch_add(1, std::memory_order_seq_cst);
+        }
+        ~SignalReadGuard() { mDomain.mOverflowReaders.fetch_sub(1, std::memory_order_release); }
+
+        SignalReadGuard(const SignalReadGuard&) = delete;
+        SignalReadGuard& operator=(const SignalReadGuard&) = delete;
+
+    private:
+        RcuDomain& mDomain;
+    };
+
+    RcuDomain();
+    ~RcuDomain();
+
+    RcuDomain(const RcuDomain&) = delete;
+    RcuDomain& operator=(const RcuDomain&) = delete;
+
+    /**
+     * 进入/退出读侧临界区，可嵌套
+     */
+    void readLock();
+    void readUnlock();
+
+    /**
+     * 延迟回收对象，必须在新快照发布之后调用
+     * @param object 已不可达的旧对象
+     */
+    template <typename T>
+    void retire(const T* object) {
+        retire(const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    void retire(void* object, void (*deleter)(void*));
+
+    /**
+     * 释放所有已安全的待回收对象
+     */
+    void reclaim();
+
+    /**
+     * 等待所有读者离开旧纪元并释放全部待回收对象
+     */
+    void synchronize();
+
+private:
+    static constexpr int kMaxReaders = 256;
+
+    // 每个读者线程独占一个槽位，epoch为0表示不在临界区
+    struct alignas(64) ReaderSlot {
+        std::atomic<uint64_t> epoch;
+        std::atomic<bool> used;
+    };
+
+    struct Retired {
+        void* object;
+        void (*deleter)(void*);
+        uint64_t epoch;
+    };
+
+    struct ThreadState;
+
+    ThreadState& threadState();
+    int acquireSlot();
+    void releaseSlot(int slot);
+    uint64_t minActiveEpoch();
+
+    ReaderSlot mSlots[kMaxReaders];
+    std::atomic<uint64_t> mGlobalEpoch;
+    // 槽位用尽时的兜底计数，非0时视所有旧纪元都仍被占用
+    std::atomic<uint32_t> mOverflowReaders;
+
+    std::mutex mRetiredMutex;
+    std::vector<Retired> mRetired;
+};
+
+} // namespace VirtualSpace
+
+#endif // RCU_DOMAIN_H
@@ -0,0 +1,342 @@
+#include "SharedMappingTable.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <string.h>
+#ifdef __ANDROID__
+#include <linux/ashmem.h>
+#endif
+
+#define TAG "SharedMappingTable"
+
+#ifndef MFD_CLOEXEC
+#define MFD_CLOEXEC 0x0001U
+#endif
+
+#ifndef MFD_ALLOW_SEALING
+#define MFD_ALLOW_SEALING 0x0002U
+#endif
+
+#ifndef F_ADD_SEALS
+#define F_ADD_SEALS 1033
+#define F_SEAL_SEAL 0x0001
+#define F_SEAL_SHRINK 0x0002
+#define F_SEAL_GROW 0x0004
+#endif
+
+#ifndef F_SEAL_FUTURE_WRITE
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+namespace VirtualSpace {
+
+namespace {
+
+constexpr uint32_t kRegionMagic = 0x54534d56;   // "VMST"
+constexpr const char* kRegionName = "virtualspace-mappings";
+
+} // namespace
+
+SharedMappingTable* SharedMappingTable::sInstance = nullptr;
+std::mutex SharedMappingTable::sMutex;
+
+SharedMappingTable::SharedMappingTable()
+    : mRegion(nullptr), mRegionSize(0), mFd(-1), mOwner(false), mAshmem(false), mSealed(false) {
+    static_assert(sizeof(RegionHeader) <= kHeaderSize, "RegionHeader must fit in kHeaderSize");
+    LOGD(TAG, "SharedMappingTable constructor");
+}
+
+SharedMappingTable::~SharedMappingTable() {
+    LOGD(TAG, "SharedMappingTable destructor");
+    detach();
+}
+
+SharedMappingTable* SharedMappingTable::getInstance() {
+    if (sInstance == nullptr) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (sInstance == nullptr) {
+            sInstance = new SharedMappingTable();
+        }
+    }
+    return sInstance;
+}
+
+int SharedMappingTable::createSharedFd(size_t size, bool* ashmem) {
+    *ashmem = false;
+
+#ifdef __NR_memfd_create
+    int fd = static_cast<int>(syscall(__NR_memfd_create, kRegionName, MFD_CLOEXEC | MFD_ALLOW_SEALING));
+    if (fd >= 0) {
+        if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+            return fd;
+        }
+        close(fd);
+    }
+#endif
+
+#ifdef __ANDROID__
+    // 旧内核没有memfd，退回ashmem
+    int ashmemFd = open("/dev/ashmem", O_RDWR | O_CLOEXEC);
+    if (ashmemFd >= 0) {
+        if (ioctl(ashmemFd, ASHMEM_SET_NAME, kRegionName) == 0 &&
+            ioctl(ashmemFd, ASHMEM_SET_SIZE, size) == 0) {
+            *ashmem = true;
+            return ashmemFd;
+        }
+        close(ashmemFd);
+    }
+#endif
+
+    return -1;
+}
+
+bool SharedMappingTable::create(size_t slotCapacity) {
+    if (isAttached()) {
+        LOGW(TAG, "Shared mapping table already attached");
+        return mOwner;
+    }
+
+    size_t regionSize = kHeaderSize + slotCapacity * 2;
+    bool ashmem = false;
+    int fd = createSharedFd(regionSize, &ashmem);
+    if (fd < 0) {
+        LOGE(TAG, "Failed to create shared memory: %s", strerror(errno));
+        return false;
+    }
+
+    void* base = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        LOGE(TAG, "Failed to map shared memory: %s", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+#ifdef __ANDROID__
+    // ashmem的保护掩码只约束之后的映射，宿主已有的可写映射不受影响
+    if (ashmem) {
+        ioctl(fd, ASHMEM_SET_PROT_MASK, PROT_READ);
+    }
+#endif
+
+    // memfd同理加F_SEAL_FUTURE_WRITE（Linux 5.1起），之后任何fd都无法再映射为可写；
+    // 旧内核不支持时只能依赖createReadOnlyFd()重新只读打开
+    bool sealed = false;
+    if (!ashmem) {
+        sealed = fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE | F_SEAL_SEAL) == 0;
+    }
+
+    RegionHeader* header = static_cast<RegionHeader*>(base);
+    header->magic = kRegionMagic;
+    header->slotCapacity = static_cast<uint32_t>(slotCapacity);
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->writeSequence.store(0, std::memory_order_relaxed);
+    header->slotSizes[0].store(0, std::memory_order_relaxed);
+    header->slotSizes[1].store(0, std::memory_order_relaxed);
+    header->rootFilter.store(0, std::memory_order_relaxed);
+
+    mRegionSize = regionSize;
+    mFd = fd;
+    mOwner = true;
+    mAshmem = ashmem;
+    mSealed = sealed;
+    mRegion.store(header, std::memory_order_release);
+
+    LOGD(TAG, "Shared mapping table created: %zu bytes per slot", slotCapacity);
+    return true;
+}
+
+bool SharedMappingTable::attach(int fd) {
+    if (fd < 0) {
+        return false;
+    }
+    if (isAttached()) {
+        LOGW(TAG, "Shared mapping table already attached");
+        close(fd);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(kHeaderSize)) {
+        // ashmem的fstat不返回大小，改用ioctl查询
+#ifdef __ANDROID__
+        int size = ioctl(fd, ASHMEM_GET_SIZE, nullptr);
+        if (size < static_cast<int>(kHeaderSize)) {
+            LOGE(TAG, "Invalid shared mapping table fd");
+            close(fd);
+            return false;
+        }
+        st.st_size = size;
+#else
+        LOGE(TAG, "Invalid shared mapping table fd");
+        close(fd);
+        return false;
+#endif
+    }
+
+    size_t regionSize = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, regionSize, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        LOGE(TAG, "Failed to map shared mapping table: %s", strerror(errno));
+        close(fd);
+        return false;
+    }
+
+    RegionHeader* header = static_cast<RegionHeader*>(base);
+    if (header->magic != kRegionMagic || kHeaderSize + static_cast<size_t>(header->slotCapacity) * 2 > regionSize) {
+        LOGE(TAG, "Shared mapping table header mismatch");
+        munmap(base, regionSize);
+        close(fd);
+        return false;
+    }
+
+    mRegionSize = regionSize;
+    mFd = fd;
+    mOwner = false;
+    mRegion.store(header, std::memory_order_release);
+
+    LOGD(TAG, "Shared mapping table attached, sequence %u", getSequence());
+    return true;
+}
+
+void SharedMappingTable::detach() {
+    RegionHeader* header = mRegion.exchange(nullptr, std::memory_order_acq_rel);
+    if (header != nullptr) {
+        munmap(header, mRegionSize);
+    }
+    if (mFd >= 0) {
+        close(mFd);
+    }
+    mRegionSize = 0;
+    mFd = -1;
+    mOwner = false;
+    mAshmem = false;
+    mSealed = false;
+}
+
+int SharedMappingTable::createReadOnlyFd() const {
+    if (!mOwner || mFd < 0) {
+        return -1;
+    }
+
+    // memfd通过/proc重新以只读方式打开，虚拟进程无法映射为可写
+    if (!mAshmem) {
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/self/fd/%d", mFd);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd >= 0) {
+            return fd;
+        }
+        // 复制出的fd仍是可写的，只有已封印写入时才允许退回复制
+        if (!mSealed) {
+            LOGE(TAG, "Failed to reopen mapping table read-only: %s", strerror(errno));
+            return -1;
+        }
+    }
+
+    // ashmem已设置只读保护掩码、memfd已封印写入，复制即可
+    return fcntl(mFd, F_DUPFD_CLOEXEC, 0);
+}
+
+bool SharedMappingTable::publish(const PathTrie& trie) {
+    RegionHeader* header = mRegion.load(std::memory_order_acquire);
+    if (header == nullptr || !mOwner) {
+        return false;
+    }
+
+    size_t size = trie.serializedSize();
+    if (size > header->slotCapacity) {
+        LOGE(TAG, "Mapping table too large for shared slot: %zu > %u", size, header->slotCapacity);
+        return false;
+    }
+
+    // 先声明正在写入的序列号，读者据此判断自己的槽位是否被改写
+    uint32_t next = header->sequence.load(std::memory_order_relaxed) + 1;
+    uint32_t slot = next & 1;
+    header->writeSequence.store(next, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    char* data = const_cast<char*>(slotData(slot));
+    trie.serialize(data, header->slotCapacity, 0);
+    header->slotSizes[slot].store(static_cast<uint32_t>(size), std::memory_order_relaxed);
+    header->rootFilter.fetch_or(trie.rootFilter(), std::memory_order_relaxed);
+
+    header->sequence.store(next, std::memory_order_release);
+    return true;
+}
+
+int SharedMappingTable::redirect(const char* path, size_t length, size_t minPrefixLength,
+                                 char* out, size_t capacity, size_t* prefixLength) const {
+    const RegionHeader* header = mRegion.load(std::memory_order_acquire);
+    if (header == nullptr) {
+        return 0;
+    }
+
+    // 先改写到本地缓冲区，校验通过后才写出，读到半途被改写的槽位时调用方的缓冲区保持不变
+    char scratch[PATH_MAX];
+    size_t scratchCapacity = capacity < sizeof(scratch) ? capacity : sizeof(scratch);
+
+    for (int attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+        uint32_t sequence = header->sequence.load(std::memory_order_acquire);
+        if (sequence == 0) {
+            return 0;
+        }
+
+        uint32_t slot = sequence & 1;
+        size_t slotSize = header->slotSizes[slot].load(std::memory_order_relaxed);
+        if (slotSize > header->slotCapacity) {
+            slotSize = header->slotCapacity;
+        }
+
+        int result = 0;
+        PathTrie::Match match;
+        if (PathTrie::findInTable(slotData(slot), slotSize, path, length, &match) &&
+            match.prefixLength > minPrefixLength) {
+            result = PathTrie::rewrite(match, path, length, scratch, scratchCapacity);
+        }
+
+        // 期间宿主最多写入了另一个槽位时结果有效
+        std::atomic_thread_fence(std::memory_order_acquire);
+        uint32_t writeSequence = header->writeSequence.load(std::memory_order_relaxed);
+        if (static_cast<int32_t>(writeSequence - sequence) <= 1) {
+            if (result > 0) {
+                memcpy(out, scratch, static_cast<size_t>(result) + 1);
+                *prefixLength = match.prefixLength;
+            }
+            return result;
+        }
+    }
+
+    // 宿主连续发布或在写入中途退出，本次按未命中处理
+    return 0;
+}
+
+uint32_t SharedMappingTable::getSequence() const {
+    const RegionHeader* header = mRegion.load(std::memory_order_acquire);
+    if (header == nullptr) {
+        return 0;
+    }
+    return header->sequence.load(std::memory_order_acquire);
+}
+
+uint64_t SharedMappingTable::getRootFilter() const {
+    const RegionHeader* header = mRegion.load(std::memory_order_acquire);
+    if (header == nullptr) {
+        return 0;
+    }
+    return header->rootFilter.load(std::memory_order_acquire);
+}
+
+const char* SharedMappingTable::slotData(uint32_t slot) const {
+    const RegionHeader* header = mRegion.load(std::memory_order_relaxed);
+    return reinterpret_cast<const char*>(header) + kHeaderSize + static_cast<size_t>(slot) * header->slotCapacity;
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,119 @@
+#ifndef SHARED_MAPPING_TABLE_H
+#define SHARED_MAPPING_TABLE_H
+
+#include <atomic>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include "PathTrie.h"
+
+namespace VirtualSpace {
+
+/**
+ * 跨进程共享的映射表
+ * 宿主进程创建memfd（不支持时退回ashmem）并发布编译好的前缀树，
+ * 虚拟进程拿到fd后只读映射，直接在共享内存上查找，映射表只占一份内存。
+ * 双槽位 + 序列号：宿主写入非当前槽位后递增序列号，
+ * 读者查找完成后检查期间没有第二次写入，否则重试
+ */
+class SharedMappingTable {
+public:
+    static SharedMappingTable* getInstance();
+
+    /**
+     * 宿主进程：创建共享内存区域
+     * @param slotCapacity 每个槽位的字节数，决定可发布的映射表大小上限
+     * @return 是否成功
+     */
+    bool create(size_t slotCapacity);
+
+    /**
+     * 虚拟进程：只读映射宿主创建的共享内存
+     * @param fd 宿主传来的文件描述符，成功后由本对象持有
+     * @return 是否成功
+     */
+    bool attach(int fd);
+
+    /**
+     * 释放映射和文件描述符
+     */
+    void detach();
+
+    /**
+     * 发布新的映射表，只能由宿主进程调用，调用方需保证单一写者
+     * @return 是否成功（映射表超过槽位大小时返回false）
+     */
+    bool publish(const PathTrie& trie);
+
+    /**
+     * 在共享映射表中查找并写出重定向结果，只有返回值大于0时才写out和prefixLength
+     * @param path 规范化后的绝对路径
+     * @param length 路径长度
+     * @param minPrefixLength 只接受比该长度更长的前缀匹配
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小（含结尾'\0'）
+     * @param prefixLength 命中时输出被替换的前缀长度
+     * @return 重定向后的长度；0表示没有更长的匹配；-1表示缓冲区不足
+     */
+    int redirect(const char* path, size_t length, size_t minPrefixLength,
+                 char* out, size_t capacity, size_t* prefixLength) const;
+
+    /**
+     * 当前已发布的序列号，每次发布递增
+     */
+    uint32_t getSequence() const;
+    
+    /**
+     * 所有已发布映射表的首组件过滤器并集，只增不减，
+     * 读者在任何时刻取到的值都不会漏掉当前槽位中的映射
+     */
+    uint64_t getRootFilter() const;
+
+    bool isAttached() const { return mRegion.load(std::memory_order_acquire) != nullptr; }
+    bool isOwner() const { return mOwner; }
+
+    /**
+     * 宿主进程：生成交给虚拟进程的只读文件描述符，由调用方负责关闭
+     * @return 文件描述符，失败时返回-1
+     */
+    int createReadOnlyFd() const;
+
+private:
+    SharedMappingTable();
+    ~SharedMappingTable();
+
+    // 禁用拷贝构造和赋值
+    SharedMappingTable(const SharedMappingTable&) = delete;
+    SharedMappingTable& operator=(const SharedMappingTable&) = delete;
+
+    // 单例相关
+    static SharedMappingTable* sInstance;
+    static std::mutex sMutex;
+
+    // 共享内存头部，其后为两个槽位；原子变量均为无锁实现，可跨进程使用
+    struct RegionHeader {
+        uint32_t magic;
+        uint32_t slotCapacity;
+        std::atomic<uint32_t> sequence;         // 已发布的序列号，当前槽位为sequence & 1
+        std::atomic<uint32_t> writeSequence;    // 正在写入的序列号
+        std::atomic<uint32_t> slotSizes[2];
+        std::atomic<uint64_t> rootFilter;       // 见getRootFilter()
+    };
+
+    static constexpr size_t kHeaderSize = 64;
+    static constexpr int kMaxReadAttempts = 8;
+
+    static int createSharedFd(size_t size, bool* ashmem);
+    const char* slotData(uint32_t slot) const;
+
+    std::atomic<RegionHeader*> mRegion;
+    size_t mRegionSize;
+    int mFd;
+    bool mOwner;
+    bool mAshmem;
+    bool mSealed;           // memfd已加F_SEAL_FUTURE_WRITE
+};
+
+} // namespace VirtualSpace
+
+#endif // SHARED_MAPPING_TABLE_H
@@ -0,0 +1,525 @@
+#include "SystemCallHook.h"
+#include "IORelocator.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <linux/filter.h>
+#include <linux/seccomp.h>
+#include <linux/audit.h>
+#include <sys/prctl.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <ucontext.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stddef.h>
+#include <vector>
+
+#define TAG "SystemCallHook"
+
+#ifndef SYS_SECCOMP
+#define SYS_SECCOMP 1
+#endif
+
+#ifndef SECCOMP_FILTER_FLAG_TSYNC
+#define SECCOMP_FILTER_FLAG_TSYNC 1
+#endif
+
+// 处理器重新发起系统调用的唯一入口，过滤器按陷入指令之后的地址放行，
+// 参数可以指向处理器栈上的任意缓冲区
+extern "C" long SystemCallHookGadget(long number, long a0, long a1, long a2, long a3, long a4, long a5)
+    __attribute__((visibility("hidden")));
+extern "C" char SystemCallHookGadgetReturn[] __attribute__((visibility("hidden")));
+
+#if defined(__aarch64__)
+asm(".text\n"
+    ".balign 4\n"
+    ".hidden SystemCallHookGadget\n"
+    ".hidden SystemCallHookGadgetReturn\n"
+    ".type SystemCallHookGadget, %function\n"
+    "SystemCallHookGadget:\n"
+    "    mov x8, x0\n"
+    "    mov x0, x1\n"
+    "    mov x1, x2\n"
+    "    mov x2, x3\n"
+    "    mov x3, x4\n"
+    "    mov x4, x5\n"
+    "    mov x5, x6\n"
+    "    svc #0\n"
+    "SystemCallHookGadgetReturn:\n"
+    "    ret\n"
+    ".size SystemCallHookGadget, . - SystemCallHookGadget\n");
+#elif defined(__arm__)
+asm(".text\n"
+    ".balign 4\n"
+    ".arm\n"
+    ".hidden SystemCallHookGadget\n"
+    ".hidden SystemCallHookGadgetReturn\n"
+    ".type SystemCallHookGadget, %function\n"
+    "SystemCallHookGadget:\n"
+    "    push {r4, r5, r7, lr}\n"
+    "    mov r7, r0\n"
+    "    mov r0, r1\n"
+    "    mov r1, r2\n"
+    "    mov r2, r3\n"
+    "    ldr r3, [sp, #16]\n"
+    "    ldr r4, [sp, #20]\n"
+    "    ldr r5, [sp, #24]\n"
+    "    svc #0\n"
+    "SystemCallHookGadgetReturn:\n"
+    "    pop {r4, r5, r7, pc}\n"
+    ".size SystemCallHookGadget, . - SystemCallHookGadget\n");
+#elif defined(__x86_64__)
+asm(".text\n"
+    ".hidden SystemCallHookGadget\n"
+    ".hidden SystemCallHookGadgetReturn\n"
+    ".type SystemCallHookGadget, @function\n"
+    "SystemCallHookGadget:\n"
+    "    movq %rdi, %rax\n"
+    "    movq %rsi, %rdi\n"
+    "    movq %rdx, %rsi\n"
+    "    movq %rcx, %rdx\n"
+    "    movq %r8, %r10\n"
+    "    movq %r9, %r8\n"
+    "    movq 8(%rsp), %r9\n"
+    "    syscall\n"
+    "SystemCallHookGadgetReturn:\n"
+    "    ret\n"
+    ".size SystemCallHookGadget, . - SystemCallHookGadget\n");
+#elif defined(__i386__)
+asm(".text\n"
+    ".hidden SystemCallHookGadget\n"
+    ".hidden SystemCallHookGadgetReturn\n"
+    ".type SystemCallHookGadget, @function\n"
+    "SystemCallHookGadget:\n"
+    "    pushl %ebp\n"
+    "    pushl %edi\n"
+    "    pushl %esi\n"
+    "    pushl %ebx\n"
+    "    movl 20(%esp), %eax\n"
+    "    movl 24(%esp), %ebx\n"
+    "    movl 28(%esp), %ecx\n"
+    "    movl 32(%esp), %edx\n"
+    "    movl 36(%esp), %esi\n"
+    "    movl 40(%esp), %edi\n"
+    "    movl 44(%esp), %ebp\n"
+    "    int $0x80\n"
+    "SystemCallHookGadgetReturn:\n"
+    "    popl %ebx\n"
+    "    popl %esi\n"
+    "    popl %edi\n"
+    "    popl %ebp\n"
+    "    ret\n"
+    ".size SystemCallHookGadget, . - SystemCallHookGadget\n");
+#endif
+
+namespace VirtualSpace {
+
+namespace {
+
+#if defined(__aarch64__)
+constexpr uint32_t kAuditArch = AUDIT_ARCH_AARCH64;
+#elif defined(__arm__)
+constexpr uint32_t kAuditArch = AUDIT_ARCH_ARM;
+#elif defined(__x86_64__)
+constexpr uint32_t kAuditArch = AUDIT_ARCH_X86_64;
+#elif defined(__i386__)
+constexpr uint32_t kAuditArch = AUDIT_ARCH_I386;
+#endif
+
+constexpr size_t kPathBufferSize = 4096;
+// 逐段读取调用方路径，段不跨页，每段要么完整读到要么整体失败
+constexpr size_t kProbeChunkSize = 256;
+
+// 带路径参数的系统调用及路径参数下标
+struct PathSyscall {
+    int number;
+    int pathArgs[2];
+};
+
+const PathSyscall kPathSyscalls[] = {
+    {__NR_openat, {1, -1}},
+    {__NR_faccessat, {1, -1}},
+#ifdef __NR_faccessat2
+    {__NR_faccessat2, {1, -1}},
+#endif
+#ifdef __NR_newfstatat
+    {__NR_newfstatat, {1, -1}},
+#endif
+#ifdef __NR_fstatat64
+    {__NR_fstatat64, {1, -1}},
+#endif
+    {__NR_readlinkat, {1, -1}},
+    {__NR_mkdirat, {1, -1}},
+    {__NR_unlinkat, {1, -1}},
+#ifdef __NR_renameat
+    {__NR_renameat, {1, 3}},
+#endif
+#ifdef __NR_renameat2
+    {__NR_renameat2, {1, 3}},
+#endif
+#ifdef __NR_open
+    {__NR_open, {0, -1}},
+#endif
+#ifdef __NR_stat
+    {__NR_stat, {0, -1}},
+#endif
+#ifdef __NR_lstat
+    {__NR_lstat, {0, -1}},
+#endif
+#ifdef __NR_stat64
+    {__NR_stat64, {0, -1}},
+#endif
+#ifdef __NR_lstat64
+    {__NR_lstat64, {0, -1}},
+#endif
+#ifdef __NR_access
+    {__NR_access, {0, -1}},
+#endif
+#ifdef __NR_readlink
+    {__NR_readlink, {0, -1}},
+#endif
+#ifdef __NR_mkdir
+    {__NR_mkdir, {0, -1}},
+#endif
+#ifdef __NR_rmdir
+    {__NR_rmdir, {0, -1}},
+#endif
+#ifdef __NR_unlink
+    {__NR_unlink, {0, -1}},
+#endif
+#ifdef __NR_rename
+    {__NR_rename, {0, 1}},
+#endif
+};
+
+constexpr size_t kPathSyscallCount = sizeof(kPathSyscalls) / sizeof(kPathSyscalls[0]);
+
+// 过滤器会随exec带到新镜像中，SIGSYS处理器却不会，新程序的第一个路径调用就会被杀死，
+// 因此exec一律陷入并以EPERM失败
+const int kExecSyscalls[] = {
+    __NR_execve,
+#ifdef __NR_execveat
+    __NR_execveat,
+#endif
+};
+
+constexpr size_t kExecSyscallCount = sizeof(kExecSyscalls) / sizeof(kExecSyscalls[0]);
+
+bool isExecSyscall(int number) {
+    for (size_t i = 0; i < kExecSyscallCount; i++) {
+        if (kExecSyscalls[i] == number) {
+            return true;
+        }
+    }
+    return false;
+}
+
+const PathSyscall* findPathSyscall(int number) {
+    for (size_t i = 0; i < kPathSyscallCount; i++) {
+        if (kPathSyscalls[i].number == number) {
+            return &kPathSyscalls[i];
+        }
+    }
+    return nullptr;
+}
+
+int pathArgCount(const PathSyscall& syscall) {
+    return syscall.pathArgs[1] >= 0 ? 2 : 1;
+}
+
+inline uint32_t argLowOffset(int index) {
+    return static_cast<uint32_t>(offsetof(struct seccomp_data, args) + index * sizeof(uint64_t));
+}
+
+inline uint32_t argHighOffset(int index) {
+    return argLowOffset(index) + sizeof(uint32_t);
+}
+
+// 经process_vm_readv复制调用方的路径：指针无效时与内核一样返回-EFAULT，而不是在处理器中崩溃
+long copyCallerPath(const char* path, char* out, size_t capacity) {
+    uintptr_t pageMask = static_cast<uintptr_t>(getpagesize()) - 1;
+    size_t copied = 0;
+    while (copied < capacity) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(path) + copied;
+        size_t chunk = (pageMask + 1) - (address & pageMask);
+        if (chunk > kProbeChunkSize) {
+            chunk = kProbeChunkSize;
+        }
+        if (chunk > capacity - copied) {
+            chunk = capacity - copied;
+        }
+
+        struct iovec local = {out + copied, chunk};
+        struct iovec remote = {reinterpret_cast<void*>(address), chunk};
+        long bytes = SystemCallHookGadget(__NR_process_vm_readv, getpid(), reinterpret_cast<long>(&local), 1,
+                                          reinterpret_cast<long>(&remote), 1, 0);
+        if (bytes != static_cast<long>(chunk)) {
+            return -EFAULT;
+        }
+
+        const void* end = memchr(out + copied, '\0', chunk);
+        if (end != nullptr) {
+            return static_cast<const char*>(end) - out;
+        }
+        copied += chunk;
+    }
+    return -ENAMETOOLONG;
+}
+
+// 从信号上下文读取系统调用参数
+void readSyscallArgs(ucontext_t* context, uint64_t args[6]) {
+#if defined(__aarch64__)
+    for (int i = 0; i < 6; i++) {
+        args[i] = context->uc_mcontext.regs[i];
+    }
+#elif defined(__arm__)
+    args[0] = context->uc_mcontext.arm_r0;
+    args[1] = context->uc_mcontext.arm_r1;
+    args[2] = context->uc_mcontext.arm_r2;
+    args[3] = context->uc_mcontext.arm_r3;
+    args[4] = context->uc_mcontext.arm_r4;
+    args[5] = context->uc_mcontext.arm_r5;
+#elif defined(__x86_64__)
+    args[0] = context->uc_mcontext.gregs[REG_RDI];
+    args[1] = context->uc_mcontext.gregs[REG_RSI];
+    args[2] = context->uc_mcontext.gregs[REG_RDX];
+    args[3] = context->uc_mcontext.gregs[REG_R10];
+    args[4] = context->uc_mcontext.gregs[REG_R8];
+    args[5] = context->uc_mcontext.gregs[REG_R9];
+#elif defined(__i386__)
+    args[0] = context->uc_mcontext.gregs[REG_EBX];
+    args[1] = context->uc_mcontext.gregs[REG_ECX];
+    args[2] = context->uc_mcontext.gregs[REG_EDX];
+    args[3] = context->uc_mcontext.gregs[REG_ESI];
+    args[4] = context->uc_mcontext.gregs[REG_EDI];
+    args[5] = context->uc_mcontext.gregs[REG_EBP];
+#endif
+}
+
+// 把返回值写回信号上下文
+void writeSyscallResult(ucontext_t* context, long result) {
+#if defined(__aarch64__)
+    context->uc_mcontext.regs[0] = static_cast<uint64_t>(result);
+#elif defined(__arm__)
+    context->uc_mcontext.arm_r0 = static_cast<unsigned long>(result);
+#elif defined(__x86_64__)
+    context->uc_mcontext.gregs[REG_RAX] = result;
+#elif defined(__i386__)
+    context->uc_mcontext.gregs[REG_EAX] = result;
+#endif
+}
+
+void appendStatement(std::vector<sock_filter>& program, uint16_t code, uint32_t k) {
+    sock_filter filter = BPF_STMT(code, k);
+    program.push_back(filter);
+}
+
+void appendJump(std::vector<sock_filter>& program, uint16_t code, uint32_t k, size_t jt, size_t jf) {
+    sock_filter filter = BPF_JUMP(code, k, static_cast<uint8_t>(jt), static_cast<uint8_t>(jf));
+    program.push_back(filter);
+}
+
+} // namespace
+
+SystemCallHook* SystemCallHook::sInstance = nullptr;
+std::mutex SystemCallHook::sMutex;
+
+SystemCallHook::SystemCallHook() : mIsInstalled(false) {
+    LOGD(TAG, "SystemCallHook constructor");
+    memset(&mPreviousAction, 0, sizeof(mPreviousAction));
+}
+
+SystemCallHook::~SystemCallHook() {
+    // seccomp过滤器无法卸载，实例在进程生命周期内保持有效
+    LOGD(TAG, "SystemCallHook destructor");
+}
+
+SystemCallHook* SystemCallHook::getInstance() {
+    if (sInstance == nullptr) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (sInstance == nullptr) {
+            sInstance = new SystemCallHook();
+        }
+    }
+    return sInstance;
+}
+
+bool SystemCallHook::install() {
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mIsInstalled.load(std::memory_order_acquire)) {
+            return true;
+        }
+
+        LOGD(TAG, "Installing seccomp system call hook...");
+
+        // 必须先安装处理器，否则第一个被拦截的调用会直接杀死进程
+        if (!installSignalHandler()) {
+            LOGE(TAG, "Failed to install SIGSYS handler");
+            return false;
+        }
+
+        if (!installFilter()) {
+            LOGE(TAG, "Failed to install seccomp filter");
+            sigaction(SIGSYS, &mPreviousAction, nullptr);
+            return false;
+        }
+
+        mIsInstalled.store(true, std::memory_order_release);
+        LOGD(TAG, "Seccomp system call hook installed, %zu syscalls trapped", kPathSyscallCount);
+        return true;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception installing seccomp hook: %s", e.what());
+        return false;
+    }
+}
+
+bool SystemCallHook::installSignalHandler() {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = handleSignal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+
+    if (sigaction(SIGSYS, &action, &mPreviousAction) != 0) {
+        LOGE(TAG, "sigaction failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool SystemCallHook::installFilter() {
+    uint64_t gadget = reinterpret_cast<uintptr_t>(SystemCallHookGadgetReturn);
+    const size_t trappedCount = kPathSyscallCount + kExecSyscallCount;
+
+    // 程序布局：架构检查、放行处理器自己发起的调用、按调用号分发、公共放行和陷入指令
+    const size_t dispatchStart = 8;
+    const size_t allowPosition = dispatchStart + trappedCount;
+    const size_t trapPosition = allowPosition + 1;
+
+    std::vector<sock_filter> program;
+    program.reserve(trapPosition + 1);
+
+    appendStatement(program, BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, arch));
+    appendJump(program, BPF_JMP | BPF_JEQ | BPF_K, kAuditArch, 1, 0);
+    appendStatement(program, BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+
+    // instruction_pointer是陷入指令之后的地址，等于SystemCallHookGadgetReturn的调用来自处理器
+    appendStatement(program, BPF_LD | BPF_W | BPF_ABS,
+                    offsetof(struct seccomp_data, instruction_pointer) + sizeof(uint32_t));
+    appendJump(program, BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(gadget >> 32), 0, 2);
+    appendStatement(program, BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, instruction_pointer));
+    appendJump(program, BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(gadget),
+               allowPosition - program.size() - 1, 0);
+    appendStatement(program, BPF_LD | BPF_W | BPF_ABS, offsetof(struct seccomp_data, nr));
+
+    // 不在列表中的系统调用直接放行，不离开内核快速路径
+    for (size_t i = 0; i < kPathSyscallCount; i++) {
+        appendJump(program, BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(kPathSyscalls[i].number),
+                   trapPosition - program.size() - 1, 0);
+    }
+    for (size_t i = 0; i < kExecSyscallCount; i++) {
+        appendJump(program, BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(kExecSyscalls[i]),
+                   trapPosition - program.size() - 1, 0);
+    }
+    appendStatement(program, BPF_RET | BPF_K, SECCOMP_RET_ALLOW);
+    appendStatement(program, BPF_RET | BPF_K, SECCOMP_RET_TRAP);
+
+    struct sock_fprog filter;
+    filter.len = static_cast<unsigned short>(program.size());
+    filter.filter = program.data();
+
+    if (prctl(PR_SET_NO_NEW_PRIVS, 1, 0, 0, 0) != 0) {
+        LOGE(TAG, "PR_SET_NO_NEW_PRIVS failed: %s", strerror(errno));
+        return false;
+    }
+
+    // 必须同步到进程内所有线程，只装在当前线程上其他线程的调用都不会被重定向
+    if (syscall(__NR_seccomp, SECCOMP_SET_MODE_FILTER, SECCOMP_FILTER_FLAG_TSYNC, &filter) != 0) {
+        LOGE(TAG, "seccomp TSYNC failed: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void SystemCallHook::handleSignal(int signal, siginfo_t* info, void* context) {
+    SystemCallHook* self = sInstance;
+    if (self == nullptr || info == nullptr || info->si_code != SYS_SECCOMP) {
+        // 不是本过滤器触发的SIGSYS，交给原处理器
+        if (self != nullptr && (self->mPreviousAction.sa_flags & SA_SIGINFO) &&
+            self->mPreviousAction.sa_sigaction != nullptr) {
+            self->mPreviousAction.sa_sigaction(signal, info, context);
+        } else if (self != nullptr && self->mPreviousAction.sa_handler != SIG_DFL &&
+                   self->mPreviousAction.sa_handler != SIG_IGN && self->mPreviousAction.sa_handler != nullptr) {
+            self->mPreviousAction.sa_handler(signal);
+        }
+        return;
+    }
+
+    self->handleSystemCall(info, context);
+}
+
+void SystemCallHook::handleSystemCall(siginfo_t* info, void* context) {
+    // 处理器只能做异步信号安全的操作：重定向使用无锁、不访问thread_local、不写日志的接口
+    int savedErrno = errno;
+    ucontext_t* ucontext = static_cast<ucontext_t*>(context);
+
+    if (isExecSyscall(info->si_syscall)) {
+        writeSyscallResult(ucontext, -EPERM);
+        errno = savedErrno;
+        return;
+    }
+
+    const PathSyscall* syscallInfo = findPathSyscall(info->si_syscall);
+    if (syscallInfo == nullptr) {
+        writeSyscallResult(ucontext, -ENOSYS);
+        errno = savedErrno;
+        return;
+    }
+
+    uint64_t args[6];
+    readSyscallArgs(ucontext, args);
+
+    // 缓冲区都在当前栈上，阻塞的调用不会占用其他线程的资源
+    char callerPath[kPathBufferSize];
+    char redirected[2][kPathBufferSize];
+    long result = 0;
+    for (int k = 0; k < pathArgCount(*syscallInfo); k++) {
+        int arg = syscallInfo->pathArgs[k];
+        const char* path = reinterpret_cast<const char*>(static_cast<uintptr_t>(args[arg]));
+        if (path == nullptr) {
+            result = -EFAULT;
+            break;
+        }
+
+        long pathLength = copyCallerPath(path, callerPath, sizeof(callerPath));
+        if (pathLength < 0) {
+            result = pathLength;
+            break;
+        }
+
+        // 未映射的路径保持原指针，由内核重新读取
+        int length = IORelocator::getInstance()->redirectPathSignalSafe(callerPath, redirected[k], kPathBufferSize);
+        if (length < 0) {
+            result = -ENAMETOOLONG;
+            break;
+        }
+        if (length > 0) {
+            args[arg] = reinterpret_cast<uintptr_t>(redirected[k]);
+        }
+    }
+
+    if (result == 0) {
+        result = SystemCallHookGadget(info->si_syscall, static_cast<long>(args[0]), static_cast<long>(args[1]),
+                                      static_cast<long>(args[2]), static_cast<long>(args[3]),
+                                      static_cast<long>(args[4]), static_cast<long>(args[5]));
+    }
+
+    writeSyscallResult(ucontext, result);
+    errno = savedErrno;
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,61 @@
+#ifndef SYSTEM_CALL_HOOK_H
+#define SYSTEM_CALL_HOOK_H
+
+#include <mutex>
+#include <atomic>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * 基于seccomp-BPF和SIGSYS的系统调用拦截
+ * 可以覆盖PLT Hook拦截不到的直接syscall()调用和静态链接代码。
+ * 过滤器只对带路径参数的系统调用生效，处理器经由固定的系统调用入口重新发起调用，
+ * 过滤器按指令地址放行该入口，路径缓冲区可以放在处理器自己的栈上。
+ * 过滤器会被exec出的子程序继承而处理器不会，安装后execve/execveat一律以EPERM失败，
+ * 需要启动其他程序的应用不能使用该后端
+ */
+class SystemCallHook {
+public:
+    static SystemCallHook* getInstance();
+
+    /**
+     * 安装SIGSYS处理器和seccomp过滤器
+     * seccomp过滤器一旦安装无法卸载，重复调用直接返回true
+     * @return 是否成功
+     */
+    bool install();
+
+    /**
+     * 是否已安装
+     */
+    bool isInstalled() const { return mIsInstalled.load(std::memory_order_acquire); }
+
+private:
+    SystemCallHook();
+    ~SystemCallHook();
+
+    // 禁用拷贝构造和赋值
+    SystemCallHook(const SystemCallHook&) = delete;
+    SystemCallHook& operator=(const SystemCallHook&) = delete;
+
+    // 单例相关
+    static SystemCallHook* sInstance;
+    static std::mutex sMutex;
+
+    bool installSignalHandler();
+    bool installFilter();
+
+    static void handleSignal(int signal, siginfo_t* info, void* context);
+    void handleSystemCall(siginfo_t* info, void* context);
+
+    std::atomic<bool> mIsInstalled;
+    std::mutex mMutex;
+    struct sigaction mPreviousAction;
+};
+
+} // namespace VirtualSpace
+
+#endif // SYSTEM_CALL_HOOK_H
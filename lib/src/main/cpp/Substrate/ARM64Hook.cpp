@@ -0,0 +1,374 @@
+#include "ARM64Hook.h"
+#include "TrampolinePool.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+#define TAG "ARM64Hook"
+
+namespace VirtualSpace {
+
+namespace {
+
+// 重定位时使用的临时寄存器（IP1），按AAPCS64在函数入口处可自由使用
+constexpr uint32_t kScratchRegister = 17;
+
+constexpr uint32_t kInsnNop = 0xD503201F;
+
+static_assert(ARM64Hook::kTrampolineSize == TrampolinePool::kSlotSize, "trampoline must fill one pool slot");
+
+inline int64_t signExtend(uint64_t value, int bits) {
+    uint64_t mask = 1ULL << (bits - 1);
+    value &= (1ULL << bits) - 1;
+    return static_cast<int64_t>((value ^ mask) - mask);
+}
+
+inline uint32_t encodeLdrLiteralX(uint32_t rt, int32_t offset) {
+    return 0x58000000 | ((static_cast<uint32_t>(offset >> 2) & 0x7FFFF) << 5) | rt;
+}
+
+inline uint32_t encodeBr(uint32_t rn) {
+    return 0xD61F0000 | (rn << 5);
+}
+
+inline uint32_t encodeBlr(uint32_t rn) {
+    return 0xD63F0000 | (rn << 5);
+}
+
+inline uint32_t encodeB(int32_t offset) {
+    return 0x14000000 | (static_cast<uint32_t>(offset >> 2) & 0x3FFFFFF);
+}
+
+inline uintptr_t pageStart(uintptr_t address) {
+    return address & ~(static_cast<uintptr_t>(getpagesize()) - 1);
+}
+
+// 顺序写入跳板，越界时置失败标记
+class CodeWriter {
+public:
+    CodeWriter(uint32_t* buffer, size_t capacityWords)
+        : mBuffer(buffer), mCapacity(capacityWords), mCount(0), mOverflow(false) {}
+
+    void emit(uint32_t insn) {
+        if (mCount >= mCapacity) {
+            mOverflow = true;
+            return;
+        }
+        mBuffer[mCount++] = insn;
+    }
+
+    void emitAddress(uint64_t address) {
+        emit(static_cast<uint32_t>(address));
+        emit(static_cast<uint32_t>(address >> 32));
+    }
+
+    // LDR X17, #8; BR X17; .quad address
+    void emitAbsoluteJump(uint64_t address) {
+        emit(encodeLdrLiteralX(kScratchRegister, 8));
+        emit(encodeBr(kScratchRegister));
+        emitAddress(address);
+    }
+
+    size_t count() const { return mCount; }
+    bool overflow() const { return mOverflow; }
+
+private:
+    uint32_t* mBuffer;
+    size_t mCapacity;
+    size_t mCount;
+    bool mOverflow;
+};
+
+// 重定位单条指令，PC相关指令展开为绝对地址形式
+void relocateInstruction(uint32_t insn, uint64_t pc, CodeWriter& writer) {
+    // B / BL
+    if ((insn & 0x7C000000) == 0x14000000) {
+        uint64_t destination = pc + signExtend(insn & 0x3FFFFFF, 26) * 4;
+        if (insn & 0x80000000) {
+            // LDR X17, #12; BLR X17; B #12; .quad destination
+            writer.emit(encodeLdrLiteralX(kScratchRegister, 12));
+            writer.emit(encodeBlr(kScratchRegister));
+            writer.emit(encodeB(12));
+            writer.emitAddress(destination);
+        } else {
+            writer.emitAbsoluteJump(destination);
+        }
+        return;
+    }
+
+    // B.cond / CBZ / CBNZ / TBZ / TBNZ：条件成立时跳到后面的绝对跳转
+    bool isBCond = (insn & 0xFF000010) == 0x54000000;
+    bool isCompareBranch = (insn & 0x7E000000) == 0x34000000;
+    bool isTestBranch = (insn & 0x7E000000) == 0x36000000;
+    if (isBCond || isCompareBranch || isTestBranch) {
+        uint64_t destination;
+        uint32_t rewritten;
+        if (isTestBranch) {
+            destination = pc + signExtend((insn >> 5) & 0x3FFF, 14) * 4;
+            rewritten = (insn & 0xFFF8001F) | (2u << 5);
+        } else {
+            destination = pc + signExtend((insn >> 5) & 0x7FFFF, 19) * 4;
+            rewritten = (insn & 0xFF00001F) | (2u << 5);
+        }
+        // cond #8; B #20; LDR X17, #8; BR X17; .quad destination
+        writer.emit(rewritten);
+        writer.emit(encodeB(20));
+        writer.emitAbsoluteJump(destination);
+        return;
+    }
+
+    // ADR / ADRP
+    if ((insn & 0x1F000000) == 0x10000000) {
+        uint32_t rd = insn & 0x1F;
+        uint64_t immediate = (((insn >> 5) & 0x7FFFF) << 2) | ((insn >> 29) & 0x3);
+        uint64_t value;
+        if (insn & 0x80000000) {
+            value = (pc & ~0xFFFULL) + (signExtend(immediate, 21) << 12);
+        } else {
+            value = pc + signExtend(immediate, 21);
+        }
+        // LDR Xd, #8; B #12; .quad value
+        writer.emit(encodeLdrLiteralX(rd, 8));
+        writer.emit(encodeB(12));
+        writer.emitAddress(value);
+        return;
+    }
+
+    // LDR (literal)
+    if ((insn & 0x3B000000) == 0x18000000) {
+        uint32_t rt = insn & 0x1F;
+        uint32_t opc = insn >> 30;
+        bool simd = (insn >> 26) & 1;
+        uint64_t address = pc + signExtend((insn >> 5) & 0x7FFFF, 19) * 4;
+
+        uint32_t load;
+        if (!simd) {
+            switch (opc) {
+                case 0: load = 0xB9400000; break;   // LDR Wt, [X17]
+                case 1: load = 0xF9400000; break;   // LDR Xt, [X17]
+                case 2: load = 0xB9800000; break;   // LDRSW Xt, [X17]
+                default:
+                    // PRFM没有副作用，直接丢弃
+                    writer.emit(kInsnNop);
+                    return;
+            }
+        } else {
+            switch (opc) {
+                case 0: load = 0xBD400000; break;   // LDR St, [X17]
+                case 1: load = 0xFD400000; break;   // LDR Dt, [X17]
+                default: load = 0x3DC00000; break;  // LDR Qt, [X17]
+            }
+        }
+        // LDR X17, #12; LDR rt, [X17]; B #12; .quad address
+        writer.emit(encodeLdrLiteralX(kScratchRegister, 12));
+        writer.emit(load | (kScratchRegister << 5) | rt);
+        writer.emit(encodeB(12));
+        writer.emitAddress(address);
+        return;
+    }
+
+    // 与PC无关的指令原样拷贝
+    writer.emit(insn);
+}
+
+// from处的B指令能否跳到to
+inline bool isBranchReachable(const void* from, const void* to) {
+    return TrampolinePool::isWithinRange(reinterpret_cast<uintptr_t>(to), sizeof(uint32_t),
+                                         reinterpret_cast<uintptr_t>(from), ARM64Hook::kBranchRange);
+}
+
+// BL、BLR及其指针认证形式BLRAA/BLRAB/BLRAAZ/BLRABZ
+inline bool isCall(uint32_t insn) {
+    return (insn & 0xFC000000) == 0x94000000 ||
+           (insn & 0xFFFFFC1F) == 0xD63F0000 ||
+           (insn & 0xFEFFF800) == 0xD63F0800;
+}
+
+// 被覆盖的指令中有调用且返回地址仍落在覆盖范围内时，调用中的线程
+// 返回后会执行半条跳转指令；更深的栈帧看不到，只能拒绝这类目标
+bool hasCallReturningInto(const void* target, size_t patchSize) {
+    const uint32_t* code = static_cast<const uint32_t*>(target);
+    for (size_t i = 0; i + 1 < patchSize / sizeof(uint32_t); i++) {
+        if (isCall(code[i])) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool writeCode(void* target, const void* code, size_t size) {
+    uintptr_t start = pageStart(reinterpret_cast<uintptr_t>(target));
+    uintptr_t end = reinterpret_cast<uintptr_t>(target) + size;
+    size_t length = end - start;
+
+    if (mprotect(reinterpret_cast<void*>(start), length, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+        LOGE(TAG, "mprotect failed: %s", strerror(errno));
+        return false;
+    }
+
+    ARM64Hook::storePatch(target, static_cast<const uint32_t*>(code), size);
+
+    __builtin___clear_cache(static_cast<char*>(target), static_cast<char*>(target) + size);
+    mprotect(reinterpret_cast<void*>(start), length, PROT_READ | PROT_EXEC);
+    return true;
+}
+
+} // namespace
+
+bool ARM64Hook::initialize() {
+    // 跳板按目标地址就近分配，不再预先映射内存块
+    return true;
+}
+
+void ARM64Hook::cleanup() {
+    // 仍有Hook或尚未静默的跳板所在的内存块保留
+    TrampolinePool::releaseIdle();
+}
+
+void ARM64Hook::freeTrampoline(void* trampoline) {
+    TrampolinePool::free(trampoline);
+}
+
+size_t ARM64Hook::relocate(const void* target, size_t patchSize, uint32_t* trampoline, size_t capacity) {
+    const uint32_t* code = static_cast<const uint32_t*>(target);
+    uint64_t pc = reinterpret_cast<uintptr_t>(target);
+
+    CodeWriter writer(trampoline, capacity / sizeof(uint32_t));
+    for (size_t i = 0; i < patchSize / sizeof(uint32_t); i++) {
+        relocateInstruction(code[i], pc + i * sizeof(uint32_t), writer);
+    }
+    // 跳回目标函数未被覆盖的部分
+    writer.emitAbsoluteJump(pc + patchSize);
+
+    if (writer.overflow()) {
+        return 0;
+    }
+    return writer.count() * sizeof(uint32_t);
+}
+
+void ARM64Hook::makeJump(const void* destination, uint32_t* patch) {
+    CodeWriter writer(patch, kPatchWords);
+    writer.emitAbsoluteJump(reinterpret_cast<uintptr_t>(destination));
+}
+
+bool ARM64Hook::prepare(void* target, void* replacement, uint32_t* patch, void** trampoline,
+                        uint8_t* originalCode, size_t* patchSize) {
+    if ((reinterpret_cast<uintptr_t>(target) & 0x3) != 0) {
+        LOGE(TAG, "Target %p is not 4-byte aligned", target);
+        return false;
+    }
+
+    uint32_t* code = static_cast<uint32_t*>(TrampolinePool::allocate(target, kBranchRange));
+    if (code == nullptr) {
+        return false;
+    }
+
+    // 跳转桩可达时目标处只写一条B，只需重定位一条指令，其他线程也不会看到半成品
+    uint32_t* stub = code + kStubOffset / sizeof(uint32_t);
+    bool near = isBranchReachable(target, stub);
+    size_t size = near ? kNearPatchSize : kPatchSize;
+    if (hasCallReturningInto(target, size)) {
+        LOGE(TAG, "Target %p calls out within the patched instructions", target);
+        freeTrampoline(code);
+        return false;
+    }
+
+    size_t length = relocate(target, size, code, kStubOffset);
+    if (length == 0) {
+        LOGE(TAG, "Trampoline overflow for %p", target);
+        freeTrampoline(code);
+        return false;
+    }
+
+    if (near) {
+        makeJump(replacement, stub);
+        intptr_t offset = reinterpret_cast<intptr_t>(stub) - reinterpret_cast<intptr_t>(target);
+        patch[0] = encodeB(static_cast<int32_t>(offset));
+        __builtin___clear_cache(reinterpret_cast<char*>(code), reinterpret_cast<char*>(code) + kTrampolineSize);
+    } else {
+        makeJump(replacement, patch);
+        __builtin___clear_cache(reinterpret_cast<char*>(code), reinterpret_cast<char*>(code) + length);
+    }
+
+    memcpy(originalCode, target, size);
+    *trampoline = code;
+    *patchSize = size;
+    return true;
+}
+
+void ARM64Hook::storePatch(void* target, const uint32_t* patch, size_t patchSize) {
+    // 缩短其他线程看到半成品的窗口
+    uint32_t* destination = static_cast<uint32_t*>(target);
+    for (size_t i = patchSize / sizeof(uint32_t); i-- > 1;) {
+        destination[i] = patch[i];
+    }
+    __atomic_store_n(&destination[0], patch[0], __ATOMIC_RELEASE);
+}
+
+bool ARM64Hook::hook(void* target, void* replacement, void** trampoline, uint8_t* originalCode, size_t* patchSize) {
+    uint32_t patch[kPatchWords];
+    void* code = nullptr;
+    size_t size = 0;
+    if (!prepare(target, replacement, patch, &code, originalCode, &size)) {
+        return false;
+    }
+
+    // 先发布跳板再改写目标，替换函数一被调用就能通过跳板调用原方法
+    if (trampoline != nullptr) {
+        __atomic_store_n(trampoline, code, __ATOMIC_RELEASE);
+    }
+    if (!writeCode(target, patch, size)) {
+        if (trampoline != nullptr) {
+            *trampoline = nullptr;
+        }
+        freeTrampoline(code);
+        return false;
+    }
+
+    if (patchSize != nullptr) {
+        *patchSize = size;
+    }
+    return true;
+}
+
+bool ARM64Hook::unhook(void* target, const uint8_t* originalCode, size_t patchSize) {
+    // originalCode不一定按4字节对齐，先拷贝出来再按指令字写回
+    uint32_t code[kPatchWords];
+    if (patchSize == 0 || patchSize > kPatchSize) {
+        return false;
+    }
+    memcpy(code, originalCode, patchSize);
+    return writeCode(target, code, patchSize);
+}
+
+bool ARM64Hook::retarget(void* target, size_t patchSize, void* trampoline, void* replacement) {
+    uint64_t address = reinterpret_cast<uintptr_t>(replacement);
+
+    // 就近模式的跳转桩位于槽位末尾，地址字按8字节对齐且在可写的池内存中
+    if (patchSize == kNearPatchSize) {
+        uint64_t* literal = reinterpret_cast<uint64_t*>(static_cast<uint8_t*>(trampoline) + kStubOffset + 8);
+        __atomic_store_n(literal, address, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // 远跳转的地址字在目标代码中：LDR X17, #8; BR X17; .quad addr
+    uintptr_t literalAddress = reinterpret_cast<uintptr_t>(target) + 8;
+    if ((literalAddress & 0x7) != 0) {
+        return false;
+    }
+    uintptr_t start = pageStart(literalAddress);
+    size_t length = literalAddress + sizeof(uint64_t) - start;
+    if (mprotect(reinterpret_cast<void*>(start), length, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+        LOGE(TAG, "mprotect failed: %s", strerror(errno));
+        return false;
+    }
+    // 地址字经数据通路读取，不需要刷新指令缓存
+    __atomic_store_n(reinterpret_cast<uint64_t*>(literalAddress), address, __ATOMIC_RELEASE);
+    mprotect(reinterpret_cast<void*>(start), length, PROT_READ | PROT_EXEC);
+    return true;
+}
+
+} // namespace VirtualSpace
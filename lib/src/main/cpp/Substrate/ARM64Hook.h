@@ -0,0 +1,116 @@
+#ifndef ARM64_HOOK_H
+#define ARM64_HOOK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * ARM64内联Hook
+ * 跳板从TrampolinePool中靠近目标分配：在±128MB范围内时目标开头只改写为一条B指令，
+ * 跳到跳板末尾的绝对跳转桩；否则改写为16字节的绝对跳转。被覆盖的指令重定位到跳板中
+ */
+class ARM64Hook {
+public:
+    // 目标处最多被覆盖的字节数：LDR X17, #8; BR X17; .quad addr
+    static constexpr size_t kPatchSize = 16;
+    static constexpr size_t kPatchWords = kPatchSize / sizeof(uint32_t);
+
+    // 跳板在B指令可达范围内时只覆盖一条指令
+    static constexpr size_t kNearPatchSize = 4;
+
+    // B指令的跳转范围
+    static constexpr size_t kBranchRange = (128u << 20) - 4;
+
+    /**
+     * 初始化，跳板内存按需就近分配
+     */
+    static bool initialize();
+
+    /**
+     * 释放已无跳板在用的内存块
+     */
+    static void cleanup();
+
+    /**
+     * 生成跳板：重定位目标开头的指令并跳回目标剩余部分
+     * @param target 目标函数地址
+     * @param patchSize 目标处被覆盖的字节数
+     * @param trampoline 跳板写入地址
+     * @param capacity 跳板可用字节数
+     * @return 跳板长度（字节），失败返回0
+     */
+    static size_t relocate(const void* target, size_t patchSize, uint32_t* trampoline, size_t capacity);
+
+    /**
+     * 生成写入目标处的跳转指令
+     * @param destination 跳转目的地址
+     * @param patch 输出kPatchWords个指令字
+     */
+    static void makeJump(const void* destination, uint32_t* patch);
+
+    /**
+     * 准备Hook但不修改目标代码：生成跳板、跳转指令并保存原始指令
+     * @param target 目标函数地址
+     * @param replacement 替换函数地址
+     * @param patch 输出要写入目标处的kPatchWords个指令字
+     * @param trampoline 输出调用原函数的跳板地址
+     * @param originalCode 输出被覆盖的原始指令（最多kPatchSize字节）
+     * @param patchSize 输出目标处被覆盖的字节数
+     * @return 是否成功
+     */
+    static bool prepare(void* target, void* replacement, uint32_t* patch, void** trampoline,
+                        uint8_t* originalCode, size_t* patchSize);
+
+    /**
+     * 把跳转指令写入目标处，调用方负责页保护属性和指令缓存刷新
+     * 先写后面的字，最后原子写入第一条指令
+     */
+    static void storePatch(void* target, const uint32_t* patch, size_t patchSize);
+
+    /**
+     * 安装Hook
+     * @param target 目标函数地址
+     * @param replacement 替换函数地址
+     * @param trampoline 输出调用原函数的跳板地址，在改写目标之前写入
+     * @param originalCode 输出被覆盖的原始指令（最多kPatchSize字节）
+     * @param patchSize 输出目标处被覆盖的字节数
+     * @return 是否成功
+     */
+    static bool hook(void* target, void* replacement, void** trampoline, uint8_t* originalCode, size_t* patchSize);
+
+    /**
+     * 取消Hook，只恢复原始指令
+     * 其他线程可能仍在执行跳板，跳板由调用方在静默后回收
+     * @param target 目标函数地址
+     * @param originalCode 被覆盖的原始指令
+     * @param patchSize 被覆盖的字节数
+     * @return 是否成功
+     */
+    static bool unhook(void* target, const uint8_t* originalCode, size_t patchSize);
+
+    /**
+     * 把已安装的Hook改为跳到新的替换函数，目标指令和重定位的原方法跳板不变
+     * 只原子地替换跳转桩中的地址字；远跳转的地址字未按8字节对齐时无法原子替换
+     * @param target 目标函数地址
+     * @param patchSize 目标处被覆盖的字节数
+     * @param trampoline Hook的跳板
+     * @param replacement 新的替换函数地址
+     * @return 是否成功，返回false时调用方应退回取消后重新Hook
+     */
+    static bool retarget(void* target, size_t patchSize, void* trampoline, void* replacement);
+
+    /**
+     * 释放跳板，归还给TrampolinePool
+     */
+    static void freeTrampoline(void* trampoline);
+
+    // 单个跳板的大小，末尾kPatchSize字节在就近模式下存放跳到替换函数的绝对跳转桩
+    static constexpr size_t kTrampolineSize = 128;
+    static constexpr size_t kStubOffset = kTrampolineSize - kPatchSize;
+};
+
+} // namespace VirtualSpace
+
+#endif // ARM64_HOOK_H
@@ -0,0 +1,470 @@
+#include "ArtMethodHook.h"
+#include "HookRegistry.h"
+#include "TrampolinePool.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <sys/system_properties.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mutex>
+#include <vector>
+
+#define TAG "ArtMethodHook"
+
+namespace VirtualSpace {
+
+namespace {
+
+// art/libdexfile/dex/modifiers.h
+constexpr uint32_t kAccPublic = 0x0001;
+constexpr uint32_t kAccPrivate = 0x0002;
+constexpr uint32_t kAccProtected = 0x0004;
+constexpr uint32_t kAccStatic = 0x0008;
+constexpr uint32_t kAccNative = 0x0100;
+constexpr uint32_t kAccAbstract = 0x0400;
+constexpr uint32_t kAccCompileDontBother = 0x02000000;
+constexpr uint32_t kAccFastInterpreterToInterpreterInvoke = 0x40000000;
+constexpr uint32_t kAccIntrinsic = 0x80000000;
+
+// 以下标志的取值随版本变化
+constexpr uint32_t kAccPreCompiledR = 0x00200000;
+constexpr uint32_t kAccPreCompiledS = 0x00800000;
+constexpr uint32_t kAccNterpEntryPointFastPath = 0x00100000;   // S+
+constexpr uint32_t kAccNterpInvokeFastPath = 0x00200000;       // T+
+
+constexpr int kSdkR = 30;
+constexpr int kSdkS = 31;
+constexpr int kSdkT = 33;
+
+// GcRoot<mirror::Class> declaring_class_之后是access_flags_，R以来未变
+constexpr size_t kAccessFlagsOffset = 4;
+
+// declaring_class_、access_flags_、dex_method_index_、method_index_和hotness_count_，
+// 之后是data_和entry_point_from_quick_compiled_code_两个指针
+constexpr size_t kFixedFieldsSize = 16;
+constexpr size_t kDefaultMethodSize = kFixedFieldsSize + 2 * sizeof(void*);
+constexpr size_t kMaxMethodSize = 64;
+
+// 跳板长度，不超过一个池槽位
+constexpr size_t kTrampolineSize = 24;
+static_assert(kTrampolineSize <= TrampolinePool::kSlotSize, "trampoline must fit one pool slot");
+
+struct ArtHookInfo {
+    void* targetMethod;
+    void* hookMethod;
+    void* backupMethod;
+    void* trampoline;
+    void* originalEntryPoint;
+    uint32_t originalAccessFlags;
+};
+
+struct Layout {
+    int sdk;
+    size_t methodSize;
+    size_t entryPointOffset;
+    void* interpreterEntryPoint;     // 未编译方法共用的入口，未知时为nullptr
+    uint32_t clearFlags;             // Hook时从目标上清除、会绕过入口的标志
+};
+
+std::mutex sArtHookMutex;
+bool sInitialized = false;
+Layout sLayout;
+jfieldID sArtMethodField = nullptr;
+jmethodID sMethodInvoke = nullptr;
+HookRegistry<ArtHookInfo> sArtHooks;
+
+int readSdkVersion() {
+    char value[PROP_VALUE_MAX] = {0};
+    if (__system_property_get("ro.build.version.sdk", value) <= 0) {
+        return 0;
+    }
+    return atoi(value);
+}
+
+uint32_t hookClearFlags(int sdk) {
+    uint32_t flags = kAccFastInterpreterToInterpreterInvoke;
+    if (sdk >= kSdkS) {
+        flags |= kAccPreCompiledS | kAccNterpEntryPointFastPath;
+    } else {
+        flags |= kAccPreCompiledR;
+    }
+    if (sdk >= kSdkT) {
+        flags |= kAccNterpInvokeFastPath;
+    }
+    return flags;
+}
+
+inline uint32_t* accessFlags(void* method) {
+    return reinterpret_cast<uint32_t*>(static_cast<char*>(method) + kAccessFlagsOffset);
+}
+
+inline uint32_t loadAccessFlags(void* method) {
+    return __atomic_load_n(accessFlags(method), __ATOMIC_ACQUIRE);
+}
+
+// access_flags_在ART中是原子变量，运行时也会修改其中的标志位
+inline void updateAccessFlags(void* method, uint32_t set, uint32_t clear) {
+    uint32_t* flags = accessFlags(method);
+    uint32_t current = __atomic_load_n(flags, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(flags, &current, (current & ~clear) | set, true,
+                                        __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)) {
+    }
+}
+
+inline void** entryPoint(void* method) {
+    return reinterpret_cast<void**>(static_cast<char*>(method) + sLayout.entryPointOffset);
+}
+
+inline void* loadEntryPoint(void* method) {
+    return __atomic_load_n(entryPoint(method), __ATOMIC_ACQUIRE);
+}
+
+inline void storeEntryPoint(void* method, void* code) {
+    __atomic_store_n(entryPoint(method), code, __ATOMIC_RELEASE);
+}
+
+// 指针形式的jmethodID就是ArtMethod*；开启不透明ID时为奇数索引，改从Executable.artMethod读取
+void* fromMethodId(JNIEnv* env, jclass clazz, jmethodID id, jboolean isStatic) {
+    if (id == nullptr) {
+        return nullptr;
+    }
+    if ((reinterpret_cast<uintptr_t>(id) & 1) == 0) {
+        return id;
+    }
+    if (sArtMethodField == nullptr) {
+        return nullptr;
+    }
+    jobject reflected = env->ToReflectedMethod(clazz, id, isStatic);
+    if (reflected == nullptr) {
+        env->ExceptionClear();
+        return nullptr;
+    }
+    void* method = reinterpret_cast<void*>(static_cast<uintptr_t>(env->GetLongField(reflected, sArtMethodField)));
+    env->DeleteLocalRef(reflected);
+    return method;
+}
+
+// 跳板：第一个参数寄存器换成Hook方法的ArtMethod*，再跳到它当前的入口，
+// Hook方法之后被JIT编译也能跟上
+size_t writeTrampoline(uint8_t* code, void* hookMethod, size_t entryPointOffset) {
+#if defined(__aarch64__)
+    uint32_t* insn = reinterpret_cast<uint32_t*>(code);
+    insn[0] = 0x58000080;                                                       // LDR X0, #16
+    insn[1] = 0xF9400010 | (static_cast<uint32_t>(entryPointOffset / 8) << 10); // LDR X16, [X0, #offset]
+    insn[2] = 0xD61F0200;                                                       // BR X16
+    insn[3] = 0xD4200000;                                                       // BRK #0
+    memcpy(code + 16, &hookMethod, sizeof(hookMethod));
+    return 24;
+#elif defined(__arm__)
+    // 跳板为ARM状态；LDR PC按目标地址最低位切换到Thumb
+    uint32_t* insn = reinterpret_cast<uint32_t*>(code);
+    insn[0] = 0xE59F0004;                                               // LDR R0, [PC, #4]
+    insn[1] = 0xE590F000 | static_cast<uint32_t>(entryPointOffset);     // LDR PC, [R0, #offset]
+    insn[2] = 0xE7F000F0;                                               // UDF
+    memcpy(code + 12, &hookMethod, sizeof(hookMethod));
+    return 16;
+#elif defined(__x86_64__)
+    uint32_t offset = static_cast<uint32_t>(entryPointOffset);
+    code[0] = 0x48;                                 // MOV RDI, imm64
+    code[1] = 0xBF;
+    memcpy(code + 2, &hookMethod, sizeof(hookMethod));
+    code[10] = 0xFF;                                // JMP [RDI + disp32]
+    code[11] = 0xA7;
+    memcpy(code + 12, &offset, sizeof(offset));
+    return 16;
+#elif defined(__i386__)
+    uint32_t offset = static_cast<uint32_t>(entryPointOffset);
+    code[0] = 0xB8;                                 // MOV EAX, imm32
+    memcpy(code + 1, &hookMethod, sizeof(hookMethod));
+    code[5] = 0xFF;                                 // JMP [EAX + disp32]
+    code[6] = 0xA0;
+    memcpy(code + 7, &offset, sizeof(offset));
+    return 11;
+#else
+    return 0;
+#endif
+}
+
+void* createTrampoline(void* hookMethod) {
+    uint8_t* code = static_cast<uint8_t*>(TrampolinePool::allocate(nullptr, 0));
+    if (code == nullptr) {
+        return nullptr;
+    }
+    size_t length = writeTrampoline(code, hookMethod, sLayout.entryPointOffset);
+    if (length == 0) {
+        LOGE(TAG, "ART entrypoint trampoline is not supported on this architecture");
+        TrampolinePool::free(code);
+        return nullptr;
+    }
+    __builtin___clear_cache(reinterpret_cast<char*>(code), reinterpret_cast<char*>(code) + length);
+    return code;
+}
+
+bool probeLayout(JNIEnv* env, jclass probeClass) {
+    sLayout.sdk = readSdkVersion();
+    sLayout.methodSize = kDefaultMethodSize;
+    sLayout.clearFlags = hookClearFlags(sLayout.sdk);
+    if (sLayout.sdk < kSdkR) {
+        LOGW(TAG, "Unsupported SDK %d, assuming the Android 11 ArtMethod layout", sLayout.sdk);
+    }
+
+    jmethodID idA = env->GetStaticMethodID(probeClass, ArtMethodHook::kProbeMethodA, "()V");
+    jmethodID idB = idA != nullptr ? env->GetStaticMethodID(probeClass, ArtMethodHook::kProbeMethodB, "()V") : nullptr;
+    if (idB == nullptr) {
+        env->ExceptionClear();
+        LOGE(TAG, "ArtMethod probe methods not found");
+        return false;
+    }
+    void* methodA = fromMethodId(env, probeClass, idA, JNI_TRUE);
+    void* methodB = fromMethodId(env, probeClass, idB, JNI_TRUE);
+    if (methodA == nullptr || methodB == nullptr) {
+        LOGE(TAG, "Failed to resolve ArtMethod of probe methods");
+        return false;
+    }
+
+    // 同一个类的直接方法在连续数组中按方法索引排列，两个相邻方法的地址差就是ArtMethod的大小
+    uintptr_t distance = reinterpret_cast<uintptr_t>(methodB) - reinterpret_cast<uintptr_t>(methodA);
+    if (distance >= kDefaultMethodSize && distance <= kMaxMethodSize && distance % sizeof(void*) == 0) {
+        sLayout.methodSize = distance;
+    } else {
+        LOGW(TAG, "Unexpected ArtMethod distance %zu, using default size %zu",
+             static_cast<size_t>(distance), kDefaultMethodSize);
+    }
+    sLayout.entryPointOffset = sLayout.methodSize - sizeof(void*);
+
+    // 未调用过的探测方法共用解释执行入口；两者不同说明已被编译，此时入口未知
+    void* entryA = loadEntryPoint(methodA);
+    void* entryB = loadEntryPoint(methodB);
+    sLayout.interpreterEntryPoint = entryA == entryB ? entryA : nullptr;
+
+    LOGI(TAG, "ArtMethod layout for SDK %d: size=%zu, entrypoint offset=%zu, interpreter=%p",
+         sLayout.sdk, sLayout.methodSize, sLayout.entryPointOffset, sLayout.interpreterEntryPoint);
+    return true;
+}
+
+// 已经读到旧入口的线程可能还没执行完跳板，无法确认这些线程何时离开，槽位永不归还
+void retireTrampoline(void* trampoline) {
+    if (trampoline != nullptr) {
+        LOGD(TAG, "ART trampoline %p retired permanently", trampoline);
+    }
+}
+
+void restoreTarget(const ArtHookInfo& info) {
+    storeEntryPoint(info.targetMethod, info.originalEntryPoint);
+    uint32_t changed = sLayout.clearFlags | kAccCompileDontBother;
+    uint32_t original = info.originalAccessFlags & changed;
+    updateAccessFlags(info.targetMethod, original, changed & ~original);
+}
+
+} // namespace
+
+bool ArtMethodHook::initialize(JNIEnv* env, jclass probeClass) {
+    std::lock_guard<std::mutex> lock(sArtHookMutex);
+    if (sInitialized) {
+        return true;
+    }
+
+    try {
+        jclass executableClass = env->FindClass("java/lang/reflect/Executable");
+        if (executableClass != nullptr) {
+            sArtMethodField = env->GetFieldID(executableClass, "artMethod", "J");
+            env->DeleteLocalRef(executableClass);
+        }
+        if (sArtMethodField == nullptr) {
+            env->ExceptionClear();
+            LOGW(TAG, "Executable.artMethod not accessible, relying on pointer jmethodIDs");
+        }
+
+        jclass methodClass = env->FindClass("java/lang/reflect/Method");
+        if (methodClass == nullptr) {
+            env->ExceptionClear();
+            LOGE(TAG, "java.lang.reflect.Method not found");
+            return false;
+        }
+        sMethodInvoke = env->GetMethodID(methodClass, "invoke",
+                                         "(Ljava/lang/Object;[Ljava/lang/Object;)Ljava/lang/Object;");
+        env->DeleteLocalRef(methodClass);
+        if (sMethodInvoke == nullptr) {
+            env->ExceptionClear();
+            LOGE(TAG, "Method.invoke not found");
+            return false;
+        }
+
+        if (!probeLayout(env, probeClass)) {
+            return false;
+        }
+
+        sInitialized = true;
+        return true;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception initializing ArtMethodHook: %s", e.what());
+        return false;
+    }
+}
+
+void ArtMethodHook::cleanup() {
+    std::lock_guard<std::mutex> lock(sArtHookMutex);
+    try {
+        std::vector<void*> targets;
+        sArtHooks.collectKeys(&targets);
+        for (void* target : targets) {
+            ArtHookInfo info;
+            if (sArtHooks.erase(target, &info)) {
+                restoreTarget(info);
+                retireTrampoline(info.trampoline);
+            }
+        }
+        LOGD(TAG, "Restored %zu ART method hooks", targets.size());
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception cleaning up ArtMethodHook: %s", e.what());
+    }
+}
+
+void* ArtMethodHook::getArtMethod(JNIEnv* env, jobject method) {
+    if (method == nullptr) {
+        return nullptr;
+    }
+    jmethodID id = env->FromReflectedMethod(method);
+    if (id != nullptr && (reinterpret_cast<uintptr_t>(id) & 1) == 0) {
+        return id;
+    }
+    if (sArtMethodField == nullptr) {
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(env->GetLongField(method, sArtMethodField)));
+}
+
+bool ArtMethodHook::hookMethod(JNIEnv* env, jobject targetMethod, jobject hookMethod, jobject backupMethod) {
+    if (!sInitialized) {
+        LOGE(TAG, "ArtMethodHook not initialized");
+        return false;
+    }
+
+    try {
+        void* target = getArtMethod(env, targetMethod);
+        void* hook = getArtMethod(env, hookMethod);
+        void* backup = getArtMethod(env, backupMethod);
+        if (target == nullptr || hook == nullptr || (backupMethod != nullptr && backup == nullptr)) {
+            LOGE(TAG, "Failed to resolve ArtMethod: target=%p hook=%p backup=%p", target, hook, backup);
+            return false;
+        }
+        if (target == hook || target == backup) {
+            LOGE(TAG, "Hook and backup must differ from target %p", target);
+            return false;
+        }
+
+        uint32_t targetFlags = loadAccessFlags(target);
+        if ((targetFlags & (kAccAbstract | kAccIntrinsic)) != 0) {
+            LOGE(TAG, "Cannot hook abstract or intrinsic method %p (flags 0x%x)", target, targetFlags);
+            return false;
+        }
+        if ((loadAccessFlags(hook) & kAccStatic) == 0) {
+            LOGE(TAG, "Hook method %p must be static", hook);
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(sArtHookMutex);
+        if (sArtHooks.contains(target)) {
+            LOGW(TAG, "ArtMethod already hooked: %p", target);
+            return false;
+        }
+
+        void* trampoline = createTrampoline(hook);
+        if (trampoline == nullptr) {
+            return false;
+        }
+
+        // 先禁止JIT重新编译和解释器快速路径，它们会覆盖入口或绕过入口直接进入原方法
+        updateAccessFlags(target, kAccCompileDontBother, sLayout.clearFlags);
+        void* originalEntry = loadEntryPoint(target);
+
+        if (backup != nullptr) {
+            // 备份是目标的完整拷贝，声明类和方法索引都指向原方法
+            memcpy(backup, target, sLayout.methodSize);
+            uint32_t clear = 0;
+            uint32_t set = 0;
+            if ((targetFlags & kAccStatic) == 0) {
+                // 改为私有方法，通过备份调用时直接分派而不查虚方法表
+                clear |= kAccPublic | kAccProtected;
+                set |= kAccPrivate;
+            }
+            updateAccessFlags(backup, set, clear);
+
+            // JIT代码会被回收，非native方法的备份改走解释执行
+            if ((targetFlags & kAccNative) == 0 && sLayout.interpreterEntryPoint != nullptr) {
+                storeEntryPoint(backup, sLayout.interpreterEntryPoint);
+            }
+        }
+
+        ArtHookInfo info;
+        info.targetMethod = target;
+        info.hookMethod = hook;
+        info.backupMethod = backup;
+        info.trampoline = trampoline;
+        info.originalEntryPoint = originalEntry;
+        info.originalAccessFlags = targetFlags;
+        if (!sArtHooks.insert(target, info)) {
+            LOGE(TAG, "ArtMethod hook registry full");
+            restoreTarget(info);
+            TrampolinePool::free(trampoline);
+            return false;
+        }
+
+        storeEntryPoint(target, trampoline);
+        LOGD(TAG, "ArtMethod hooked: %p -> %p (entry %p)", target, hook, originalEntry);
+        return true;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception hooking ArtMethod: %s", e.what());
+        return false;
+    }
+}
+
+bool ArtMethodHook::unhookMethod(JNIEnv* env, jobject targetMethod) {
+    try {
+        void* target = getArtMethod(env, targetMethod);
+        if (target == nullptr) {
+            return false;
+        }
+
+        std::lock_guard<std::mutex> lock(sArtHookMutex);
+        ArtHookInfo info;
+        if (!sArtHooks.erase(target, &info)) {
+            LOGW(TAG, "ArtMethod not hooked: %p", target);
+            return false;
+        }
+
+        restoreTarget(info);
+        retireTrampoline(info.trampoline);
+        LOGD(TAG, "ArtMethod unhooked: %p", target);
+        return true;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception unhooking ArtMethod: %s", e.what());
+        return false;
+    }
+}
+
+jobject ArtMethodHook::callOriginMethod(JNIEnv* env, jobject backupMethod, jobject receiver, jobjectArray args) {
+    if (!sInitialized || backupMethod == nullptr) {
+        return nullptr;
+    }
+    // 备份的ArtMethod已是原方法的拷贝，反射调用即执行原方法
+    return env->CallObjectMethod(backupMethod, sMethodInvoke, receiver, args);
+}
+
+bool ArtMethodHook::isHooked(void* artMethod) {
+    return sArtHooks.contains(artMethod);
+}
+
+size_t ArtMethodHook::getArtMethodSize() {
+    return sInitialized ? sLayout.methodSize : 0;
+}
+
+size_t ArtMethodHook::getEntryPointOffset() {
+    return sInitialized ? sLayout.entryPointOffset : 0;
+}
+
+} // namespace VirtualSpace
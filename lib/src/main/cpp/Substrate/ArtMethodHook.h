@@ -0,0 +1,80 @@
+#ifndef ART_METHOD_HOOK_H
+#define ART_METHOD_HOOK_H
+
+#include <jni.h>
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * ART方法入口替换
+ * 直接从java.lang.reflect.Method取得ArtMethod*，把目标的entry_point_from_quick_compiled_code_
+ * 改为跳板：跳板把第一个参数寄存器换成Hook方法的ArtMethod*后跳到Hook方法当前的入口，
+ * 被Hook的调用只多两条指令，不经过反射。Hook方法必须是静态方法，实例方法的this作为其第一个参数。
+ * ArtMethod的大小和入口偏移在初始化时用两个相邻方法探测一次，按系统版本缓存，探测失败时退回该版本的已知布局
+ */
+class ArtMethodHook {
+public:
+    // 探测布局用的两个相邻静态方法，由Java层SandHook声明
+    static constexpr const char* kProbeMethodA = "artMethodProbeA";
+    static constexpr const char* kProbeMethodB = "artMethodProbeB";
+
+    /**
+     * 探测ArtMethod布局，只在第一次调用时生效
+     * @param probeClass 声明探测方法的类
+     * @return 是否成功
+     */
+    static bool initialize(JNIEnv* env, jclass probeClass);
+
+    /**
+     * 取消所有Hook
+     */
+    static void cleanup();
+
+    /**
+     * 取得反射方法对应的ArtMethod*
+     * @param method java.lang.reflect.Method或Constructor
+     * @return ArtMethod*，失败返回nullptr
+     */
+    static void* getArtMethod(JNIEnv* env, jobject method);
+
+    /**
+     * Hook Java方法
+     * @param targetMethod 目标方法
+     * @param hookMethod 静态Hook方法
+     * @param backupMethod 备份方法，Hook后调用它即执行原方法，可为nullptr
+     * @return 是否成功
+     */
+    static bool hookMethod(JNIEnv* env, jobject targetMethod, jobject hookMethod, jobject backupMethod);
+
+    /**
+     * 取消Hook，恢复目标的入口和访问标志
+     */
+    static bool unhookMethod(JNIEnv* env, jobject targetMethod);
+
+    /**
+     * 通过备份方法调用原方法
+     * @return 原方法的返回值，抛出的异常保留给调用方
+     */
+    static jobject callOriginMethod(JNIEnv* env, jobject backupMethod, jobject receiver, jobjectArray args);
+
+    /**
+     * 检查ArtMethod是否已Hook
+     */
+    static bool isHooked(void* artMethod);
+
+    /**
+     * 探测得到的ArtMethod大小，未初始化时返回0
+     */
+    static size_t getArtMethodSize();
+
+    /**
+     * 探测得到的entry_point_from_quick_compiled_code_偏移，未初始化时返回0
+     */
+    static size_t getEntryPointOffset();
+};
+
+} // namespace VirtualSpace
+
+#endif // ART_METHOD_HOOK_H
@@ -0,0 +1,402 @@
+#include "ElfResolver.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#define TAG "ElfResolver"
+
+namespace VirtualSpace {
+
+namespace {
+
+#if defined(__LP64__)
+constexpr unsigned char kElfClass = ELFCLASS64;
+#define ELF_ST_TYPE(info) ELF64_ST_TYPE(info)
+#else
+constexpr unsigned char kElfClass = ELFCLASS32;
+#define ELF_ST_TYPE(info) ELF32_ST_TYPE(info)
+#endif
+
+constexpr uint32_t kBloomBits = sizeof(ElfW(Addr)) * 8;
+constexpr ElfW(Half) kVersymHidden = 0x8000;
+
+// bionic不会就地重定位.dynamic，其中的地址需要加上装载偏移
+inline uintptr_t dynamicAddress(uintptr_t bias, ElfW(Addr) value) {
+    return value < bias ? bias + value : value;
+}
+
+inline uint32_t gnuHashOf(const char* name) {
+    uint32_t hash = 5381;
+    for (const unsigned char* p = reinterpret_cast<const unsigned char*>(name); *p != '\0'; p++) {
+        hash = hash * 33 + *p;
+    }
+    return hash;
+}
+
+inline uint32_t sysvHashOf(const char* name) {
+    uint32_t hash = 0;
+    for (const unsigned char* p = reinterpret_cast<const unsigned char*>(name); *p != '\0'; p++) {
+        hash = (hash << 4) + *p;
+        uint32_t high = hash & 0xf0000000;
+        hash ^= high;
+        hash ^= high >> 24;
+    }
+    return hash;
+}
+
+// 只接受已定义的函数和数据；IFUNC需要运行解析函数，交给调用方退回dlsym
+inline bool isResolvable(const ElfW(Sym)& symbol) {
+    if (symbol.st_shndx == SHN_UNDEF || symbol.st_value == 0) {
+        return false;
+    }
+    unsigned type = ELF_ST_TYPE(symbol.st_info);
+    return type == STT_FUNC || type == STT_OBJECT || type == STT_NOTYPE;
+}
+
+} // namespace
+
+ElfResolver* ElfResolver::sInstance = nullptr;
+std::mutex ElfResolver::sMutex;
+
+ElfResolver::ElfResolver() {
+    LOGD(TAG, "ElfResolver constructor");
+}
+
+ElfResolver::~ElfResolver() {
+    LOGD(TAG, "ElfResolver destructor");
+}
+
+ElfResolver* ElfResolver::getInstance() {
+    if (sInstance == nullptr) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (sInstance == nullptr) {
+            sInstance = new ElfResolver();
+        }
+    }
+    return sInstance;
+}
+
+size_t ElfResolver::resolve(const char* library, SymbolRequest* requests, size_t count) {
+    if (library == nullptr || requests == nullptr || count == 0) {
+        return 0;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        for (size_t i = 0; i < count; i++) {
+            requests[i].address = nullptr;
+        }
+
+        Image* image = findImage(library);
+        if (image == nullptr) {
+            LOGW(TAG, "Image not loaded: %s", library);
+            return 0;
+        }
+
+        // 先走哈希表查找导出符号，全部命中时不会加载.symtab
+        size_t resolved = 0;
+        for (size_t i = 0; i < count; i++) {
+            void* address = lookupDynamic(*image, requests[i].name);
+            if (address == nullptr) {
+                address = lookupLocal(image, requests[i].name);
+            }
+            if (address != nullptr) {
+                requests[i].address = address;
+                resolved++;
+            }
+        }
+
+        LOGD(TAG, "Resolved %zu/%zu symbols in %s", resolved, count, library);
+        return resolved;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception resolving symbols: %s", e.what());
+        return 0;
+    }
+}
+
+void* ElfResolver::findSymbol(const char* library, const char* name) {
+    SymbolRequest request = {name, nullptr};
+    resolve(library, &request, 1);
+    return request.address;
+}
+
+void ElfResolver::retainImages(const std::vector<uintptr_t>& present) {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mImages.erase(std::remove_if(mImages.begin(), mImages.end(),
+                                 [&present](const std::unique_ptr<Image>& image) {
+                                     return !std::binary_search(present.begin(), present.end(), image->bias);
+                                 }),
+                  mImages.end());
+}
+
+void ElfResolver::clear() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mImages.clear();
+}
+
+bool ElfResolver::matchLibrary(const char* path, const char* library) {
+    if (path == nullptr || path[0] == '\0') {
+        return false;
+    }
+    size_t pathLength = strlen(path);
+    size_t libraryLength = strlen(library);
+    if (pathLength < libraryLength || strcmp(path + pathLength - libraryLength, library) != 0) {
+        return false;
+    }
+    // 必须从路径分隔符处开始匹配，避免"libc.so"匹配到"libxyzc.so"
+    return pathLength == libraryLength || path[pathLength - libraryLength - 1] == '/' || library[0] == '/';
+}
+
+ElfResolver::Image* ElfResolver::findImage(const char* library) {
+    for (const std::unique_ptr<Image>& image : mImages) {
+        if (matchLibrary(image->path.c_str(), library)) {
+            return image.get();
+        }
+    }
+
+    FindContext context;
+    context.library = library;
+    dl_iterate_phdr(findImageCallback, &context);
+    if (context.image == nullptr) {
+        return nullptr;
+    }
+
+    mImages.push_back(std::move(context.image));
+    return mImages.back().get();
+}
+
+int ElfResolver::findImageCallback(struct dl_phdr_info* info, size_t /* size */, void* data) {
+    FindContext* context = static_cast<FindContext*>(data);
+    if (!matchLibrary(info->dlpi_name, context->library)) {
+        return 0;
+    }
+
+    std::unique_ptr<Image> image(new Image());
+    image->path = info->dlpi_name;
+    image->bias = info->dlpi_addr;
+    image->dynsym = nullptr;
+    image->dynstr = nullptr;
+    image->versym = nullptr;
+    image->gnuHash = nullptr;
+    image->sysvHash = nullptr;
+    image->symtabLoaded = false;
+    if (!parseDynamic(info, image.get())) {
+        LOGW(TAG, "No symbol table in %s", info->dlpi_name);
+        return 0;
+    }
+
+    context->image = std::move(image);
+    return 1;
+}
+
+bool ElfResolver::parseDynamic(const struct dl_phdr_info* info, Image* image) {
+    uintptr_t bias = info->dlpi_addr;
+
+    const ElfW(Dyn)* dynamic = nullptr;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        if (info->dlpi_phdr[i].p_type == PT_DYNAMIC) {
+            dynamic = reinterpret_cast<const ElfW(Dyn)*>(bias + info->dlpi_phdr[i].p_vaddr);
+            break;
+        }
+    }
+    if (dynamic == nullptr) {
+        return false;
+    }
+
+    for (const ElfW(Dyn)* dyn = dynamic; dyn->d_tag != DT_NULL; dyn++) {
+        switch (dyn->d_tag) {
+            case DT_SYMTAB:
+                image->dynsym = reinterpret_cast<const ElfW(Sym)*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_STRTAB:
+                image->dynstr = reinterpret_cast<const char*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_VERSYM:
+                image->versym = reinterpret_cast<const ElfW(Half)*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_GNU_HASH:
+                image->gnuHash = reinterpret_cast<const uint32_t*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_HASH:
+                image->sysvHash = reinterpret_cast<const uint32_t*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            default:
+                break;
+        }
+    }
+
+    return image->dynsym != nullptr && image->dynstr != nullptr &&
+           (image->gnuHash != nullptr || image->sysvHash != nullptr);
+}
+
+void* ElfResolver::lookupDynamic(const Image& image, const char* name) const {
+    if (image.gnuHash != nullptr) {
+        const uint32_t* table = image.gnuHash;
+        uint32_t bucketCount = table[0];
+        uint32_t symbolOffset = table[1];
+        uint32_t bloomSize = table[2];
+        uint32_t bloomShift = table[3];
+        const ElfW(Addr)* bloom = reinterpret_cast<const ElfW(Addr)*>(table + 4);
+        const uint32_t* buckets = reinterpret_cast<const uint32_t*>(bloom + bloomSize);
+        const uint32_t* chain = buckets + bucketCount;
+        if (bucketCount == 0 || bloomSize == 0) {
+            return nullptr;
+        }
+
+        // 布隆过滤器先排除绝大多数不存在的符号
+        uint32_t hash = gnuHashOf(name);
+        ElfW(Addr) word = bloom[(hash / kBloomBits) % bloomSize];
+        ElfW(Addr) mask = (static_cast<ElfW(Addr)>(1) << (hash % kBloomBits)) |
+                          (static_cast<ElfW(Addr)>(1) << ((hash >> bloomShift) % kBloomBits));
+        if ((word & mask) != mask) {
+            return nullptr;
+        }
+
+        uint32_t index = buckets[hash % bucketCount];
+        if (index < symbolOffset) {
+            return nullptr;
+        }
+        for (;; index++) {
+            uint32_t chainHash = chain[index - symbolOffset];
+            if ((chainHash | 1) == (hash | 1)) {
+                bool matched = false;
+                void* address = matchDynamic(image, index, name, &matched);
+                if (matched) {
+                    return address;
+                }
+            }
+            if ((chainHash & 1) != 0) {
+                break;
+            }
+        }
+        return nullptr;
+    }
+
+    const uint32_t* table = image.sysvHash;
+    uint32_t bucketCount = table[0];
+    const uint32_t* buckets = table + 2;
+    const uint32_t* chain = buckets + bucketCount;
+    if (bucketCount == 0) {
+        return nullptr;
+    }
+
+    for (uint32_t index = buckets[sysvHashOf(name) % bucketCount]; index != STN_UNDEF; index = chain[index]) {
+        bool matched = false;
+        void* address = matchDynamic(image, index, name, &matched);
+        if (matched) {
+            return address;
+        }
+    }
+    return nullptr;
+}
+
+void* ElfResolver::matchDynamic(const Image& image, uint32_t index, const char* name, bool* matched) const {
+    const ElfW(Sym)& symbol = image.dynsym[index];
+    if (strcmp(name, image.dynstr + symbol.st_name) != 0) {
+        return nullptr;
+    }
+    // 同名的旧版本符号只供按版本链接的调用方使用，跳过后继续找默认版本
+    if (image.versym != nullptr && (image.versym[index] & kVersymHidden) != 0) {
+        return nullptr;
+    }
+    *matched = true;
+    return isResolvable(symbol) ? reinterpret_cast<void*>(image.bias + symbol.st_value) : nullptr;
+}
+
+void* ElfResolver::lookupLocal(Image* image, const char* name) {
+    if (!image->symtabLoaded) {
+        loadSymtab(image);
+    }
+
+    const std::vector<LocalSymbol>& symbols = image->localSymbols;
+    const char* pool = image->namePool.c_str();
+    auto it = std::lower_bound(symbols.begin(), symbols.end(), name,
+                               [pool](const LocalSymbol& symbol, const char* key) {
+                                   return strcmp(pool + symbol.nameOffset, key) < 0;
+                               });
+    if (it == symbols.end() || strcmp(pool + it->nameOffset, name) != 0) {
+        return nullptr;
+    }
+    return reinterpret_cast<void*>(image->bias + it->value);
+}
+
+void ElfResolver::loadSymtab(Image* image) {
+    // 无论成功与否只尝试一次，镜像被strip时不会反复读文件
+    image->symtabLoaded = true;
+
+    int fd = open(image->path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGW(TAG, "Failed to open %s: %s", image->path.c_str(), strerror(errno));
+        return;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(ElfW(Ehdr)))) {
+        close(fd);
+        return;
+    }
+
+    size_t fileSize = static_cast<size_t>(st.st_size);
+    void* base = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        LOGW(TAG, "Failed to map %s: %s", image->path.c_str(), strerror(errno));
+        return;
+    }
+
+    const char* file = static_cast<const char*>(base);
+    const ElfW(Ehdr)* header = reinterpret_cast<const ElfW(Ehdr)*>(file);
+    bool valid = memcmp(header->e_ident, ELFMAG, SELFMAG) == 0 && header->e_ident[EI_CLASS] == kElfClass &&
+                 header->e_shentsize == sizeof(ElfW(Shdr)) && header->e_shoff != 0 &&
+                 header->e_shoff + static_cast<size_t>(header->e_shnum) * sizeof(ElfW(Shdr)) <= fileSize;
+
+    const ElfW(Shdr)* sections = valid ? reinterpret_cast<const ElfW(Shdr)*>(file + header->e_shoff) : nullptr;
+    for (int i = 0; valid && i < header->e_shnum; i++) {
+        const ElfW(Shdr)& section = sections[i];
+        if (section.sh_type != SHT_SYMTAB || section.sh_link >= header->e_shnum) {
+            continue;
+        }
+        const ElfW(Shdr)& strings = sections[section.sh_link];
+        if (section.sh_offset + section.sh_size > fileSize || strings.sh_offset + strings.sh_size > fileSize ||
+            strings.sh_size == 0) {
+            break;
+        }
+
+        const ElfW(Sym)* symbols = reinterpret_cast<const ElfW(Sym)*>(file + section.sh_offset);
+        const char* names = file + strings.sh_offset;
+        size_t symbolCount = section.sh_size / sizeof(ElfW(Sym));
+        for (size_t j = 0; j < symbolCount; j++) {
+            const ElfW(Sym)& symbol = symbols[j];
+            if (!isResolvable(symbol) || symbol.st_name == 0 || symbol.st_name >= strings.sh_size) {
+                continue;
+            }
+            const char* name = names + symbol.st_name;
+            size_t length = strnlen(name, strings.sh_size - symbol.st_name);
+            image->localSymbols.push_back({static_cast<uint32_t>(image->namePool.size()),
+                                           static_cast<uintptr_t>(symbol.st_value)});
+            image->namePool.append(name, length);
+            image->namePool.push_back('\0');
+        }
+        break;
+    }
+    munmap(base, fileSize);
+
+    const char* pool = image->namePool.c_str();
+    std::sort(image->localSymbols.begin(), image->localSymbols.end(),
+              [pool](const LocalSymbol& a, const LocalSymbol& b) {
+                  return strcmp(pool + a.nameOffset, pool + b.nameOffset) < 0;
+              });
+
+    LOGD(TAG, "Loaded %zu local symbols from %s", image->localSymbols.size(), image->path.c_str());
+}
+
+} // namespace VirtualSpace
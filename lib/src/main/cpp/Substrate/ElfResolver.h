@@ -0,0 +1,109 @@
+#ifndef ELF_RESOLVER_H
+#define ELF_RESOLVER_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <link.h>
+
+namespace VirtualSpace {
+
+/**
+ * ELF符号解析器
+ * 通过dl_iterate_phdr找到已加载镜像，直接读取内存中的.gnu.hash/.dynsym查找导出符号，
+ * 不经过dlsym的命名空间检查。每个镜像只解析一次并缓存；
+ * .dynsym中找不到的隐藏/内部符号再从磁盘文件的.symtab中查找，该表在首次未命中时才加载
+ */
+class ElfResolver {
+public:
+    // 批量解析请求
+    struct SymbolRequest {
+        const char* name;
+        void* address;      // 输出，未找到时为nullptr
+    };
+
+    static ElfResolver* getInstance();
+
+    /**
+     * 在指定镜像中批量解析符号，整批只查找一次镜像
+     * @param library 镜像文件名或路径后缀，如"libc.so"、"libart.so"
+     * @param requests 请求数组，结果写回address
+     * @param count 请求数量
+     * @return 解析成功的数量
+     */
+    size_t resolve(const char* library, SymbolRequest* requests, size_t count);
+
+    /**
+     * 解析单个符号
+     * @return 符号地址，未找到时返回nullptr
+     */
+    void* findSymbol(const char* library, const char* name);
+
+    /**
+     * 丢弃已卸载镜像的缓存
+     * @param present 当前仍然加载的镜像装载地址，有序
+     */
+    void retainImages(const std::vector<uintptr_t>& present);
+
+    /**
+     * 清空所有缓存
+     */
+    void clear();
+
+private:
+    ElfResolver();
+    ~ElfResolver();
+
+    // 禁用拷贝构造和赋值
+    ElfResolver(const ElfResolver&) = delete;
+    ElfResolver& operator=(const ElfResolver&) = delete;
+
+    // 单例相关
+    static ElfResolver* sInstance;
+    static std::mutex sMutex;
+
+    // .symtab中的符号，名字存放在namePool中，按名字排序
+    struct LocalSymbol {
+        uint32_t nameOffset;
+        uintptr_t value;
+    };
+
+    // 已解析镜像的缓存
+    struct Image {
+        std::string path;
+        uintptr_t bias;
+        const ElfW(Sym)* dynsym;
+        const char* dynstr;
+        const ElfW(Half)* versym;   // 可为nullptr
+        const uint32_t* gnuHash;
+        const uint32_t* sysvHash;
+        bool symtabLoaded;
+        std::vector<LocalSymbol> localSymbols;
+        std::string namePool;
+    };
+
+    struct FindContext {
+        const char* library;
+        std::unique_ptr<Image> image;
+    };
+
+    static int findImageCallback(struct dl_phdr_info* info, size_t size, void* data);
+    static bool matchLibrary(const char* path, const char* library);
+    static bool parseDynamic(const struct dl_phdr_info* info, Image* image);
+
+    Image* findImage(const char* library);
+    void* lookupDynamic(const Image& image, const char* name) const;
+    void* matchDynamic(const Image& image, uint32_t index, const char* name, bool* matched) const;
+    void* lookupLocal(Image* image, const char* name);
+    void loadSymtab(Image* image);
+
+    std::mutex mMutex;
+    std::vector<std::unique_ptr<Image>> mImages;
+};
+
+} // namespace VirtualSpace
+
+#endif // ELF_RESOLVER_H
@@ -0,0 +1,250 @@
+#ifndef HOOK_REGISTRY_H
+#define HOOK_REGISTRY_H
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <type_traits>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+namespace VirtualSpace {
+
+/**
+ * Hook注册表
+ * 以目标地址为键的分片开放寻址哈希表。键数组与值数组分开存放，
+ * 探测只读键所在的缓存行；读取无锁，值通过每个槽位的序列锁保证一致，
+ * 写入按分片加锁。容量固定为kShardCount * kShardCapacity
+ */
+template <typename Value>
+class HookRegistry {
+    static_assert(std::is_trivially_copyable<Value>::value, "HookRegistry value must be trivially copyable");
+
+public:
+    static constexpr size_t kShardCount = 8;
+    static constexpr size_t kShardCapacity = 128;
+
+    HookRegistry() : mCount(0) {
+        for (Shard& shard : mShards) {
+            for (size_t i = 0; i < kShardCapacity; i++) {
+                shard.keys[i].store(kEmptyKey, std::memory_order_relaxed);
+                shard.sequences[i].store(0, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // 禁用拷贝构造和赋值
+    HookRegistry(const HookRegistry&) = delete;
+    HookRegistry& operator=(const HookRegistry&) = delete;
+
+    /**
+     * 插入表项
+     * @return 是否成功（键已存在或分片已满时返回false）
+     */
+    bool insert(void* key, const Value& value) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(key);
+        if (address == kEmptyKey || address == kDeletedKey) {
+            return false;
+        }
+
+        uint64_t hash = hashKey(address);
+        Shard& shard = mShards[shardIndex(hash)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        size_t freeSlot = kShardCapacity;
+        size_t index = hash & (kShardCapacity - 1);
+        for (size_t probe = 0; probe < kShardCapacity; probe++, index = (index + 1) & (kShardCapacity - 1)) {
+            uintptr_t current = shard.keys[index].load(std::memory_order_relaxed);
+            if (current == address) {
+                return false;
+            }
+            if (current == kDeletedKey) {
+                if (freeSlot == kShardCapacity) {
+                    freeSlot = index;
+                }
+                continue;
+            }
+            if (current == kEmptyKey) {
+                if (freeSlot == kShardCapacity) {
+                    freeSlot = index;
+                }
+                break;
+            }
+        }
+        if (freeSlot == kShardCapacity) {
+            return false;
+        }
+
+        // 先写值再发布键，读者在键可见之前不会访问该槽位
+        writeValue(shard, freeSlot, value);
+        shard.keys[freeSlot].store(address, std::memory_order_release);
+        mCount.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * 无锁查找
+     * @param value 输出表项，可为nullptr
+     */
+    bool find(void* key, Value* value) const {
+        uintptr_t address = reinterpret_cast<uintptr_t>(key);
+        uint64_t hash = hashKey(address);
+        const Shard& shard = mShards[shardIndex(hash)];
+
+        size_t index = hash & (kShardCapacity - 1);
+        for (size_t probe = 0; probe < kShardCapacity; probe++, index = (index + 1) & (kShardCapacity - 1)) {
+            uintptr_t current = shard.keys[index].load(std::memory_order_acquire);
+            if (current == kEmptyKey) {
+                return false;
+            }
+            if (current != address) {
+                continue;
+            }
+            if (value == nullptr) {
+                return true;
+            }
+            readValue(shard, index, value);
+            // 读取期间被删除或复用时视为不存在
+            return shard.keys[index].load(std::memory_order_acquire) == address;
+        }
+        return false;
+    }
+
+    bool contains(void* key) const {
+        return find(key, nullptr);
+    }
+
+    /**
+     * 更新已有表项，读者在更新期间看到旧值或新值
+     * @return 是否成功（键不存在时返回false）
+     */
+    bool update(void* key, const Value& value) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(key);
+        uint64_t hash = hashKey(address);
+        Shard& shard = mShards[shardIndex(hash)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        size_t index = hash & (kShardCapacity - 1);
+        for (size_t probe = 0; probe < kShardCapacity; probe++, index = (index + 1) & (kShardCapacity - 1)) {
+            uintptr_t current = shard.keys[index].load(std::memory_order_relaxed);
+            if (current == kEmptyKey) {
+                return false;
+            }
+            if (current == address) {
+                writeValue(shard, index, value);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * 删除表项
+     * @param value 输出被删除的表项，可为nullptr
+     */
+    bool erase(void* key, Value* value) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(key);
+        uint64_t hash = hashKey(address);
+        Shard& shard = mShards[shardIndex(hash)];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        size_t index = hash & (kShardCapacity - 1);
+        for (size_t probe = 0; probe < kShardCapacity; probe++, index = (index + 1) & (kShardCapacity - 1)) {
+            uintptr_t current = shard.keys[index].load(std::memory_order_relaxed);
+            if (current == kEmptyKey) {
+                return false;
+            }
+            if (current != address) {
+                continue;
+            }
+            if (value != nullptr) {
+                memcpy(value, &shard.values[index], sizeof(Value));
+            }
+            shard.keys[index].store(kDeletedKey, std::memory_order_release);
+            mCount.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * 收集所有键
+     */
+    void collectKeys(std::vector<void*>* keys) const {
+        for (const Shard& shard : mShards) {
+            for (size_t i = 0; i < kShardCapacity; i++) {
+                uintptr_t current = shard.keys[i].load(std::memory_order_acquire);
+                if (current != kEmptyKey && current != kDeletedKey) {
+                    keys->push_back(reinterpret_cast<void*>(current));
+                }
+            }
+        }
+    }
+
+    /**
+     * 清空所有表项，同时回收删除标记
+     */
+    void clear() {
+        for (Shard& shard : mShards) {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (size_t i = 0; i < kShardCapacity; i++) {
+                shard.keys[i].store(kEmptyKey, std::memory_order_release);
+            }
+        }
+        mCount.store(0, std::memory_order_relaxed);
+    }
+
+    size_t size() const {
+        return mCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    static constexpr uintptr_t kEmptyKey = 0;
+    static constexpr uintptr_t kDeletedKey = 1;
+
+    struct alignas(64) Shard {
+        std::atomic<uintptr_t> keys[kShardCapacity];
+        std::atomic<uint32_t> sequences[kShardCapacity];
+        Value values[kShardCapacity];
+        std::mutex mutex;
+    };
+
+    static inline uint64_t hashKey(uintptr_t address) {
+        // 指令地址低位对齐，先去掉再做乘法散列
+        return (static_cast<uint64_t>(address) >> 2) * 0x9E3779B97F4A7C15ULL;
+    }
+
+    static inline size_t shardIndex(uint64_t hash) {
+        return static_cast<size_t>(hash >> 61) & (kShardCount - 1);
+    }
+
+    static void writeValue(Shard& shard, size_t index, const Value& value) {
+        uint32_t sequence = shard.sequences[index].load(std::memory_order_relaxed);
+        shard.sequences[index].store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&shard.values[index], &value, sizeof(Value));
+        shard.sequences[index].store(sequence + 2, std::memory_order_release);
+    }
+
+    static void readValue(const Shard& shard, size_t index, Value* value) {
+        while (true) {
+            uint32_t before = shard.sequences[index].load(std::memory_order_acquire);
+            if ((before & 1) != 0) {
+                continue;
+            }
+            memcpy(value, &shard.values[index], sizeof(Value));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (shard.sequences[index].load(std::memory_order_relaxed) == before) {
+                return;
+            }
+        }
+    }
+
+    Shard mShards[kShardCount];
+    std::atomic<size_t> mCount;
+};
+
+} // namespace VirtualSpace
+
+#endif // HOOK_REGISTRY_H
@@ -0,0 +1,569 @@
+#include "PltHook.h"
+#include "ElfResolver.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <link.h>
+#include <elf.h>
+#include <dlfcn.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+
+#define TAG "PltHook"
+
+namespace VirtualSpace {
+
+namespace {
+
+#if defined(__LP64__)
+typedef ElfW(Rela) ElfRel;
+#define ELF_R_SYM(info) ELF64_R_SYM(info)
+#define ELF_R_TYPE(info) ELF64_R_TYPE(info)
+#else
+typedef ElfW(Rel) ElfRel;
+#define ELF_R_SYM(info) ELF32_R_SYM(info)
+#define ELF_R_TYPE(info) ELF32_R_TYPE(info)
+#endif
+
+#if defined(__aarch64__)
+constexpr uint32_t kRelocJumpSlot = R_AARCH64_JUMP_SLOT;
+constexpr uint32_t kRelocGlobDat = R_AARCH64_GLOB_DAT;
+constexpr uint32_t kRelocAbs = R_AARCH64_ABS64;
+#elif defined(__arm__)
+constexpr uint32_t kRelocJumpSlot = R_ARM_JUMP_SLOT;
+constexpr uint32_t kRelocGlobDat = R_ARM_GLOB_DAT;
+constexpr uint32_t kRelocAbs = R_ARM_ABS32;
+#elif defined(__x86_64__)
+constexpr uint32_t kRelocJumpSlot = R_X86_64_JUMP_SLOT;
+constexpr uint32_t kRelocGlobDat = R_X86_64_GLOB_DAT;
+constexpr uint32_t kRelocAbs = R_X86_64_64;
+#elif defined(__i386__)
+constexpr uint32_t kRelocJumpSlot = R_386_JMP_SLOT;
+constexpr uint32_t kRelocGlobDat = R_386_GLOB_DAT;
+constexpr uint32_t kRelocAbs = R_386_32;
+#endif
+
+inline uintptr_t pageStart(uintptr_t address) {
+    return address & ~(static_cast<uintptr_t>(getpagesize()) - 1);
+}
+
+inline uintptr_t pageEnd(uintptr_t address) {
+    return pageStart(address + getpagesize() - 1);
+}
+
+// 段权限转换为mprotect参数
+inline int segmentProtection(ElfW(Word) flags) {
+    return ((flags & PF_R) != 0 ? PROT_READ : 0) |
+           ((flags & PF_W) != 0 ? PROT_WRITE : 0) |
+           ((flags & PF_X) != 0 ? PROT_EXEC : 0);
+}
+
+// 页所在段重定位完成后的保护属性：RELRO为只读，其余取PT_LOAD的权限，不属于任何段时返回-1
+int pageProtection(const struct dl_phdr_info* info, uintptr_t page) {
+    uintptr_t bias = info->dlpi_addr;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type == PT_GNU_RELRO && page >= pageStart(bias + phdr.p_vaddr) &&
+            page < pageEnd(bias + phdr.p_vaddr + phdr.p_memsz)) {
+            return PROT_READ;
+        }
+    }
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type == PT_LOAD && page >= pageStart(bias + phdr.p_vaddr) &&
+            page < pageEnd(bias + phdr.p_vaddr + phdr.p_memsz)) {
+            return segmentProtection(phdr.p_flags);
+        }
+    }
+    return -1;
+}
+
+// bionic不会就地重定位.dynamic，其中的地址需要加上装载偏移
+inline uintptr_t dynamicAddress(uintptr_t bias, ElfW(Addr) value) {
+    return value < bias ? bias + value : value;
+}
+
+// 本库内的任意地址，用于识别并跳过自身
+void selfAnchor() {}
+
+inline bool entryLess(const PltHook::HookEntry& a, const PltHook::HookEntry& b) {
+    return strcmp(a.symbol, b.symbol) < 0;
+}
+
+// 在按符号名排序的表中查找
+const PltHook::HookEntry* findEntry(const std::vector<PltHook::HookEntry>& entries, const char* symbol) {
+    size_t low = 0;
+    size_t high = entries.size();
+    while (low < high) {
+        size_t mid = low + (high - low) / 2;
+        int result = strcmp(symbol, entries[mid].symbol);
+        if (result == 0) {
+            return &entries[mid];
+        }
+        if (result < 0) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+    return nullptr;
+}
+
+// 原始加载器函数；android_dlopen_ext的扩展参数只透传，用const void*避免依赖dlext.h
+void* (*sOrigDlopen)(const char*, int) = nullptr;
+void* (*sOrigAndroidDlopenExt)(const char*, int, const void*) = nullptr;
+int (*sOrigDlclose)(void*) = nullptr;
+
+// Android 8.0起链接器按调用者地址选择命名空间，能找到时带上真实调用者
+void* (*sLoaderDlopen)(const char*, int, const void*) = nullptr;
+void* (*sLoaderAndroidDlopenExt)(const char*, int, const void*, const void*) = nullptr;
+
+void* newDlopen(const char* filename, int flags) {
+    const void* caller = __builtin_return_address(0);
+    void* handle = sLoaderDlopen != nullptr ? sLoaderDlopen(filename, flags, caller)
+                                            : sOrigDlopen(filename, flags);
+    if (handle != nullptr) {
+        PltHook::getInstance()->onImagesLoaded();
+    }
+    return handle;
+}
+
+void* newAndroidDlopenExt(const char* filename, int flags, const void* extinfo) {
+    const void* caller = __builtin_return_address(0);
+    void* handle = sLoaderAndroidDlopenExt != nullptr ? sLoaderAndroidDlopenExt(filename, flags, extinfo, caller)
+                                                      : sOrigAndroidDlopenExt(filename, flags, extinfo);
+    if (handle != nullptr) {
+        PltHook::getInstance()->onImagesLoaded();
+    }
+    return handle;
+}
+
+int newDlclose(void* handle) {
+    int result = sOrigDlclose(handle);
+    if (result == 0) {
+        PltHook::getInstance()->onImagesUnloaded();
+    }
+    return result;
+}
+
+// 把加载器Hook追加到表中，原函数取导出地址
+void appendLoaderHooks(std::vector<PltHook::HookEntry>* entries) {
+    sOrigDlopen = reinterpret_cast<void* (*)(const char*, int)>(dlsym(RTLD_DEFAULT, "dlopen"));
+    sOrigAndroidDlopenExt = reinterpret_cast<void* (*)(const char*, int, const void*)>(
+        dlsym(RTLD_DEFAULT, "android_dlopen_ext"));
+    sOrigDlclose = reinterpret_cast<int (*)(void*)>(dlsym(RTLD_DEFAULT, "dlclose"));
+    sLoaderDlopen = reinterpret_cast<void* (*)(const char*, int, const void*)>(
+        dlsym(RTLD_DEFAULT, "__loader_dlopen"));
+    sLoaderAndroidDlopenExt = reinterpret_cast<void* (*)(const char*, int, const void*, const void*)>(
+        dlsym(RTLD_DEFAULT, "__loader_android_dlopen_ext"));
+
+    if (sOrigDlopen != nullptr) {
+        entries->push_back({"dlopen", reinterpret_cast<void*>(newDlopen)});
+    }
+    if (sOrigAndroidDlopenExt != nullptr) {
+        entries->push_back({"android_dlopen_ext", reinterpret_cast<void*>(newAndroidDlopenExt)});
+    }
+    if (sOrigDlclose != nullptr) {
+        entries->push_back({"dlclose", reinterpret_cast<void*>(newDlclose)});
+    }
+}
+
+} // namespace
+
+PltHook* PltHook::sInstance = nullptr;
+std::mutex PltHook::sMutex;
+
+PltHook::PltHook() : mSelfBase(0), mLoaderHooked(false) {
+    LOGD(TAG, "PltHook constructor");
+}
+
+PltHook::~PltHook() {
+    LOGD(TAG, "PltHook destructor");
+    unhookAll();
+}
+
+PltHook* PltHook::getInstance() {
+    if (sInstance == nullptr) {
+        std::lock_guard<std::mutex> lock(sMutex);
+        if (sInstance == nullptr) {
+            sInstance = new PltHook();
+        }
+    }
+    return sInstance;
+}
+
+int PltHook::hookAll(const HookEntry* entries, size_t count) {
+    if (entries == nullptr || count == 0) {
+        return 0;
+    }
+
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // 首次安装时一并拦截加载器，之后加载的镜像由onImagesLoaded()处理
+        std::vector<HookEntry> added(entries, entries + count);
+        if (!mLoaderHooked) {
+            appendLoaderHooks(&added);
+            mLoaderHooked = true;
+        }
+        std::sort(added.begin(), added.end(), entryLess);
+        mergeEntries(added);
+
+        // 已处理过的镜像只改写新增表项，其余镜像按完整Hook表改写
+        IterateContext context;
+        context.self = this;
+        context.entries = &added;
+        context.newImagesOnly = false;
+        context.patched = 0;
+
+        dl_iterate_phdr(iterateCallback, &context);
+
+        LOGD(TAG, "Patched %d GOT slots for %zu symbols", context.patched, count);
+        return context.patched;
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception hooking PLT: %s", e.what());
+        return -1;
+    }
+}
+
+void PltHook::onImagesLoaded() {
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mEntries.empty()) {
+            return;
+        }
+
+        // 遍历镜像列表只比较装载地址，ELF解析和改写只发生在新镜像上
+        IterateContext context;
+        context.self = this;
+        context.entries = &mEntries;
+        context.newImagesOnly = true;
+        context.patched = 0;
+
+        dl_iterate_phdr(iterateCallback, &context);
+
+        if (context.patched > 0) {
+            LOGD(TAG, "Patched %d GOT slots in newly loaded images", context.patched);
+        }
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception hooking loaded images: %s", e.what());
+    }
+}
+
+void PltHook::onImagesUnloaded() {
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+        if (mHookedImages.empty()) {
+            return;
+        }
+
+        std::vector<uintptr_t> present;
+        dl_iterate_phdr(collectImageCallback, &present);
+        std::sort(present.begin(), present.end());
+        ElfResolver::getInstance()->retainImages(present);
+
+        // 卸载后同一地址可能装入别的镜像，必须当作新镜像重新处理
+        auto unloaded = [&present](uintptr_t image) {
+            return !std::binary_search(present.begin(), present.end(), image);
+        };
+        mHookedImages.erase(std::remove_if(mHookedImages.begin(), mHookedImages.end(), unloaded),
+                            mHookedImages.end());
+        mPatchedSlots.erase(std::remove_if(mPatchedSlots.begin(), mPatchedSlots.end(),
+                                           [&unloaded](const PatchedSlot& patched) {
+                                               return unloaded(patched.image);
+                                           }),
+                            mPatchedSlots.end());
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception pruning unloaded images: %s", e.what());
+    }
+}
+
+void PltHook::mergeEntries(const std::vector<HookEntry>& entries) {
+    // 同名符号以新表项为准
+    std::vector<HookEntry> merged;
+    merged.reserve(mEntries.size() + entries.size());
+    size_t i = 0;
+    size_t j = 0;
+    while (i < mEntries.size() || j < entries.size()) {
+        if (j == entries.size() || (i < mEntries.size() && entryLess(mEntries[i], entries[j]))) {
+            merged.push_back(mEntries[i++]);
+        } else {
+            if (i < mEntries.size() && !entryLess(entries[j], mEntries[i])) {
+                i++;
+            }
+            merged.push_back(entries[j++]);
+        }
+    }
+    mEntries.swap(merged);
+}
+
+bool PltHook::isImageHooked(uintptr_t image) const {
+    return std::binary_search(mHookedImages.begin(), mHookedImages.end(), image);
+}
+
+void PltHook::unhookAll() {
+    try {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (mPatchedSlots.empty()) {
+            return;
+        }
+
+        // 按地址排序，同一页只改一次保护属性，恢复后还原为该页原本的权限
+        std::sort(mPatchedSlots.begin(), mPatchedSlots.end(),
+                  [](const PatchedSlot& a, const PatchedSlot& b) { return a.slot < b.slot; });
+
+        size_t i = 0;
+        while (i < mPatchedSlots.size()) {
+            uintptr_t page = pageStart(reinterpret_cast<uintptr_t>(mPatchedSlots[i].slot));
+            int protection = mPatchedSlots[i].protection;
+            size_t j = i + 1;
+            while (j < mPatchedSlots.size() &&
+                   pageStart(reinterpret_cast<uintptr_t>(mPatchedSlots[j].slot)) == page) {
+                j++;
+            }
+
+            bool writable = (protection & PROT_WRITE) != 0;
+            if (!writable && mprotect(reinterpret_cast<void*>(page), getpagesize(), protection | PROT_WRITE) != 0) {
+                LOGE(TAG, "Failed to unprotect GOT page %p: %s", reinterpret_cast<void*>(page), strerror(errno));
+                i = j;
+                continue;
+            }
+            for (size_t k = i; k < j; k++) {
+                __atomic_store_n(mPatchedSlots[k].slot, mPatchedSlots[k].originalValue, __ATOMIC_RELEASE);
+            }
+            if (!writable) {
+                mprotect(reinterpret_cast<void*>(page), getpagesize(), protection);
+            }
+            i = j;
+        }
+
+        mPatchedSlots.clear();
+        mEntries.clear();
+        mHookedImages.clear();
+        mLoaderHooked = false;
+        LOGD(TAG, "All GOT slots restored");
+
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception unhooking PLT: %s", e.what());
+    }
+}
+
+int PltHook::iterateCallback(struct dl_phdr_info* info, size_t /* size */, void* data) {
+    IterateContext* context = static_cast<IterateContext*>(data);
+
+    PltHook* self = context->self;
+    if (self->shouldSkipImage(info)) {
+        return 0;
+    }
+
+    bool hooked = self->isImageHooked(info->dlpi_addr);
+    if (hooked && context->newImagesOnly) {
+        return 0;
+    }
+
+    int patched = self->hookImage(info, hooked ? *context->entries : self->mEntries);
+    if (patched > 0) {
+        context->patched += patched;
+    }
+    if (!hooked && patched >= 0) {
+        auto position = std::lower_bound(self->mHookedImages.begin(), self->mHookedImages.end(), info->dlpi_addr);
+        self->mHookedImages.insert(position, info->dlpi_addr);
+    }
+    return 0;
+}
+
+int PltHook::collectImageCallback(struct dl_phdr_info* info, size_t /* size */, void* data) {
+    static_cast<std::vector<uintptr_t>*>(data)->push_back(info->dlpi_addr);
+    return 0;
+}
+
+bool PltHook::shouldSkipImage(const struct dl_phdr_info* info) {
+    const char* name = info->dlpi_name;
+    if (name == nullptr || name[0] == '\0' || info->dlpi_phnum == 0) {
+        return true;
+    }
+
+    // 跳过动态链接器和vdso
+    const char* baseName = strrchr(name, '/');
+    baseName = baseName != nullptr ? baseName + 1 : name;
+    if (strcmp(baseName, "linker") == 0 || strcmp(baseName, "linker64") == 0 ||
+        strcmp(baseName, "[vdso]") == 0) {
+        return true;
+    }
+
+    // 跳过本库，避免Hook函数调用原函数时递归
+    if (mSelfBase != 0) {
+        return info->dlpi_addr == mSelfBase;
+    }
+    uintptr_t anchor = reinterpret_cast<uintptr_t>(&selfAnchor);
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type != PT_LOAD) {
+            continue;
+        }
+        uintptr_t start = info->dlpi_addr + phdr.p_vaddr;
+        if (anchor >= start && anchor < start + phdr.p_memsz) {
+            mSelfBase = info->dlpi_addr;
+            return true;
+        }
+    }
+    return false;
+}
+
+int PltHook::hookImage(const struct dl_phdr_info* info, const std::vector<HookEntry>& entries) {
+    uintptr_t bias = info->dlpi_addr;
+
+    // 定位动态段
+    const ElfW(Dyn)* dynamic = nullptr;
+    for (int i = 0; i < info->dlpi_phnum; i++) {
+        const ElfW(Phdr)& phdr = info->dlpi_phdr[i];
+        if (phdr.p_type == PT_DYNAMIC) {
+            dynamic = reinterpret_cast<const ElfW(Dyn)*>(bias + phdr.p_vaddr);
+        }
+    }
+    if (dynamic == nullptr) {
+        return 0;
+    }
+
+    // 解析动态段
+    const ElfW(Sym)* symtab = nullptr;
+    const char* strtab = nullptr;
+    const ElfRel* jmprel = nullptr;
+    size_t jmprelSize = 0;
+    const ElfRel* rel = nullptr;
+    size_t relSize = 0;
+    for (const ElfW(Dyn)* dyn = dynamic; dyn->d_tag != DT_NULL; dyn++) {
+        switch (dyn->d_tag) {
+            case DT_SYMTAB:
+                symtab = reinterpret_cast<const ElfW(Sym)*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_STRTAB:
+                strtab = reinterpret_cast<const char*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_JMPREL:
+                jmprel = reinterpret_cast<const ElfRel*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_PLTRELSZ:
+                jmprelSize = dyn->d_un.d_val;
+                break;
+#if defined(__LP64__)
+            case DT_RELA:
+                rel = reinterpret_cast<const ElfRel*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_RELASZ:
+                relSize = dyn->d_un.d_val;
+                break;
+#else
+            case DT_REL:
+                rel = reinterpret_cast<const ElfRel*>(dynamicAddress(bias, dyn->d_un.d_ptr));
+                break;
+            case DT_RELSZ:
+                relSize = dyn->d_un.d_val;
+                break;
+#endif
+            default:
+                break;
+        }
+    }
+    if (symtab == nullptr || strtab == nullptr) {
+        return 0;
+    }
+
+    // 收集需要改写的表项
+    struct PendingSlot {
+        void** slot;
+        void* replacement;
+    };
+    std::vector<PendingSlot> pending;
+
+    auto collect = [&](const ElfRel* table, size_t tableSize) {
+        if (table == nullptr) {
+            return;
+        }
+        size_t relCount = tableSize / sizeof(ElfRel);
+        for (size_t i = 0; i < relCount; i++) {
+            uint32_t type = static_cast<uint32_t>(ELF_R_TYPE(table[i].r_info));
+            if (type != kRelocJumpSlot && type != kRelocGlobDat && type != kRelocAbs) {
+                continue;
+            }
+            uint32_t symIndex = static_cast<uint32_t>(ELF_R_SYM(table[i].r_info));
+            if (symIndex == 0) {
+                continue;
+            }
+            const HookEntry* entry = findEntry(entries, strtab + symtab[symIndex].st_name);
+            if (entry == nullptr) {
+                continue;
+            }
+            void** slot = reinterpret_cast<void**>(bias + table[i].r_offset);
+            if (*slot != entry->replacement) {
+                pending.push_back({slot, entry->replacement});
+            }
+        }
+    };
+    collect(jmprel, jmprelSize);
+    collect(rel, relSize);
+
+    if (pending.empty()) {
+        return 0;
+    }
+
+    // 按地址排序后把同一段内相邻的页合并为一组，每组只放开、恢复一次；
+    // 各组以程序头中的权限为准，不跨越段之间的空洞
+    std::sort(pending.begin(), pending.end(),
+              [](const PendingSlot& a, const PendingSlot& b) { return a.slot < b.slot; });
+
+    size_t patched = 0;
+    bool failed = false;
+    size_t i = 0;
+    while (i < pending.size()) {
+        uintptr_t start = pageStart(reinterpret_cast<uintptr_t>(pending[i].slot));
+        int protection = pageProtection(info, start);
+        if (protection < 0) {
+            i++;
+            continue;
+        }
+        uintptr_t end = pageEnd(reinterpret_cast<uintptr_t>(pending[i].slot) + sizeof(void*));
+        size_t j = i + 1;
+        while (j < pending.size()) {
+            uintptr_t page = pageStart(reinterpret_cast<uintptr_t>(pending[j].slot));
+            if (page >= end && (page != end || pageProtection(info, page) != protection)) {
+                break;
+            }
+            end = std::max(end, pageEnd(reinterpret_cast<uintptr_t>(pending[j].slot) + sizeof(void*)));
+            j++;
+        }
+
+        bool writable = (protection & PROT_WRITE) != 0;
+        if (!writable && mprotect(reinterpret_cast<void*>(start), end - start, protection | PROT_WRITE) != 0) {
+            LOGE(TAG, "Failed to unprotect GOT of %s at %p: %s", info->dlpi_name,
+                 reinterpret_cast<void*>(start), strerror(errno));
+            failed = true;
+            i = j;
+            continue;
+        }
+        for (size_t k = i; k < j; k++) {
+            mPatchedSlots.push_back({pending[k].slot, *pending[k].slot, bias, protection});
+            __atomic_store_n(pending[k].slot, pending[k].replacement, __ATOMIC_RELEASE);
+        }
+        if (!writable) {
+            mprotect(reinterpret_cast<void*>(start), end - start, protection);
+        }
+        patched += j - i;
+        i = j;
+    }
+
+    if (patched == 0) {
+        return failed ? -1 : 0;
+    }
+
+    LOGD(TAG, "Patched %zu GOT slots in %s", patched, info->dlpi_name);
+    return static_cast<int>(patched);
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,101 @@
+#ifndef PLT_HOOK_H
+#define PLT_HOOK_H
+
+#include <vector>
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+
+struct dl_phdr_info;
+
+namespace VirtualSpace {
+
+/**
+ * PLT/GOT表Hook引擎
+ * 遍历所有已加载的ELF镜像，按符号名批量改写重定位表项，
+ * 每个镜像按段内相邻页分组mprotect，改写后还原为程序头中的权限。
+ * 同时拦截dlopen/android_dlopen_ext/dlclose，之后加载的镜像按缓存的Hook表
+ * 只改写新镜像自身，不再重新扫描已处理过的镜像
+ */
+class PltHook {
+public:
+    // Hook表项
+    struct HookEntry {
+        const char* symbol;     // 导入符号名
+        void* replacement;      // 替换函数
+    };
+
+    static PltHook* getInstance();
+
+    /**
+     * 在所有已加载镜像中批量安装Hook
+     * @param entries Hook表
+     * @param count 表项数量
+     * @return 改写的表项数量，失败返回-1
+     */
+    int hookAll(const HookEntry* entries, size_t count);
+
+    /**
+     * 恢复所有被改写的表项，并停止处理之后加载的镜像
+     */
+    void unhookAll();
+
+    /**
+     * 由加载器Hook在dlopen成功后调用，按完整Hook表改写尚未处理的镜像
+     */
+    void onImagesLoaded();
+
+    /**
+     * 由加载器Hook在dlclose成功后调用，丢弃已卸载镜像的记录
+     */
+    void onImagesUnloaded();
+
+private:
+    PltHook();
+    ~PltHook();
+
+    // 禁用拷贝构造和赋值
+    PltHook(const PltHook&) = delete;
+    PltHook& operator=(const PltHook&) = delete;
+
+    // 单例相关
+    static PltHook* sInstance;
+    static std::mutex sMutex;
+
+    // 已改写的表项，用于恢复
+    struct PatchedSlot {
+        void** slot;
+        void* originalValue;
+        uintptr_t image;        // 所属镜像的装载地址，镜像卸载后丢弃
+        int protection;         // 所在页重定位完成后的保护属性，恢复后还原
+    };
+
+    // 镜像遍历上下文
+    struct IterateContext {
+        PltHook* self;
+        const std::vector<HookEntry>* entries;  // 已处理过的镜像只改写这些表项
+        bool newImagesOnly;                     // 只处理尚未处理过的镜像
+        int patched;
+    };
+
+    static int iterateCallback(struct dl_phdr_info* info, size_t size, void* data);
+    static int collectImageCallback(struct dl_phdr_info* info, size_t size, void* data);
+    int hookImage(const struct dl_phdr_info* info, const std::vector<HookEntry>& entries);
+    bool shouldSkipImage(const struct dl_phdr_info* info);
+    void mergeEntries(const std::vector<HookEntry>& entries);
+    bool isImageHooked(uintptr_t image) const;
+
+    std::mutex mMutex;
+    std::vector<PatchedSlot> mPatchedSlots;
+    uintptr_t mSelfBase;
+
+    // 缓存的完整Hook表，按符号名排序以便二分查找
+    std::vector<HookEntry> mEntries;
+    // 已按完整Hook表处理过的镜像装载地址，有序
+    std::vector<uintptr_t> mHookedImages;
+    bool mLoaderHooked;
+};
+
+} // namespace VirtualSpace
+
+#endif // PLT_HOOK_H
@@ -1,4 +1,9 @@
 #include "SubstrateHook.h"
+#include "ARM64Hook.h"
+#include "ArtMethodHook.h"
+#include "TrampolinePool.h"
+#include "ThreadSuspender.h"
+#include "ElfResolver.h"
 #include "../utils/LogUtils.h"
 #include <android/log.h>
 #include <dlfcn.h>
@@ -6,15 +11,33 @@
 #include <unistd.h>
 #include <errno.h>
 #include <string.h>
+#include <sched.h>
+#include <algorithm>
 
 #define TAG "SubstrateHook"
 
 namespace VirtualSpace {
 
+namespace {
+
+// 批量提交时等待其他线程离开改写范围的重试次数和单次暂停超时
+constexpr int kMaxSuspendAttempts = 8;
+constexpr int kSuspendTimeoutMs = 100;
+
+inline uintptr_t pageStart(uintptr_t address) {
+    return address & ~(static_cast<uintptr_t>(getpagesize()) - 1);
+}
+
+inline uintptr_t pageEnd(uintptr_t address) {
+    return pageStart(address + getpagesize() - 1);
+}
+
+} // namespace
+
 SubstrateHook* SubstrateHook::sInstance = nullptr;
 std::mutex SubstrateHook::sMutex;
 
-SubstrateHook::SubstrateHook() : mIsInitialized(false) {
+SubstrateHook::SubstrateHook() : mIsInitialized(false), mInTransaction(false) {
     LOGD(TAG, "SubstrateHook constructor");
 }
 
@@ -98,6 +121,11 @@ bool SubstrateHook::hookMethod(void* targetMethod, void* hookMethod, void* backu
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(mHookMutex);
+    return hookMethodLocked(targetMethod, hookMethod, backupMethod);
+}
+
+bool SubstrateHook::hookMethodLocked(void* targetMethod, void* hookMethod, void* backupMethod) {
     try {
         LOGD(TAG, "Hooking method: %p -> %p", targetMethod, hookMethod);
         
@@ -107,23 +135,34 @@ bool SubstrateHook::hookMethod(void* targetMethod, void* hookMethod, void* backu
             return false;
         }
         
+        if (mHookManager.contains(targetMethod)) {
+            LOGW(TAG, "Method already hooked: %p", targetMethod);
+            return false;
+        }
+        
         // 获取架构信息
         Architecture arch = getArchitecture();
         
+        HookInfo hookInfo;
+        memset(&hookInfo, 0, sizeof(hookInfo));
+        hookInfo.targetMethod = targetMethod;
+        hookInfo.hookMethod = hookMethod;
+        hookInfo.architecture = arch;
+        
         // 根据架构选择Hook实现
         bool success = false;
         switch (arch) {
             case ARCH_ARM:
-                success = hookMethodARM(targetMethod, hookMethod, backupMethod);
+                success = hookMethodARM(targetMethod, hookMethod, backupMethod, hookInfo);
                 break;
             case ARCH_ARM64:
-                success = hookMethodARM64(targetMethod, hookMethod, backupMethod);
+                success = hookMethodARM64(targetMethod, hookMethod, backupMethod, hookInfo);
                 break;
             case ARCH_X86:
-                success = hookMethodX86(targetMethod, hookMethod, backupMethod);
+                success = hookMethodX86(targetMethod, hookMethod, backupMethod, hookInfo);
                 break;
             case ARCH_X86_64:
-                success = hookMethodX86_64(targetMethod, hookMethod, backupMethod);
+                success = hookMethodX86_64(targetMethod, hookMethod, backupMethod, hookInfo);
                 break;
             default:
                 LOGE(TAG, "Unsupported architecture");
@@ -132,14 +171,29 @@ bool SubstrateHook::hookMethod(void* targetMethod, void* hookMethod, void* backu
         
         if (success) {
             // 注册Hook信息
-            HookInfo hookInfo;
-            hookInfo.targetMethod = targetMethod;
-            hookInfo.hookMethod = hookMethod;
-            hookInfo.backupMethod = backupMethod;
-            hookInfo.architecture = arch;
+            hookInfo.backupMethod = hookInfo.trampoline;
             hookInfo.hookTime = getCurrentTime();
             
-            mHookManager[targetMethod] = hookInfo;
+            if (!mHookManager.insert(targetMethod, hookInfo)) {
+                LOGE(TAG, "Hook registry full, rolling back: %p", targetMethod);
+                switch (arch) {
+                    case ARCH_ARM:
+                        unhookMethodARM(targetMethod, hookInfo);
+                        break;
+                    case ARCH_ARM64:
+                        unhookMethodARM64(targetMethod, hookInfo);
+                        break;
+                    case ARCH_X86:
+                        unhookMethodX86(targetMethod, hookInfo);
+                        break;
+                    case ARCH_X86_64:
+                        unhookMethodX86_64(targetMethod, hookInfo);
+                        break;
+                    default:
+                        break;
+                }
+                return false;
+            }
             
             LOGD(TAG, "Method hooked successfully");
         }
@@ -158,17 +212,20 @@ bool SubstrateHook::unhookMethod(void* targetMethod) {
         return false;
     }
     
+    std::lock_guard<std::mutex> lock(mHookMutex);
+    return unhookMethodLocked(targetMethod);
+}
+
+bool SubstrateHook::unhookMethodLocked(void* targetMethod) {
     try {
         LOGD(TAG, "Unhooking method: %p", targetMethod);
         
-        auto it = mHookManager.find(targetMethod);
-        if (it == mHookManager.end()) {
+        HookInfo hookInfo;
+        if (!mHookManager.find(targetMethod, &hookInfo)) {
             LOGW(TAG, "Hook not found");
             return false;
         }
         
-        HookInfo& hookInfo = it->second;
-        
         // 根据架构选择取消Hook实现
         bool success = false;
         switch (hookInfo.architecture) {
@@ -190,7 +247,7 @@ bool SubstrateHook::unhookMethod(void* targetMethod) {
         }
         
         if (success) {
-            mHookManager.erase(it);
+            mHookManager.erase(targetMethod, nullptr);
             LOGD(TAG, "Method unhooked successfully");
         }
         
@@ -202,26 +259,70 @@ bool SubstrateHook::unhookMethod(void* targetMethod) {
     }
 }
 
-void* SubstrateHook::callOriginMethod(void* backupMethod, void* receiver, void* args) {
+bool SubstrateHook::replaceHook(void* targetMethod, void* hookMethod, void* backupMethod) {
     if (!mIsInitialized) {
         LOGE(TAG, "SubstrateHook not initialized");
-        return nullptr;
+        return false;
+    }
+    
+    if (hookMethod == nullptr) {
+        LOGE(TAG, "Invalid method address");
+        return false;
     }
     
     try {
-        // 调用备份方法
-        if (backupMethod != nullptr) {
-            // 这里需要根据具体的调用约定来调用备份方法
-            // 暂时返回nullptr作为占位符
-            return nullptr;
+        std::lock_guard<std::mutex> lock(mHookMutex);
+        
+        HookInfo hookInfo;
+        if (!mHookManager.find(targetMethod, &hookInfo)) {
+            LOGW(TAG, "Hook not found");
+            return false;
+        }
+        if (hookInfo.hookMethod == hookMethod) {
+            return true;
         }
         
-        return nullptr;
+#if defined(__aarch64__)
+        if (hookInfo.architecture == ARCH_ARM64 &&
+            ARM64Hook::retarget(targetMethod, hookInfo.patchSize, hookInfo.trampoline, hookMethod)) {
+            hookInfo.hookMethod = hookMethod;
+            hookInfo.hookTime = getCurrentTime();
+            mHookManager.update(targetMethod, hookInfo);
+            LOGD(TAG, "Hook retargeted: %p -> %p", targetMethod, hookMethod);
+            return true;
+        }
+#endif
+        
+        // 无法原子替换时取消后重新Hook，旧跳板同样延迟回收
+        if (!unhookMethodLocked(targetMethod)) {
+            return false;
+        }
+        return hookMethodLocked(targetMethod, hookMethod, backupMethod);
         
     } catch (const std::exception& e) {
-        LOGE(TAG, "Exception calling origin method: %s", e.what());
+        LOGE(TAG, "Exception replacing hook: %s", e.what());
+        return false;
+    }
+}
+
+void SubstrateHook::retireTrampoline(void* trampoline) {
+    // 其他线程可能仍在跳板中，无法确认何时离开，槽位永不归还，
+    // 所在内存块也不会被releaseIdle释放
+    if (trampoline != nullptr) {
+        LOGD(TAG, "Trampoline %p retired permanently", trampoline);
+    }
+}
+
+void* SubstrateHook::callOriginMethod(void* backupMethod, void* /* receiver */, void* /* args */) {
+    if (!mIsInitialized) {
+        LOGE(TAG, "SubstrateHook not initialized");
         return nullptr;
     }
+    
+    // 不知道原方法的签名，按任何固定原型调用都可能破坏调用约定；
+    // 只报告错误，调用方应使用callOrigin<Sig>或OriginMethod
+    LOGE(TAG, "Untyped call to %p rejected, use callOrigin<Sig>() or OriginMethod", backupMethod);
+    return nullptr;
 }
 
 bool SubstrateHook::isMethodHooked(void* targetMethod) {
@@ -229,18 +330,303 @@ bool SubstrateHook::isMethodHooked(void* targetMethod) {
         return false;
     }
     
-    return mHookManager.find(targetMethod) != mHookManager.end();
+    return mHookManager.contains(targetMethod);
+}
+
+void* SubstrateHook::getBackupMethod(void* targetMethod) {
+    HookInfo hookInfo;
+    if (!mHookManager.find(targetMethod, &hookInfo)) {
+        return nullptr;
+    }
+    return hookInfo.backupMethod;
+}
+
+int SubstrateHook::hookSymbols(const char* library, const SymbolHook* hooks, size_t count) {
+    if (hooks == nullptr || count == 0) {
+        return 0;
+    }
+    
+    std::vector<ElfResolver::SymbolRequest> requests(count);
+    for (size_t i = 0; i < count; i++) {
+        requests[i].name = hooks[i].symbol;
+    }
+    ElfResolver::getInstance()->resolve(library, requests.data(), count);
+    
+    if (!beginTransaction()) {
+        return -1;
+    }
+    for (size_t i = 0; i < count; i++) {
+        if (requests[i].address == nullptr) {
+            LOGW(TAG, "Symbol not found in %s: %s", library, hooks[i].symbol);
+            continue;
+        }
+        addHook(requests[i].address, hooks[i].hookMethod, hooks[i].backupMethod);
+    }
+    return commit();
+}
+
+bool SubstrateHook::beginTransaction() {
+    std::lock_guard<std::mutex> lock(mTransactionMutex);
+    if (mInTransaction) {
+        LOGW(TAG, "Hook transaction already in progress");
+        return false;
+    }
+    
+    mPendingHooks.clear();
+    mInTransaction = true;
+    return true;
+}
+
+bool SubstrateHook::addHook(void* targetMethod, void* hookMethod, void* backupMethod) {
+    if (targetMethod == nullptr || hookMethod == nullptr) {
+        LOGE(TAG, "Invalid method address");
+        return false;
+    }
+    
+    std::lock_guard<std::mutex> lock(mTransactionMutex);
+    if (!mInTransaction) {
+        LOGE(TAG, "No hook transaction in progress");
+        return false;
+    }
+    
+    mPendingHooks.push_back({targetMethod, hookMethod, backupMethod});
+    return true;
+}
+
+void SubstrateHook::abortTransaction() {
+    std::lock_guard<std::mutex> lock(mTransactionMutex);
+    mPendingHooks.clear();
+    mInTransaction = false;
+}
+
+int SubstrateHook::commit() {
+    std::vector<PendingHook> pending;
+    {
+        std::lock_guard<std::mutex> lock(mTransactionMutex);
+        if (!mInTransaction) {
+            LOGE(TAG, "No hook transaction in progress");
+            return -1;
+        }
+        pending.swap(mPendingHooks);
+        mInTransaction = false;
+    }
+    
+    if (!mIsInitialized) {
+        LOGE(TAG, "SubstrateHook not initialized");
+        return -1;
+    }
+    
+    if (pending.empty()) {
+        return 0;
+    }
+    
+    try {
+        std::lock_guard<std::mutex> lock(mHookMutex);
+        
+        if (getArchitecture() == ARCH_ARM64) {
+            return commitARM64(pending);
+        }
+        
+        // 其他架构逐个安装
+        int installed = 0;
+        for (const PendingHook& request : pending) {
+            if (hookMethodLocked(request.targetMethod, request.hookMethod, request.backupMethod)) {
+                installed++;
+            }
+        }
+        return installed;
+        
+    } catch (const std::exception& e) {
+        LOGE(TAG, "Exception committing hook transaction: %s", e.what());
+        return -1;
+    }
+}
+
+int SubstrateHook::commitARM64(const std::vector<PendingHook>& pending) {
+#if defined(__aarch64__)
+    struct PreparedHook {
+        const PendingHook* request;
+        uint32_t patch[ARM64Hook::kPatchWords];
+        HookInfo info;
+        bool failed;
+    };
+    
+    // 先生成所有跳板和跳转指令，此时不触碰目标代码
+    std::vector<PreparedHook> prepared;
+    prepared.reserve(pending.size());
+    for (const PendingHook& request : pending) {
+        if (mHookManager.contains(request.targetMethod)) {
+            LOGW(TAG, "Method already hooked: %p", request.targetMethod);
+            continue;
+        }
+        
+        PreparedHook item;
+        memset(&item, 0, sizeof(item));
+        item.request = &request;
+        item.info.targetMethod = request.targetMethod;
+        item.info.hookMethod = request.hookMethod;
+        item.info.architecture = ARCH_ARM64;
+        if (!ARM64Hook::prepare(request.targetMethod, request.hookMethod, item.patch,
+                                &item.info.trampoline, item.info.originalCode, &item.info.patchSize)) {
+            LOGE(TAG, "Failed to prepare ARM64 method: %p", request.targetMethod);
+            continue;
+        }
+        prepared.push_back(item);
+    }
+    
+    if (prepared.empty()) {
+        return 0;
+    }
+    
+    // 按地址排序，去掉重复目标，并把相邻或重叠的页合并为连续范围
+    std::sort(prepared.begin(), prepared.end(), [](const PreparedHook& a, const PreparedHook& b) {
+        return a.info.targetMethod < b.info.targetMethod;
+    });
+    
+    struct PageRange {
+        uintptr_t start;
+        uintptr_t end;
+        size_t first;
+        size_t last;
+    };
+    std::vector<PageRange> ranges;
+    uintptr_t previousEnd = 0;
+    for (size_t i = 0; i < prepared.size(); i++) {
+        uintptr_t target = reinterpret_cast<uintptr_t>(prepared[i].info.targetMethod);
+        if (target < previousEnd) {
+            LOGW(TAG, "Overlapping hook target skipped: %p", prepared[i].info.targetMethod);
+            prepared[i].failed = true;
+            continue;
+        }
+        previousEnd = target + prepared[i].info.patchSize;
+        
+        uintptr_t start = pageStart(target);
+        uintptr_t end = pageEnd(previousEnd);
+        if (!ranges.empty() && start <= ranges.back().end) {
+            ranges.back().end = std::max(ranges.back().end, end);
+            ranges.back().last = i;
+        } else {
+            ranges.push_back({start, end, i, i});
+        }
+    }
+    
+    // 先发布跳板，替换函数在目标改写后立即可以调用原方法
+    for (const PreparedHook& item : prepared) {
+        if (!item.failed && item.request->backupMethod != nullptr) {
+            __atomic_store_n(static_cast<void**>(item.request->backupMethod), item.info.trampoline, __ATOMIC_RELEASE);
+        }
+    }
+    
+    // 只暂停一次其他线程；有线程停在待覆盖的指令中间或LR指向其中时放开重试。
+    // 暂停期间被停住的线程可能持有liblog或malloc的锁，失败只记录下来，恢复之后再写日志
+    bool uncleanStop = false;
+    int mprotectErrno = 0;
+    void* mprotectFailure = nullptr;
+    ThreadSuspender suspender;
+    for (int attempt = 0; attempt < kMaxSuspendAttempts; attempt++) {
+        bool suspended = suspender.suspendAll(kSuspendTimeoutMs);
+        bool unsafe = false;
+        for (const PreparedHook& item : prepared) {
+            uintptr_t target = reinterpret_cast<uintptr_t>(item.info.targetMethod);
+            if (!item.failed && suspender.isAnyThreadInRange(target + sizeof(uint32_t), target + item.info.patchSize)) {
+                unsafe = true;
+                break;
+            }
+        }
+        if (suspended && !unsafe) {
+            break;
+        }
+        if (attempt + 1 == kMaxSuspendAttempts) {
+            uncleanStop = true;
+            break;
+        }
+        suspender.resumeAll();
+        sched_yield();
+    }
+    
+    // 每段范围只修改一次保护属性、刷新一次指令缓存
+    for (const PageRange& range : ranges) {
+        void* start = reinterpret_cast<void*>(range.start);
+        size_t length = range.end - range.start;
+        if (mprotect(start, length, PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+            mprotectErrno = errno;
+            mprotectFailure = start;
+            for (size_t i = range.first; i <= range.last; i++) {
+                prepared[i].failed = true;
+            }
+            continue;
+        }
+        
+        for (size_t i = range.first; i <= range.last; i++) {
+            if (!prepared[i].failed) {
+                ARM64Hook::storePatch(prepared[i].info.targetMethod, prepared[i].patch, prepared[i].info.patchSize);
+            }
+        }
+        
+        char* flushStart = static_cast<char*>(prepared[range.first].info.targetMethod);
+        char* flushEnd = static_cast<char*>(prepared[range.last].info.targetMethod) + prepared[range.last].info.patchSize;
+        __builtin___clear_cache(flushStart, flushEnd);
+        mprotect(start, length, PROT_READ | PROT_EXEC);
+    }
+    
+    suspender.resumeAll();
+    
+    if (uncleanStop) {
+        LOGW(TAG, "Patched without a clean thread stop");
+    }
+    if (mprotectFailure != nullptr) {
+        LOGE(TAG, "mprotect failed for %p: %s", mprotectFailure, strerror(mprotectErrno));
+    }
+    
+    // 一次性注册所有结果
+    long hookTime = getCurrentTime();
+    int installed = 0;
+    for (PreparedHook& item : prepared) {
+        if (item.failed) {
+            if (item.request->backupMethod != nullptr) {
+                *static_cast<void**>(item.request->backupMethod) = nullptr;
+            }
+            ARM64Hook::freeTrampoline(item.info.trampoline);
+            continue;
+        }
+        item.info.backupMethod = item.info.trampoline;
+        item.info.hookTime = hookTime;
+        if (!mHookManager.insert(item.info.targetMethod, item.info)) {
+            LOGE(TAG, "Hook registry full, rolling back: %p", item.info.targetMethod);
+            if (ARM64Hook::unhook(item.info.targetMethod, item.info.originalCode, item.info.patchSize)) {
+                retireTrampoline(item.info.trampoline);
+            }
+            continue;
+        }
+        installed++;
+    }
+    
+    LOGD(TAG, "Committed %d of %zu hooks in %zu page ranges", installed, pending.size(), ranges.size());
+    return installed;
+#else
+    (void)pending;
+    return -1;
+#endif
 }
 
 void SubstrateHook::cleanupAllHooks() {
     try {
         LOGD(TAG, "Cleaning up all hooks...");
         
-        for (auto& pair : mHookManager) {
-            unhookMethod(pair.first);
+        std::lock_guard<std::mutex> lock(mHookMutex);
+        
+        // 先取出所有目标，逐个取消时会修改mHookManager
+        std::vector<void*> targets;
+        targets.reserve(mHookManager.size());
+        mHookManager.collectKeys(&targets);
+        for (void* target : targets) {
+            unhookMethodLocked(target);
         }
         
-        mHookManager.clear();
+        // 恢复失败的Hook保留在注册表中，其跳板所在的内存块也不会被释放
+        if (mHookManager.size() != 0) {
+            LOGW(TAG, "%zu hooks could not be removed", mHookManager.size());
+        }
         LOGD(TAG, "All hooks cleaned up");
         
     } catch (const std::exception& e) {
@@ -269,9 +655,13 @@ bool SubstrateHook::initializeARM64Hook() {
     try {
         LOGD(TAG, "Initializing ARM64 Hook...");
         
-        // TODO: 实现ARM64架构的Hook初始化
-        // - 设置ARM64指令集
-        // - 初始化ARM64特定的Hook机制
+#if defined(__aarch64__)
+        // 预分配跳板内存池
+        if (!ARM64Hook::initialize()) {
+            LOGE(TAG, "Failed to allocate ARM64 trampoline pool");
+            return false;
+        }
+#endif
         
         LOGD(TAG, "ARM64 Hook initialized");
         return true;
@@ -299,7 +689,9 @@ void SubstrateHook::cleanupARM64Hook() {
     try {
         LOGD(TAG, "Cleaning up ARM64 Hook...");
         
-        // TODO: 清理ARM64 Hook资源
+#if defined(__aarch64__)
+        ARM64Hook::cleanup();
+#endif
         
         LOGD(TAG, "ARM64 Hook cleaned up");
         
@@ -308,7 +700,7 @@ void SubstrateHook::cleanupARM64Hook() {
     }
 }
 
-bool SubstrateHook::hookMethodARM(void* targetMethod, void* hookMethod, void* backupMethod) {
+bool SubstrateHook::hookMethodARM(void* targetMethod, void* hookMethod, void* /* backupMethod */, HookInfo& /* hookInfo */) {
     try {
         LOGD(TAG, "Hooking ARM method: %p -> %p", targetMethod, hookMethod);
         
@@ -325,16 +717,28 @@ bool SubstrateHook::hookMethodARM(void* targetMethod, void* hookMethod, void* ba
     }
 }
 
-bool SubstrateHook::hookMethodARM64(void* targetMethod, void* hookMethod, void* backupMethod) {
+bool SubstrateHook::hookMethodARM64(void* targetMethod, void* hookMethod, void* backupMethod, HookInfo& hookInfo) {
     try {
         LOGD(TAG, "Hooking ARM64 method: %p -> %p", targetMethod, hookMethod);
         
-        // TODO: 实现ARM64架构的方法Hook
-        // - 保存原始指令
-        // - 写入跳转指令
-        // - 设置备份方法
+#if defined(__aarch64__)
+        // 改写目标开头为跳转，被覆盖的指令重定位到跳板；
+        // 备份方法在改写之前就指向新跳板，重新Hook时替换函数不会用到已回收的旧跳板
+        void* trampoline = nullptr;
+        void** backup = backupMethod != nullptr ? static_cast<void**>(backupMethod) : &trampoline;
+        if (!ARM64Hook::hook(targetMethod, hookMethod, backup, hookInfo.originalCode, &hookInfo.patchSize)) {
+            LOGE(TAG, "Failed to patch ARM64 method: %p", targetMethod);
+            return false;
+        }
         
+        hookInfo.trampoline = *backup;
         return true;
+#else
+        (void)backupMethod;
+        (void)hookInfo;
+        LOGE(TAG, "ARM64 hook is not available on this architecture");
+        return false;
+#endif
         
     } catch (const std::exception& e) {
         LOGE(TAG, "Exception hooking ARM64 method: %s", e.what());
@@ -342,7 +746,7 @@ bool SubstrateHook::hookMethodARM64(void* targetMethod, void* hookMethod, void*
     }
 }
 
-bool SubstrateHook::hookMethodX86(void* targetMethod, void* hookMethod, void* backupMethod) {
+bool SubstrateHook::hookMethodX86(void* targetMethod, void* hookMethod, void* /* backupMethod */, HookInfo& /* hookInfo */) {
     try {
         LOGD(TAG, "Hooking X86 method: %p -> %p", targetMethod, hookMethod);
         
@@ -356,7 +760,7 @@ bool SubstrateHook::hookMethodX86(void* targetMethod, void* hookMethod, void* ba
     }
 }
 
-bool SubstrateHook::hookMethodX86_64(void* targetMethod, void* hookMethod, void* backupMethod) {
+bool SubstrateHook::hookMethodX86_64(void* targetMethod, void* hookMethod, void* /* backupMethod */, HookInfo& /* hookInfo */) {
     try {
         LOGD(TAG, "Hooking X86_64 method: %p -> %p", targetMethod, hookMethod);
         
@@ -370,7 +774,7 @@ bool SubstrateHook::hookMethodX86_64(void* targetMethod, void* hookMethod, void*
     }
 }
 
-bool SubstrateHook::unhookMethodARM(void* targetMethod, const HookInfo& hookInfo) {
+bool SubstrateHook::unhookMethodARM(void* targetMethod, const HookInfo& /* hookInfo */) {
     try {
         LOGD(TAG, "Unhooking ARM method: %p", targetMethod);
         
@@ -390,9 +794,17 @@ bool SubstrateHook::unhookMethodARM64(void* targetMethod, const HookInfo& hookIn
     try {
         LOGD(TAG, "Unhooking ARM64 method: %p", targetMethod);
         
-        // TODO: 实现ARM64架构的方法取消Hook
-        
+#if defined(__aarch64__)
+        // 恢复原始指令并回收跳板
+        if (!ARM64Hook::unhook(targetMethod, hookInfo.originalCode, hookInfo.patchSize)) {
+            return false;
+        }
+        retireTrampoline(hookInfo.trampoline);
         return true;
+#else
+        (void)hookInfo;
+        return false;
+#endif
         
     } catch (const std::exception& e) {
         LOGE(TAG, "Exception unhooking ARM64 method: %s", e.what());
@@ -400,7 +812,7 @@ bool SubstrateHook::unhookMethodARM64(void* targetMethod, const HookInfo& hookIn
     }
 }
 
-bool SubstrateHook::unhookMethodX86(void* targetMethod, const HookInfo& hookInfo) {
+bool SubstrateHook::unhookMethodX86(void* targetMethod, const HookInfo& /* hookInfo */) {
     try {
         LOGD(TAG, "Unhooking X86 method: %p", targetMethod);
         
@@ -414,7 +826,7 @@ bool SubstrateHook::unhookMethodX86(void* targetMethod, const HookInfo& hookInfo
     }
 }
 
-bool SubstrateHook::unhookMethodX86_64(void* targetMethod, const HookInfo& hookInfo) {
+bool SubstrateHook::unhookMethodX86_64(void* targetMethod, const HookInfo& /* hookInfo */) {
     try {
         LOGD(TAG, "Unhooking X86_64 method: %p", targetMethod);
         
@@ -452,53 +864,42 @@ long SubstrateHook::getCurrentTime() {
 
 // JNI接口函数
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_lody_virtual_SubstrateHook_nativeInitialize(JNIEnv* env, jobject thiz) {
-    return SubstrateHook::getInstance()->initialize();
+Java_com_lody_virtual_SandHook_nativeInitialize(JNIEnv* env, jobject thiz) {
+    if (!SubstrateHook::getInstance()->initialize()) {
+        return JNI_FALSE;
+    }
+    
+    // 探测方法声明在调用方的类中
+    jclass probeClass = env->GetObjectClass(thiz);
+    bool success = ArtMethodHook::initialize(env, probeClass);
+    env->DeleteLocalRef(probeClass);
+    return success ? JNI_TRUE : JNI_FALSE;
 }
 
 extern "C" JNIEXPORT void JNICALL
-Java_com_lody_virtual_SubstrateHook_nativeCleanup(JNIEnv* env, jobject thiz) {
+Java_com_lody_virtual_SandHook_nativeCleanup(JNIEnv* env, jobject thiz) {
+    ArtMethodHook::cleanup();
     SubstrateHook::getInstance()->cleanup();
 }
 
+/**
+ * Java方法Hook：替换目标ArtMethod的快速入口，不改写任何机器码
+ */
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_lody_virtual_SubstrateHook_nativeHookMethod(JNIEnv* env, jobject thiz, 
+Java_com_lody_virtual_SandHook_nativeHookMethod(JNIEnv* env, jobject thiz, 
                                                     jobject targetMethod, jobject hookMethod, jobject backupMethod) {
-    // 获取方法地址
-    void* targetAddr = nullptr;
-    void* hookAddr = nullptr;
-    void* backupAddr = nullptr;
-    
-    // TODO: 从Java Method对象获取Native地址
-    
-    return SubstrateHook::getInstance()->hookMethod(targetAddr, hookAddr, backupAddr);
+    return ArtMethodHook::hookMethod(env, targetMethod, hookMethod, backupMethod) ? JNI_TRUE : JNI_FALSE;
 }
 
 extern "C" JNIEXPORT jboolean JNICALL
-Java_com_lody_virtual_SubstrateHook_nativeUnhookMethod(JNIEnv* env, jobject thiz, jobject targetMethod) {
-    // 获取方法地址
-    void* targetAddr = nullptr;
-    
-    // TODO: 从Java Method对象获取Native地址
-    
-    return SubstrateHook::getInstance()->unhookMethod(targetAddr);
+Java_com_lody_virtual_SandHook_nativeUnhookMethod(JNIEnv* env, jobject thiz, jobject targetMethod) {
+    return ArtMethodHook::unhookMethod(env, targetMethod) ? JNI_TRUE : JNI_FALSE;
 }
 
 extern "C" JNIEXPORT jobject JNICALL
-Java_com_lody_virtual_SubstrateHook_nativeCallOriginMethod(JNIEnv* env, jobject thiz, 
+Java_com_lody_virtual_SandHook_nativeCallOriginMethod(JNIEnv* env, jobject thiz, 
                                                           jobject backupMethod, jobject receiver, jobjectArray args) {
-    // 获取方法地址
-    void* backupAddr = nullptr;
-    void* receiverAddr = nullptr;
-    void* argsAddr = nullptr;
-    
-    // TODO: 从Java对象获取Native地址
-    
-    void* result = SubstrateHook::getInstance()->callOriginMethod(backupAddr, receiverAddr, argsAddr);
-    
-    // TODO: 将Native结果转换为Java对象
-    
-    return nullptr;
+    return ArtMethodHook::callOriginMethod(env, backupMethod, receiver, args);
 }
 
 } // namespace VirtualSpace 
\ No newline at end of file
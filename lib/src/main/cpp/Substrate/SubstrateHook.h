@@ -1,12 +1,74 @@
 #ifndef SUBSTRATE_HOOK_H
 #define SUBSTRATE_HOOK_H
 
-#include <map>
 #include <mutex>
+#include <vector>
+#include <stddef.h>
+#include <stdint.h>
+#include <utility>
 #include <jni.h>
+#include "HookRegistry.h"
 
 namespace VirtualSpace {
 
+/**
+ * 按签名生成的原方法调用器
+ * 跳板地址直接转换为对应签名的函数指针调用，不装箱参数、不经过反射
+ */
+template <typename Signature>
+struct OriginCaller;
+
+template <typename Ret, typename... Params>
+struct OriginCaller<Ret(Params...)> {
+    typedef Ret (*Function)(Params...);
+    
+    static inline Ret call(void* backupMethod, Params... params) {
+        return reinterpret_cast<Function>(backupMethod)(std::forward<Params>(params)...);
+    }
+};
+
+/**
+ * 类型化的原方法句柄，Hook时保存跳板地址，调用时直接跳转
+ * 用法：
+ *   static OriginMethod<jobject(JNIEnv*, jobject, jstring, jint)> sGetPackageInfo;
+ *   sGetPackageInfo.hook(target, newGetPackageInfo);
+ *   return sGetPackageInfo(env, thiz, name, flags);
+ */
+template <typename Signature>
+class OriginMethod;
+
+template <typename Ret, typename... Params>
+class OriginMethod<Ret(Params...)> {
+public:
+    typedef Ret (*Function)(Params...);
+    
+    OriginMethod() : mFunction(nullptr) {}
+    
+    /**
+     * 安装Hook并保存跳板
+     * @param targetMethod 目标方法地址
+     * @param hookMethod 同签名的Hook方法
+     * @return 是否成功
+     */
+    bool hook(void* targetMethod, Function hookMethod);
+    
+    /**
+     * 在当前Hook事务中添加请求，commit后跳板才可用
+     */
+    bool addToTransaction(void* targetMethod, Function hookMethod);
+    
+    /**
+     * 调用原方法，跳板在进程生命周期内一直有效
+     */
+    inline Ret operator()(Params... params) const;
+    
+    inline bool isValid() const { return mFunction != nullptr; }
+    inline Function get() const { return mFunction; }
+    
+private:
+    Function mFunction;
+};
+
 /**
  * Substrate Hook类
  * 提供Native层的Hook功能，支持多架构
@@ -22,6 +84,9 @@ public:
         ARCH_X86_64 = 4
     };
     
+    // 目标处最多被覆盖的字节数
+    static constexpr size_t kMaxPatchSize = 16;
+    
     // Hook信息结构
     struct HookInfo {
         void* targetMethod;
@@ -29,6 +94,16 @@ public:
         void* backupMethod;
         Architecture architecture;
         long hookTime;
+        void* trampoline;                       // 调用原方法的跳板
+        uint8_t originalCode[kMaxPatchSize];    // 被覆盖的原始指令
+        size_t patchSize;
+    };
+    
+    // 按符号名指定的Hook请求
+    struct SymbolHook {
+        const char* symbol;
+        void* hookMethod;
+        void* backupMethod;     // 接收原方法跳板地址的指针（void**），可为nullptr
     };
     
     static SubstrateHook* getInstance();
@@ -47,27 +122,61 @@ public:
      * Hook方法
      * @param targetMethod 目标方法地址
      * @param hookMethod Hook方法地址
-     * @param backupMethod 备份方法地址
+     * @param backupMethod 接收原方法跳板地址的指针（void**），可为nullptr
      * @return 是否成功
      */
     bool hookMethod(void* targetMethod, void* hookMethod, void* backupMethod);
     
+    /**
+     * 按符号名批量Hook同一镜像中的函数
+     * 符号由ElfResolver一次解析（包括.symtab中的内部符号），再作为一个事务统一安装
+     * @param library 镜像文件名，如"libart.so"
+     * @param hooks 请求数组
+     * @param count 请求数量
+     * @return 成功安装的Hook数量，失败返回-1
+     */
+    int hookSymbols(const char* library, const SymbolHook* hooks, size_t count);
+    
     /**
      * 取消Hook
+     * 无法确认其他线程何时离开跳板，旧跳板永不归还给TrampolinePool，
+     * 每次取消都会留下一个槽位，频繁取消再重新Hook会持续占用内存块
      * @param targetMethod 目标方法地址
      * @return 是否成功
      */
     bool unhookMethod(void* targetMethod);
     
     /**
-     * 调用原始方法
-     * @param backupMethod 备份方法地址
-     * @param receiver 接收者对象
-     * @param args 参数
-     * @return 调用结果
+     * 把已安装的Hook替换为新的替换函数，不恢复原始指令
+     * 能原子替换跳转地址时原方法跳板保持不变；否则取消后重新Hook，期间的调用会进入原方法，
+     * 旧跳板与unhookMethod()一样永不回收
+     * @param targetMethod 目标方法地址
+     * @param hookMethod 新的Hook方法地址
+     * @param backupMethod 重新Hook时接收新跳板地址的指针（void**），可为nullptr
+     * @return 是否成功
+     */
+    bool replaceHook(void* targetMethod, void* hookMethod, void* backupMethod);
+    
+    /**
+     * 调用原始方法（无签名版本，已废弃）
+     * 签名未知时无法按正确的调用约定传参，始终记录错误并返回nullptr，
+     * 请改用callOrigin<Sig>或OriginMethod
+     * @return nullptr
      */
     void* callOriginMethod(void* backupMethod, void* receiver, void* args);
     
+    /**
+     * 按签名直接调用原始方法，例如
+     *   callOrigin<int(const char*, int)>(backup, path, flags);
+     * @param backupMethod hookMethod返回的跳板地址
+     * @return 原方法的返回值
+     */
+    template <typename Signature, typename... Args>
+    static inline auto callOrigin(void* backupMethod, Args&&... args)
+        -> decltype(OriginCaller<Signature>::call(backupMethod, std::forward<Args>(args)...)) {
+        return OriginCaller<Signature>::call(backupMethod, std::forward<Args>(args)...);
+    }
+    
     /**
      * 检查方法是否已Hook
      * @param targetMethod 目标方法地址
@@ -75,6 +184,41 @@ public:
      */
     bool isMethodHooked(void* targetMethod);
     
+    /**
+     * 无锁查询目标方法的跳板地址
+     * @param targetMethod 目标方法地址
+     * @return 跳板地址，未Hook时返回nullptr
+     */
+    void* getBackupMethod(void* targetMethod);
+    
+    /**
+     * 开始批量Hook事务
+     * 事务内的addHook只记录请求，commit时统一安装：按页合并改写范围，
+     * 只暂停一次其他线程，每段范围只修改一次保护属性、刷新一次指令缓存
+     * @return 是否成功（已有事务进行中时返回false）
+     */
+    bool beginTransaction();
+    
+    /**
+     * 向当前事务添加Hook请求
+     * @param targetMethod 目标方法地址
+     * @param hookMethod Hook方法地址
+     * @param backupMethod 接收原方法跳板地址的指针（void**），可为nullptr
+     * @return 是否成功
+     */
+    bool addHook(void* targetMethod, void* hookMethod, void* backupMethod);
+    
+    /**
+     * 提交事务，安装所有Hook并一次性注册
+     * @return 成功安装的Hook数量，失败返回-1
+     */
+    int commit();
+    
+    /**
+     * 放弃当前事务中尚未提交的Hook请求
+     */
+    void abortTransaction();
+    
 private:
     SubstrateHook();
     ~SubstrateHook();
@@ -89,7 +233,22 @@ private:
     
     // 成员变量
     bool mIsInitialized;
-    std::map<void*, HookInfo> mHookManager;
+    HookRegistry<HookInfo> mHookManager;
+    std::mutex mHookMutex;      // 串行化代码改写，查询不加锁
+    
+    // 事务相关
+    struct PendingHook {
+        void* targetMethod;
+        void* hookMethod;
+        void* backupMethod;
+    };
+    bool mInTransaction;
+    std::vector<PendingHook> mPendingHooks;
+    std::mutex mTransactionMutex;
+    
+    int commitARM64(const std::vector<PendingHook>& pending);
+    bool hookMethodLocked(void* targetMethod, void* hookMethod, void* backupMethod);
+    bool unhookMethodLocked(void* targetMethod);
     
     // 架构相关方法
     bool initializeARMHook();
@@ -98,10 +257,10 @@ private:
     void cleanupARM64Hook();
     
     // Hook实现方法
-    bool hookMethodARM(void* targetMethod, void* hookMethod, void* backupMethod);
-    bool hookMethodARM64(void* targetMethod, void* hookMethod, void* backupMethod);
-    bool hookMethodX86(void* targetMethod, void* hookMethod, void* backupMethod);
-    bool hookMethodX86_64(void* targetMethod, void* hookMethod, void* backupMethod);
+    bool hookMethodARM(void* targetMethod, void* hookMethod, void* backupMethod, HookInfo& hookInfo);
+    bool hookMethodARM64(void* targetMethod, void* hookMethod, void* backupMethod, HookInfo& hookInfo);
+    bool hookMethodX86(void* targetMethod, void* hookMethod, void* backupMethod, HookInfo& hookInfo);
+    bool hookMethodX86_64(void* targetMethod, void* hookMethod, void* backupMethod, HookInfo& hookInfo);
     
     // 取消Hook实现方法
     bool unhookMethodARM(void* targetMethod, const HookInfo& hookInfo);
@@ -111,10 +270,26 @@ private:
     
     // 工具方法
     void cleanupAllHooks();
+    static void retireTrampoline(void* trampoline);
     Architecture getArchitecture();
     long getCurrentTime();
 };
 
+template <typename Ret, typename... Params>
+inline Ret OriginMethod<Ret(Params...)>::operator()(Params... params) const {
+    return mFunction(std::forward<Params>(params)...);
+}
+
+template <typename Ret, typename... Params>
+bool OriginMethod<Ret(Params...)>::hook(void* targetMethod, Function hookMethod) {
+    return SubstrateHook::getInstance()->hookMethod(targetMethod, reinterpret_cast<void*>(hookMethod), &mFunction);
+}
+
+template <typename Ret, typename... Params>
+bool OriginMethod<Ret(Params...)>::addToTransaction(void* targetMethod, Function hookMethod) {
+    return SubstrateHook::getInstance()->addHook(targetMethod, reinterpret_cast<void*>(hookMethod), &mFunction);
+}
+
 } // namespace VirtualSpace
 
 #endif // SUBSTRATE_HOOK_H 
\ No newline at end of file
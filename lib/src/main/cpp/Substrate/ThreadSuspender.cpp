@@ -0,0 +1,219 @@
+#include "ThreadSuspender.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+
+#define TAG "ThreadSuspender"
+
+namespace VirtualSpace {
+
+namespace {
+
+// SIGURG默认被忽略，应用几乎不会使用
+constexpr int kSuspendSignal = SIGURG;
+constexpr int kMaxThreads = 1024;
+
+std::mutex sSuspendMutex;
+struct sigaction sPreviousAction;
+
+std::atomic<int> sSlotCounter(0);
+std::atomic<int> sAckCount(0);
+std::atomic<int> sExitCount(0);
+std::atomic<bool> sRelease(false);
+std::atomic<uintptr_t> sThreadPcs[kMaxThreads];
+std::atomic<uintptr_t> sThreadLrs[kMaxThreads];
+// 发信号前先收集完线程号，暂停期间不再调用可能持有malloc锁的closedir
+pid_t sThreadIds[kMaxThreads];
+
+long currentTimeMs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+uintptr_t contextPc(void* context) {
+    ucontext_t* ucontext = static_cast<ucontext_t*>(context);
+#if defined(__aarch64__)
+    return ucontext->uc_mcontext.pc;
+#elif defined(__arm__)
+    return ucontext->uc_mcontext.arm_pc;
+#elif defined(__x86_64__)
+    return ucontext->uc_mcontext.gregs[REG_RIP];
+#elif defined(__i386__)
+    return ucontext->uc_mcontext.gregs[REG_EIP];
+#else
+    return 0;
+#endif
+}
+
+// 链接寄存器：线程正在被覆盖指令中的调用里时，返回地址落在覆盖范围内。
+// x86的返回地址在栈上，不做检查
+uintptr_t contextLr(void* context) {
+    ucontext_t* ucontext = static_cast<ucontext_t*>(context);
+#if defined(__aarch64__)
+    return ucontext->uc_mcontext.regs[30];
+#elif defined(__arm__)
+    return ucontext->uc_mcontext.arm_lr;
+#else
+    (void) ucontext;
+    return 0;
+#endif
+}
+
+void suspendHandler(int /* signal */, siginfo_t* /* info */, void* context) {
+    int savedErrno = errno;
+
+    // 记录被打断时的PC和LR，供调用方检查是否停在或将返回到待改写的代码中
+    int slot = sSlotCounter.fetch_add(1, std::memory_order_relaxed);
+    if (slot < kMaxThreads) {
+        sThreadPcs[slot].store(contextPc(context), std::memory_order_relaxed);
+        sThreadLrs[slot].store(contextLr(context), std::memory_order_relaxed);
+    }
+    sAckCount.fetch_add(1, std::memory_order_release);
+
+    while (!sRelease.load(std::memory_order_acquire)) {
+        sched_yield();
+    }
+
+    // 返回前刷新指令流水线，保证看到新写入的代码
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    sExitCount.fetch_add(1, std::memory_order_release);
+    errno = savedErrno;
+}
+
+} // namespace
+
+ThreadSuspender::ThreadSuspender() : mSuspended(false), mTimedOut(false), mSignaled(0) {
+}
+
+ThreadSuspender::~ThreadSuspender() {
+    resumeAll();
+}
+
+bool ThreadSuspender::suspendAll(int timeoutMs) {
+    if (mSuspended) {
+        return true;
+    }
+
+    sSuspendMutex.lock();
+
+    sSlotCounter.store(0, std::memory_order_relaxed);
+    sAckCount.store(0, std::memory_order_relaxed);
+    sExitCount.store(0, std::memory_order_relaxed);
+    sRelease.store(false, std::memory_order_release);
+
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_sigaction = suspendHandler;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigfillset(&action.sa_mask);
+    if (sigaction(kSuspendSignal, &action, &sPreviousAction) != 0) {
+        LOGE(TAG, "sigaction failed: %s", strerror(errno));
+        sSuspendMutex.unlock();
+        return false;
+    }
+    mSuspended = true;
+
+    // 枚举/proc/self/task，目录关闭之后再逐个发送信号
+    pid_t pid = getpid();
+    pid_t self = static_cast<pid_t>(syscall(__NR_gettid));
+    DIR* dir = opendir("/proc/self/task");
+    if (dir == nullptr) {
+        LOGE(TAG, "Failed to open /proc/self/task: %s", strerror(errno));
+        return false;
+    }
+    int threadCount = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr && threadCount < kMaxThreads) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') {
+            continue;
+        }
+        pid_t tid = static_cast<pid_t>(atoi(entry->d_name));
+        if (tid != self) {
+            sThreadIds[threadCount++] = tid;
+        }
+    }
+    closedir(dir);
+
+    int signaled = 0;
+    for (int i = 0; i < threadCount; i++) {
+        if (syscall(__NR_tgkill, pid, sThreadIds[i], kSuspendSignal) == 0) {
+            signaled++;
+        }
+    }
+
+    // 等待所有线程进入处理器，已退出或屏蔽信号的线程会超时；
+    // 此时已有线程停住，超时信息留到resumeAll()之后再记录
+    mSignaled = signaled;
+    long deadline = currentTimeMs() + timeoutMs;
+    while (sAckCount.load(std::memory_order_acquire) < signaled) {
+        if (currentTimeMs() > deadline) {
+            mTimedOut = true;
+            return false;
+        }
+        sched_yield();
+    }
+
+    return true;
+}
+
+void ThreadSuspender::resumeAll() {
+    if (!mSuspended) {
+        return;
+    }
+
+    sRelease.store(true, std::memory_order_release);
+
+    // 等待已进入处理器的线程全部离开，再恢复原信号处理器
+    int acked = sAckCount.load(std::memory_order_acquire);
+    bool resumeTimedOut = false;
+    long deadline = currentTimeMs() + 1000;
+    while (sExitCount.load(std::memory_order_acquire) < sAckCount.load(std::memory_order_acquire)) {
+        if (currentTimeMs() > deadline) {
+            resumeTimedOut = true;
+            break;
+        }
+        sched_yield();
+    }
+
+    sigaction(kSuspendSignal, &sPreviousAction, nullptr);
+    mSuspended = false;
+    sSuspendMutex.unlock();
+
+    // 其他线程都已放开，这里才能写日志
+    if (mTimedOut) {
+        LOGW(TAG, "Only %d of %d threads suspended", acked, mSignaled);
+        mTimedOut = false;
+    }
+    if (resumeTimedOut) {
+        LOGW(TAG, "Timed out waiting for threads to resume");
+    }
+}
+
+bool ThreadSuspender::isAnyThreadInRange(uintptr_t start, uintptr_t end) const {
+    int count = sAckCount.load(std::memory_order_acquire);
+    if (count > kMaxThreads) {
+        count = kMaxThreads;
+    }
+    for (int i = 0; i < count; i++) {
+        uintptr_t pc = sThreadPcs[i].load(std::memory_order_relaxed);
+        uintptr_t lr = sThreadLrs[i].load(std::memory_order_relaxed);
+        if ((pc >= start && pc < end) || (lr >= start && lr < end)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,51 @@
+#ifndef THREAD_SUSPENDER_H
+#define THREAD_SUSPENDER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * 线程暂停器
+ * 向进程内除当前线程外的所有线程发送信号，使其在信号处理器中自旋等待，
+ * 用于批量改写代码时一次性停住其他线程。同一时刻只允许一个实例处于暂停状态。
+ * 暂停期间不能写日志或分配内存：被停住的线程可能正持有liblog或malloc的锁
+ */
+class ThreadSuspender {
+public:
+    ThreadSuspender();
+    ~ThreadSuspender();
+
+    // 禁用拷贝构造和赋值
+    ThreadSuspender(const ThreadSuspender&) = delete;
+    ThreadSuspender& operator=(const ThreadSuspender&) = delete;
+
+    /**
+     * 暂停其他线程
+     * @param timeoutMs 等待线程响应的超时时间
+     * @return 是否所有线程都已暂停（超时未响应的线程不计入）
+     */
+    bool suspendAll(int timeoutMs);
+
+    /**
+     * 恢复所有被暂停的线程
+     */
+    void resumeAll();
+
+    /**
+     * 检查是否有被暂停的线程停在指定地址范围内，或LR指向该范围（即将返回到其中）
+     * @param start 起始地址
+     * @param end 结束地址（不含）
+     */
+    bool isAnyThreadInRange(uintptr_t start, uintptr_t end) const;
+
+private:
+    bool mSuspended;
+    bool mTimedOut;         // 本轮暂停有线程未响应，恢复后记录日志
+    int mSignaled;
+};
+
+} // namespace VirtualSpace
+
+#endif // THREAD_SUSPENDER_H
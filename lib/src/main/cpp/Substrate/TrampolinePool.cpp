@@ -0,0 +1,285 @@
+#include "TrampolinePool.h"
+#include "../utils/LogUtils.h"
+#include <android/log.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#define TAG "TrampolinePool"
+
+namespace VirtualSpace {
+
+namespace {
+
+constexpr size_t kSlotsPerSlab = TrampolinePool::kSlabSize / TrampolinePool::kSlotSize;
+constexpr size_t kMaskWords = (kSlotsPerSlab + 63) / 64;
+
+// 就近映射时不考虑低于该地址的空隙（mmap_min_addr）
+constexpr uintptr_t kMinMapAddress = 0x10000;
+
+// 每次就近映射最多尝试的空隙数
+constexpr size_t kMaxMapAttempts = 8;
+
+struct Slab {
+    uintptr_t base;
+    size_t usedCount;
+    uint64_t usedMask[kMaskWords];
+};
+
+// 按base排序
+std::mutex sPoolMutex;
+std::vector<Slab> sSlabs;
+
+void* mapSlab(void* hint) {
+    return mmap(hint, TrampolinePool::kSlabSize, PROT_READ | PROT_WRITE | PROT_EXEC,
+                MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+
+void* takeSlot(Slab& slab) {
+    for (size_t word = 0; word < kMaskWords; word++) {
+        uint64_t freeBits = ~slab.usedMask[word];
+        if (freeBits == 0) {
+            continue;
+        }
+        size_t bit = static_cast<size_t>(__builtin_ctzll(freeBits));
+        size_t index = word * 64 + bit;
+        if (index >= kSlotsPerSlab) {
+            break;
+        }
+        slab.usedMask[word] |= 1ULL << bit;
+        slab.usedCount++;
+        return reinterpret_cast<void*>(slab.base + index * TrampolinePool::kSlotSize);
+    }
+    return nullptr;
+}
+
+Slab* insertSlab(void* base) {
+    Slab slab;
+    memset(&slab, 0, sizeof(slab));
+    slab.base = reinterpret_cast<uintptr_t>(base);
+    auto it = std::upper_bound(sSlabs.begin(), sSlabs.end(), slab.base,
+                               [](uintptr_t address, const Slab& entry) { return address < entry.base; });
+    return &*sSlabs.insert(it, slab);
+}
+
+bool parseHex(const char*& cursor, const char* end, uintptr_t* value) {
+    uintptr_t result = 0;
+    const char* start = cursor;
+    for (; cursor < end; cursor++) {
+        char c = *cursor;
+        unsigned digit;
+        if (c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if (c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else {
+            break;
+        }
+        result = (result << 4) | digit;
+    }
+    *value = result;
+    return cursor > start;
+}
+
+// 按地址顺序遍历/proc/self/maps中的映射区间，不经过stdio
+template <typename Callback>
+bool forEachMapping(Callback callback) {
+    int fd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        LOGE(TAG, "Failed to open /proc/self/maps: %s", strerror(errno));
+        return false;
+    }
+
+    char buffer[4096];
+    size_t pending = 0;
+    while (true) {
+        ssize_t bytes = read(fd, buffer + pending, sizeof(buffer) - pending);
+        if (bytes < 0 && errno == EINTR) {
+            continue;
+        }
+        if (bytes <= 0) {
+            break;
+        }
+        size_t available = pending + static_cast<size_t>(bytes);
+
+        // 只处理完整的行，剩余部分移到缓冲区开头
+        size_t lineStart = 0;
+        for (size_t i = 0; i < available; i++) {
+            if (buffer[i] != '\n') {
+                continue;
+            }
+            const char* cursor = buffer + lineStart;
+            const char* lineEnd = buffer + i;
+            uintptr_t start = 0;
+            uintptr_t end = 0;
+            if (parseHex(cursor, lineEnd, &start) && cursor < lineEnd && *cursor++ == '-' &&
+                parseHex(cursor, lineEnd, &end)) {
+                callback(start, end);
+            }
+            lineStart = i + 1;
+        }
+        pending = available - lineStart;
+        if (pending == sizeof(buffer)) {
+            // 单行超过缓冲区（路径极长），丢弃该行剩余部分不影响地址解析
+            pending = 0;
+        }
+        memmove(buffer, buffer + lineStart, pending);
+    }
+
+    close(fd);
+    return true;
+}
+
+// 在near的range范围内找空隙映射一个内存块，失败返回MAP_FAILED
+void* mapNear(uintptr_t near, size_t range) {
+    const uintptr_t slabSize = TrampolinePool::kSlabSize;
+    uintptr_t low = near > range ? near - range : 0;
+    uintptr_t high = near < UINTPTR_MAX - range ? near + range : UINTPTR_MAX;
+    low = std::max(low, kMinMapAddress);
+
+    // 每个空隙取最靠近near的对齐地址
+    std::vector<uintptr_t> candidates;
+    auto addGap = [&](uintptr_t gapStart, uintptr_t gapEnd) {
+        gapStart = std::max(gapStart, low);
+        gapEnd = std::min(gapEnd, high);
+        gapStart = (gapStart + slabSize - 1) & ~(slabSize - 1);
+        gapEnd &= ~(slabSize - 1);
+        if (gapEnd <= gapStart || gapEnd - gapStart < slabSize) {
+            return;
+        }
+        uintptr_t candidate = near & ~(slabSize - 1);
+        candidate = std::max(candidate, gapStart);
+        candidate = std::min(candidate, gapEnd - slabSize);
+        candidates.push_back(candidate);
+    };
+
+    uintptr_t previousEnd = 0;
+    bool parsed = forEachMapping([&](uintptr_t start, uintptr_t end) {
+        if (start > previousEnd) {
+            addGap(previousEnd, start);
+        }
+        previousEnd = std::max(previousEnd, end);
+    });
+    if (!parsed) {
+        return MAP_FAILED;
+    }
+    addGap(previousEnd, high);
+
+    auto distance = [near](uintptr_t address) {
+        return address > near ? address - near : near - address;
+    };
+    std::sort(candidates.begin(), candidates.end(), [&distance](uintptr_t a, uintptr_t b) {
+        return distance(a) < distance(b);
+    });
+
+    // 不使用MAP_FIXED，地址已被占用时内核会另选位置，此时放弃该结果
+    size_t attempts = std::min(candidates.size(), kMaxMapAttempts);
+    for (size_t i = 0; i < attempts; i++) {
+        void* base = mapSlab(reinterpret_cast<void*>(candidates[i]));
+        if (base == MAP_FAILED) {
+            continue;
+        }
+        if (TrampolinePool::isWithinRange(reinterpret_cast<uintptr_t>(base), slabSize, near, range)) {
+            return base;
+        }
+        munmap(base, slabSize);
+    }
+    return MAP_FAILED;
+}
+
+} // namespace
+
+bool TrampolinePool::isWithinRange(uintptr_t address, size_t size, uintptr_t near, size_t range) {
+    uintptr_t low = near > range ? near - range : 0;
+    uintptr_t high = near < UINTPTR_MAX - range ? near + range : UINTPTR_MAX;
+    return address >= low && address <= high && high - address >= size;
+}
+
+void* TrampolinePool::allocate(const void* near, size_t range) {
+    std::lock_guard<std::mutex> lock(sPoolMutex);
+
+    uintptr_t nearAddress = reinterpret_cast<uintptr_t>(near);
+    bool constrained = near != nullptr && range != 0;
+
+    // 优先使用范围内已有内存块的空闲槽位，其次就近映射新块
+    if (constrained) {
+        for (Slab& slab : sSlabs) {
+            if (slab.usedCount < kSlotsPerSlab && isWithinRange(slab.base, kSlabSize, nearAddress, range)) {
+                return takeSlot(slab);
+            }
+        }
+
+        void* base = mapNear(nearAddress, range);
+        if (base != MAP_FAILED) {
+            LOGD(TAG, "Mapped trampoline slab %p near %p", base, near);
+            return takeSlot(*insertSlab(base));
+        }
+        LOGW(TAG, "No trampoline slab within range of %p", near);
+    }
+
+    for (Slab& slab : sSlabs) {
+        if (slab.usedCount < kSlotsPerSlab) {
+            return takeSlot(slab);
+        }
+    }
+
+    void* base = mapSlab(nullptr);
+    if (base == MAP_FAILED) {
+        LOGE(TAG, "Failed to allocate trampoline slab: %s", strerror(errno));
+        return nullptr;
+    }
+    return takeSlot(*insertSlab(base));
+}
+
+void TrampolinePool::free(void* slot) {
+    if (slot == nullptr) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(sPoolMutex);
+    uintptr_t address = reinterpret_cast<uintptr_t>(slot);
+    auto it = std::upper_bound(sSlabs.begin(), sSlabs.end(), address,
+                               [](uintptr_t value, const Slab& entry) { return value < entry.base; });
+    if (it == sSlabs.begin() || address - (it - 1)->base >= kSlabSize) {
+        LOGE(TAG, "Freeing unknown trampoline %p", slot);
+        return;
+    }
+
+    Slab& slab = *(it - 1);
+    size_t index = (address - slab.base) / kSlotSize;
+    uint64_t bit = 1ULL << (index % 64);
+    if ((slab.usedMask[index / 64] & bit) == 0) {
+        LOGW(TAG, "Trampoline %p freed twice", slot);
+        return;
+    }
+    slab.usedMask[index / 64] &= ~bit;
+    slab.usedCount--;
+}
+
+size_t TrampolinePool::releaseIdle() {
+    std::lock_guard<std::mutex> lock(sPoolMutex);
+    size_t kept = 0;
+    for (size_t i = 0; i < sSlabs.size(); i++) {
+        if (sSlabs[i].usedCount == 0) {
+            munmap(reinterpret_cast<void*>(sSlabs[i].base), kSlabSize);
+        } else {
+            sSlabs[kept++] = sSlabs[i];
+        }
+    }
+    size_t released = sSlabs.size() - kept;
+    sSlabs.resize(kept);
+    LOGD(TAG, "Released %zu idle trampoline slabs, %zu still in use", released, kept);
+    return released;
+}
+
+size_t TrampolinePool::getSlabCount() {
+    std::lock_guard<std::mutex> lock(sPoolMutex);
+    return sSlabs.size();
+}
+
+} // namespace VirtualSpace
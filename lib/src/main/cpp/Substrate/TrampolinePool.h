@@ -0,0 +1,57 @@
+#ifndef TRAMPOLINE_POOL_H
+#define TRAMPOLINE_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace VirtualSpace {
+
+/**
+ * 跳板内存池
+ * 按固定大小槽位切分的可执行内存块（slab），供内联Hook存放重定位的指令和跳转桩。
+ * 分配时可要求槽位位于某地址附近，新内存块按/proc/self/maps中的空隙就近映射，
+ * 使目标处能用一条相对跳转指令到达跳板。同一区域内的Hook共用内存块，
+ * 几百个Hook只占用少量页面
+ */
+class TrampolinePool {
+public:
+    // 单个槽位大小
+    static constexpr size_t kSlotSize = 128;
+
+    // 内存块大小，兼容4K和16K页
+    static constexpr size_t kSlabSize = 16 * 1024;
+
+    /**
+     * 分配一个槽位
+     * @param near 希望靠近的地址，nullptr表示不限位置
+     * @param range 整个槽位与near的最大距离；范围内无法分配时退回任意位置，调用方需自行检查
+     * @return 槽位地址，失败返回nullptr
+     */
+    static void* allocate(const void* near, size_t range);
+
+    /**
+     * 归还槽位
+     * 调用方需保证没有线程执行过该槽位，已发布过的Hook跳板永不归还
+     */
+    static void free(void* slot);
+
+    /**
+     * 释放所有槽位都已归还的内存块，仍有槽位在用的内存块保留
+     * @return 释放的内存块数
+     */
+    static size_t releaseIdle();
+
+    /**
+     * 当前映射的内存块数
+     */
+    static size_t getSlabCount();
+
+    /**
+     * [address, address + size)是否整体位于near的range范围内
+     */
+    static bool isWithinRange(uintptr_t address, size_t size, uintptr_t near, size_t range);
+};
+
+} // namespace VirtualSpace
+
+#endif // TRAMPOLINE_POOL_H
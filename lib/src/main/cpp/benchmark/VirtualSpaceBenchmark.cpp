@@ -0,0 +1,415 @@
+#include "../Foundation/IORelocator.h"
+#include "../Substrate/SubstrateHook.h"
+#include "../utils/FileUtils.h"
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/system_properties.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <atomic>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * VirtualSpace原生微基准
+ * 每项结果输出一行JSON，便于跨机型比较：
+ *   {"benchmark":"...","device":"...","abi":"...", ...参数..., "iterations":N,"ns_per_op":X}
+ * 用法: virtualspace_benchmark [迭代次数倍率]
+ */
+
+using namespace VirtualSpace;
+
+namespace {
+
+constexpr size_t kBaseIterations = 200000;
+constexpr size_t kDistinctPaths = 1024;
+
+size_t sIterationScale = 1;
+char sDevice[PROP_VALUE_MAX] = "unknown";
+
+const char* abiName() {
+#if defined(__aarch64__)
+    return "arm64-v8a";
+#elif defined(__arm__)
+    return "armeabi-v7a";
+#elif defined(__x86_64__)
+    return "x86_64";
+#elif defined(__i386__)
+    return "x86";
+#else
+    return "unknown";
+#endif
+}
+
+inline uint64_t nowNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
+}
+
+// 参数以预先格式化好的 "key":value 片段传入
+void report(const char* benchmark, const char* params, size_t iterations, uint64_t elapsedNs) {
+    double nsPerOp = iterations == 0 ? 0.0 : static_cast<double>(elapsedNs) / iterations;
+    printf("{\"benchmark\":\"%s\",\"device\":\"%s\",\"abi\":\"%s\"%s%s,\"iterations\":%zu,\"ns_per_op\":%.2f}\n",
+           benchmark, sDevice, abiName(), params[0] != '\0' ? "," : "", params, iterations, nsPerOp);
+    fflush(stdout);
+}
+
+void reportSkipped(const char* benchmark, const char* reason) {
+    printf("{\"benchmark\":\"%s\",\"device\":\"%s\",\"abi\":\"%s\",\"skipped\":\"%s\"}\n",
+           benchmark, sDevice, abiName(), reason);
+    fflush(stdout);
+}
+
+// 防止编译器消除被测调用
+std::atomic<uint64_t> sSink(0);
+
+void installMappings(size_t count) {
+    IORelocator* relocator = IORelocator::getInstance();
+    for (size_t i = 0; i < count; i++) {
+        std::string original = "/data/data/com.bench.app" + std::to_string(i);
+        std::string virtualPath = "/data/user/0/io.virtualspace/virtual/app" + std::to_string(i);
+        relocator->addPathMapping(original, virtualPath);
+    }
+}
+
+void removeMappings(size_t count) {
+    IORelocator* relocator = IORelocator::getInstance();
+    for (size_t i = 0; i < count; i++) {
+        relocator->removePathMapping("/data/data/com.bench.app" + std::to_string(i));
+    }
+}
+
+// 按命中比例生成测试路径，命中路径均匀分布在所有映射上
+std::vector<std::string> makePaths(size_t mappingCount, int hitPercent, size_t pathCount) {
+    std::vector<std::string> paths;
+    paths.reserve(pathCount);
+    for (size_t i = 0; i < pathCount; i++) {
+        if (static_cast<int>(i * 100 / pathCount) < hitPercent) {
+            paths.push_back("/data/data/com.bench.app" + std::to_string(i % mappingCount) +
+                            "/files/cache_" + std::to_string(i) + ".db");
+        } else {
+            paths.push_back("/system/framework/miss_" + std::to_string(i) + ".jar");
+        }
+    }
+    // 打乱顺序，避免命中与未命中成段出现
+    for (size_t i = pathCount; i > 1; i--) {
+        size_t j = static_cast<size_t>(rand()) % i;
+        std::swap(paths[i - 1], paths[j]);
+    }
+    return paths;
+}
+
+uint64_t runRedirect(const std::vector<std::string>& paths, size_t iterations) {
+    IORelocator* relocator = IORelocator::getInstance();
+    char buffer[PATH_MAX];
+    uint64_t sink = 0;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += relocator->redirectPath(paths[i % paths.size()].c_str(), buffer, sizeof(buffer));
+    }
+    uint64_t elapsed = nowNs() - start;
+    sSink.fetch_add(sink, std::memory_order_relaxed);
+    return elapsed;
+}
+
+void benchmarkRedirectPath() {
+    const size_t mappingCounts[] = {10, 100, 1000};
+    const int hitPercents[] = {0, 50, 90, 100};
+    size_t iterations = kBaseIterations * sIterationScale;
+
+    for (size_t mappingCount : mappingCounts) {
+        installMappings(mappingCount);
+        for (int hitPercent : hitPercents) {
+            char params[128];
+
+            // 少量重复路径：主要命中线程缓存
+            std::vector<std::string> hot = makePaths(mappingCount, hitPercent, 16);
+            runRedirect(hot, hot.size());
+            snprintf(params, sizeof(params), "\"mappings\":%zu,\"hit_percent\":%d,\"working_set\":%zu",
+                     mappingCount, hitPercent, hot.size());
+            report("redirect_path", params, iterations, runRedirect(hot, iterations));
+
+            // 大量不同路径：超出线程缓存，走前缀树查找
+            std::vector<std::string> cold = makePaths(mappingCount, hitPercent, kDistinctPaths);
+            snprintf(params, sizeof(params), "\"mappings\":%zu,\"hit_percent\":%d,\"working_set\":%zu",
+                     mappingCount, hitPercent, cold.size());
+            report("redirect_path", params, iterations, runRedirect(cold, iterations));
+        }
+        removeMappings(mappingCount);
+    }
+}
+
+uint64_t runNormalize(const char* path, size_t iterations, bool scalar) {
+    char buffer[PATH_MAX];
+    uint64_t sink = 0;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += scalar ? FileUtils::normalizePathScalar(path, buffer, sizeof(buffer))
+                       : FileUtils::normalizePath(path, buffer, sizeof(buffer));
+    }
+    uint64_t elapsed = nowNs() - start;
+    sSink.fetch_add(sink, std::memory_order_relaxed);
+    return elapsed;
+}
+
+void benchmarkNormalizePath() {
+    size_t iterations = kBaseIterations * sIterationScale;
+    
+    // 规范路径走向量快速判断，其余路径退回逐字节规范化
+    struct Case {
+        const char* kind;
+        const char* path;
+    };
+    const Case cases[] = {
+        {"canonical_short", "/data/data/com.bench.app0/files/cache.db"},
+        {"canonical_long", "/data/user/0/io.virtualspace/virtual/data/user/0/com.bench.app0/app_webview/Default/"
+                           "Service Worker/CacheStorage/index.txt"},
+        {"dot_file", "/storage/emulated/0/Android/data/com.bench.app0/files/.nomedia"},
+        {"non_canonical", "/data//data/./com.bench.app0/../com.bench.app0/files/"},
+    };
+    
+    for (const Case& item : cases) {
+        char params[128];
+        snprintf(params, sizeof(params), "\"path\":\"%s\",\"length\":%zu,\"impl\":\"scalar\"",
+                 item.kind, strlen(item.path));
+        report("normalize_path", params, iterations, runNormalize(item.path, iterations, true));
+        
+        snprintf(params, sizeof(params), "\"path\":\"%s\",\"length\":%zu,\"impl\":\"simd\"",
+                 item.kind, strlen(item.path));
+        report("normalize_path", params, iterations, runNormalize(item.path, iterations, false));
+    }
+}
+
+void benchmarkRedirectContention() {
+    const size_t threadCounts[] = {1, 2, 4, 8};
+    const size_t mappingCount = 100;
+    size_t iterations = kBaseIterations * sIterationScale;
+
+    installMappings(mappingCount);
+    std::vector<std::string> paths = makePaths(mappingCount, 90, kDistinctPaths);
+
+    for (size_t threadCount : threadCounts) {
+        std::atomic<bool> go(false);
+        std::atomic<uint64_t> totalNs(0);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < threadCount; t++) {
+            threads.emplace_back([&]() {
+                while (!go.load(std::memory_order_acquire)) {
+                }
+                totalNs.fetch_add(runRedirect(paths, iterations), std::memory_order_relaxed);
+            });
+        }
+        go.store(true, std::memory_order_release);
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+
+        char params[128];
+        snprintf(params, sizeof(params), "\"mappings\":%zu,\"hit_percent\":90,\"threads\":%zu",
+                 mappingCount, threadCount);
+        // 报告每线程平均每次查找耗时
+        report("redirect_path_contended", params, iterations * threadCount, totalNs.load());
+    }
+
+    // 读多写少：一个线程持续增删映射，其余线程查找
+    {
+        std::atomic<bool> stop(false);
+        std::thread writer([&]() {
+            IORelocator* relocator = IORelocator::getInstance();
+            while (!stop.load(std::memory_order_relaxed)) {
+                relocator->addPathMapping("/data/data/com.bench.churn", "/data/virtual/churn");
+                relocator->removePathMapping("/data/data/com.bench.churn");
+            }
+        });
+        uint64_t elapsed = runRedirect(paths, iterations);
+        stop.store(true, std::memory_order_relaxed);
+        writer.join();
+
+        char params[128];
+        snprintf(params, sizeof(params), "\"mappings\":%zu,\"hit_percent\":90,\"threads\":1,\"writer\":true",
+                 mappingCount);
+        report("redirect_path_contended", params, iterations, elapsed);
+    }
+
+    removeMappings(mappingCount);
+}
+
+#if defined(__aarch64__)
+// Hook目标：足够长且对齐，保证开头16字节属于同一函数
+template <int N>
+__attribute__((noinline, aligned(64))) int hookTarget(int value) {
+    int result = value;
+    for (int i = 0; i < N + 4; i++) {
+        asm volatile("" : "+r"(result));
+        result = result * 31 + i;
+    }
+    return result;
+}
+
+int hookReplacement(int value) {
+    return value;
+}
+
+template <int... N>
+std::vector<void*> hookTargets(std::integer_sequence<int, N...>) {
+    return {reinterpret_cast<void*>(&hookTarget<N>)...};
+}
+
+void benchmarkHookInstall() {
+    SubstrateHook* hook = SubstrateHook::getInstance();
+    std::vector<void*> targets = hookTargets(std::make_integer_sequence<int, 32>());
+    const size_t rounds = 50 * sIterationScale;
+
+    // 逐个安装与卸载
+    uint64_t installNs = 0;
+    uint64_t uninstallNs = 0;
+    for (size_t round = 0; round < rounds; round++) {
+        uint64_t start = nowNs();
+        for (void* target : targets) {
+            hook->hookMethod(target, reinterpret_cast<void*>(&hookReplacement), nullptr);
+        }
+        installNs += nowNs() - start;
+
+        start = nowNs();
+        for (void* target : targets) {
+            hook->unhookMethod(target);
+        }
+        uninstallNs += nowNs() - start;
+    }
+
+    char params[64];
+    snprintf(params, sizeof(params), "\"hooks\":%zu,\"mode\":\"single\"", targets.size());
+    report("hook_install", params, rounds * targets.size(), installNs);
+    report("hook_uninstall", params, rounds * targets.size(), uninstallNs);
+
+    // 事务批量安装
+    uint64_t commitNs = 0;
+    for (size_t round = 0; round < rounds; round++) {
+        uint64_t start = nowNs();
+        hook->beginTransaction();
+        for (void* target : targets) {
+            hook->addHook(target, reinterpret_cast<void*>(&hookReplacement), nullptr);
+        }
+        hook->commit();
+        commitNs += nowNs() - start;
+
+        for (void* target : targets) {
+            hook->unhookMethod(target);
+        }
+    }
+    snprintf(params, sizeof(params), "\"hooks\":%zu,\"mode\":\"transaction\"", targets.size());
+    report("hook_install", params, rounds * targets.size(), commitNs);
+
+    // 查询原方法跳板
+    hook->hookMethod(targets[0], reinterpret_cast<void*>(&hookReplacement), nullptr);
+    size_t iterations = kBaseIterations * sIterationScale;
+    uint64_t sink = 0;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += reinterpret_cast<uintptr_t>(hook->getBackupMethod(targets[i % targets.size()]));
+    }
+    report("hook_lookup", "", iterations, nowNs() - start);
+    sSink.fetch_add(sink, std::memory_order_relaxed);
+    hook->unhookMethod(targets[0]);
+}
+#else
+void benchmarkHookInstall() {
+    reportSkipped("hook_install", "inline hooks are only implemented on arm64");
+}
+#endif
+
+uint64_t runStat(const char* path, size_t iterations, bool raw) {
+    struct stat st;
+    uint64_t sink = 0;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < iterations; i++) {
+        if (raw) {
+#if defined(__NR_newfstatat)
+            sink += syscall(__NR_newfstatat, AT_FDCWD, path, &st, 0);
+#else
+            sink += syscall(__NR_fstatat64, AT_FDCWD, path, &st, 0);
+#endif
+        } else {
+            sink += stat(path, &st);
+        }
+    }
+    uint64_t elapsed = nowNs() - start;
+    sSink.fetch_add(sink, std::memory_order_relaxed);
+    return elapsed;
+}
+
+uint64_t runAccess(const char* path, size_t iterations) {
+    uint64_t sink = 0;
+    uint64_t start = nowNs();
+    for (size_t i = 0; i < iterations; i++) {
+        sink += access(path, F_OK);
+    }
+    uint64_t elapsed = nowNs() - start;
+    sSink.fetch_add(sink, std::memory_order_relaxed);
+    return elapsed;
+}
+
+void benchmarkSyscallOverhead(bool hooked) {
+    size_t iterations = kBaseIterations / 4 * sIterationScale;
+    const char* mode = hooked ? "hooked" : "unhooked";
+    char params[128];
+
+    // 命中映射的路径与不在映射中的路径分别测试
+    const char* paths[] = {"/data/data/com.bench.app0/files", "/proc/self/status"};
+    const char* kinds[] = {"mapped", "unmapped"};
+    for (size_t i = 0; i < 2; i++) {
+        snprintf(params, sizeof(params), "\"path\":\"%s\",\"call\":\"raw_syscall\"", kinds[i]);
+        report("syscall_overhead", params, iterations, runStat(paths[i], iterations, true));
+
+        snprintf(params, sizeof(params), "\"path\":\"%s\",\"call\":\"stat\",\"mode\":\"%s\"", kinds[i], mode);
+        report("syscall_overhead", params, iterations, runStat(paths[i], iterations, false));
+
+        snprintf(params, sizeof(params), "\"path\":\"%s\",\"call\":\"access\",\"mode\":\"%s\"", kinds[i], mode);
+        report("syscall_overhead", params, iterations, runAccess(paths[i], iterations));
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc > 1) {
+        long scale = strtol(argv[1], nullptr, 10);
+        if (scale > 0) {
+            sIterationScale = static_cast<size_t>(scale);
+        }
+    }
+    if (__system_property_get("ro.product.model", sDevice) <= 0) {
+        strcpy(sDevice, "unknown");
+    }
+    srand(1);
+
+    // 未安装Hook时的libc基线
+    benchmarkSyscallOverhead(false);
+    benchmarkNormalizePath();
+
+    IORelocator* relocator = IORelocator::getInstance();
+    if (!relocator->initialize()) {
+        fprintf(stderr, "Failed to initialize IORelocator\n");
+        return 1;
+    }
+
+    benchmarkRedirectPath();
+    benchmarkRedirectContention();
+
+    installMappings(10);
+    benchmarkSyscallOverhead(true);
+    removeMappings(10);
+
+    benchmarkHookInstall();
+
+    relocator->cleanup();
+    return sSink.load() == 0xFFFFFFFFFFFFFFFFULL ? 2 : 0;
+}
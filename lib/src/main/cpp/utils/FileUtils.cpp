@@ -0,0 +1,203 @@
+#include "FileUtils.h"
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace VirtualSpace {
+
+namespace {
+
+// 位于index的'/'之后是否为空组件、"."、".."或路径结尾（根路径除外），path以'\0'结尾
+inline bool isBadSeparator(const char* path, size_t index) {
+    char c = path[index + 1];
+    if (c == '\0') {
+        return index != 0;
+    }
+    if (c == '/') {
+        return true;
+    }
+    if (c != '.') {
+        return false;
+    }
+    c = path[index + 2];
+    if (c == '\0' || c == '/') {
+        return true;
+    }
+    if (c != '.') {
+        return false;
+    }
+    c = path[index + 3];
+    return c == '\0' || c == '/';
+}
+
+} // namespace
+
+std::string FileUtils::normalizePath(const std::string& path) {
+    if (path.empty()) {
+        return std::string();
+    }
+    
+    std::string result(path.length() + 1, '\0');
+    size_t length = normalizePath(path.c_str(), &result[0], result.size());
+    result.resize(length);
+    return result;
+}
+
+bool FileUtils::isCanonicalPathScalar(const char* path, size_t length) {
+    if (length == 0 || path[0] != '/') {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        if (path[i] == '/' && isBadSeparator(path, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool FileUtils::isCanonicalPath(const char* path, size_t length) {
+    if (length == 0 || path[0] != '/') {
+        return false;
+    }
+    
+    // 每次取16字节及其后错开1字节的16字节，找出后面跟着'/'、'.'或'\0'的'/'，
+    // 只有这些候选位置需要进一步判断；第二次加载最多读到结尾的'\0'
+    size_t i = 0;
+#if defined(__aarch64__)
+    const uint8x16_t slash = vdupq_n_u8('/');
+    const uint8x16_t dot = vdupq_n_u8('.');
+    for (; i + 16 <= length; i += 16) {
+        uint8x16_t current = vld1q_u8(reinterpret_cast<const uint8_t*>(path + i));
+        uint8x16_t next = vld1q_u8(reinterpret_cast<const uint8_t*>(path + i + 1));
+        uint8x16_t special = vorrq_u8(vorrq_u8(vceqq_u8(next, slash), vceqq_u8(next, dot)), vceqzq_u8(next));
+        uint8x16_t candidate = vandq_u8(vceqq_u8(current, slash), special);
+        // 每字节压缩为4位的掩码
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(candidate), 4)), 0);
+        while (mask != 0) {
+            size_t offset = static_cast<size_t>(__builtin_ctzll(mask)) >> 2;
+            if (isBadSeparator(path, i + offset)) {
+                return false;
+            }
+            mask &= ~(0xFULL << (offset * 4));
+        }
+    }
+#elif defined(__SSE2__)
+    const __m128i slash = _mm_set1_epi8('/');
+    const __m128i dot = _mm_set1_epi8('.');
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i current = _mm_loadu_si128(reinterpret_cast<const __m128i*>(path + i));
+        __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(path + i + 1));
+        __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(next, slash), _mm_cmpeq_epi8(next, dot)),
+                                       _mm_cmpeq_epi8(next, zero));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(current, slash), special)));
+        while (mask != 0) {
+            if (isBadSeparator(path, i + __builtin_ctz(mask))) {
+                return false;
+            }
+            mask &= mask - 1;
+        }
+    }
+#endif
+    
+    for (; i < length; i++) {
+        if (path[i] == '/' && isBadSeparator(path, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t FileUtils::normalizePath(const char* path, char* out, size_t capacity) {
+    if (path == nullptr || out == nullptr || path[0] == '\0') {
+        return 0;
+    }
+    
+    size_t inputLength = strlen(path);
+    if (inputLength + 1 > capacity) {
+        return 0;
+    }
+    
+    // 框架传来的路径绝大多数已是规范形式，整段复制即可
+    if (isCanonicalPath(path, inputLength)) {
+        memmove(out, path, inputLength + 1);
+        return inputLength;
+    }
+    return normalizePathScalar(path, out, capacity);
+}
+
+size_t FileUtils::normalizePathScalar(const char* path, char* out, size_t capacity) {
+    if (path == nullptr || out == nullptr || path[0] == '\0') {
+        return 0;
+    }
+    
+    size_t inputLength = strlen(path);
+    if (inputLength + 1 > capacity) {
+        return 0;
+    }
+    
+    bool absolute = path[0] == '/';
+    // 写指针始终不超过读指针，因此可以原地处理
+    size_t write = 0;
+    if (absolute) {
+        out[write++] = '/';
+    }
+    size_t root = write;
+    
+    size_t read = 0;
+    while (read < inputLength) {
+        while (read < inputLength && path[read] == '/') {
+            read++;
+        }
+        if (read >= inputLength) {
+            break;
+        }
+        
+        size_t start = read;
+        while (read < inputLength && path[read] != '/') {
+            read++;
+        }
+        size_t componentLength = read - start;
+        
+        // 跳过"."
+        if (componentLength == 1 && path[start] == '.') {
+            continue;
+        }
+        
+        // ".."回退到上一级，绝对路径不会越过根目录
+        if (componentLength == 2 && path[start] == '.' && path[start + 1] == '.') {
+            size_t last = write;
+            while (last > root && out[last - 1] != '/') {
+                last--;
+            }
+            bool parentIsDotDot = (write - last == 2 && out[last] == '.' && out[last + 1] == '.');
+            if (write > root && !parentIsDotDot) {
+                write = (last > root) ? last - 1 : root;
+                continue;
+            }
+            if (absolute) {
+                continue;
+            }
+        }
+        
+        if (write > root) {
+            out[write++] = '/';
+        }
+        memmove(out + write, path + start, componentLength);
+        write += componentLength;
+    }
+    
+    if (write == 0) {
+        // 相对路径被完全消去时表示当前目录
+        out[write++] = '.';
+    }
+    out[write] = '\0';
+    return write;
+}
+
+} // namespace VirtualSpace
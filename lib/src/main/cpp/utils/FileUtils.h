@@ -0,0 +1,53 @@
+#ifndef FILE_UTILS_H
+#define FILE_UTILS_H
+
+#include <string>
+#include <stddef.h>
+
+namespace VirtualSpace {
+
+/**
+ * 文件路径工具类
+ */
+class FileUtils {
+public:
+    /**
+     * 规范化路径
+     * 合并重复的'/'，消除"."和".."组件，去掉末尾的'/'
+     * @param path 原始路径
+     * @return 规范化后的路径，输入为空时返回空串
+     */
+    static std::string normalizePath(const std::string& path);
+    
+    /**
+     * 规范化路径到调用方提供的缓冲区，不分配堆内存
+     * 输出不会长于输入，允许out与path为同一块内存
+     * @param path 原始路径（以'\0'结尾）
+     * @param out 输出缓冲区
+     * @param capacity 输出缓冲区大小（含结尾'\0'）
+     * @return 规范化后的长度，输入为空或缓冲区不足时返回0
+     */
+    static size_t normalizePath(const char* path, char* out, size_t capacity);
+    
+    /**
+     * 逐字节规范化，不做规范形式的快速判断，参数和返回值同normalizePath()
+     */
+    static size_t normalizePathScalar(const char* path, char* out, size_t capacity);
+    
+    /**
+     * 判断绝对路径是否已是规范形式：没有空组件、"."、".."和末尾的'/'。
+     * ARM64用NEON、x86用SSE2每次检查16字节，其他架构退回逐字节检查
+     * @param path 路径，path[length]必须为'\0'
+     * @param length 路径长度
+     */
+    static bool isCanonicalPath(const char* path, size_t length);
+    
+    /**
+     * isCanonicalPath()的逐字节实现
+     */
+    static bool isCanonicalPathScalar(const char* path, size_t length);
+};
+
+} // namespace VirtualSpace
+
+#endif // FILE_UTILS_H
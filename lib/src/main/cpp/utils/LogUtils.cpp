@@ -0,0 +1,12 @@
+#include "LogUtils.h"
+
+namespace VirtualSpace {
+
+// 默认每64条采样日志输出1条
+std::atomic<uint32_t> LogUtils::sSampleInterval(64);
+
+void LogUtils::setSampleInterval(uint32_t interval) {
+    sSampleInterval.store(interval, std::memory_order_relaxed);
+}
+
+} // namespace VirtualSpace
@@ -0,0 +1,92 @@
+#ifndef LOG_UTILS_H
+#define LOG_UTILS_H
+
+#include <android/log.h>
+#include <atomic>
+#include <stdint.h>
+
+// 编译期最低日志级别（android_LogPriority取值），由CMake选项VIRTUALSPACE_LOG_LEVEL传入
+// 低于该级别的日志在编译期整体移除，格式化参数也不会被求值
+#ifndef VIRTUALSPACE_LOG_LEVEL
+#ifdef NDEBUG
+#define VIRTUALSPACE_LOG_LEVEL ANDROID_LOG_WARN
+#else
+#define VIRTUALSPACE_LOG_LEVEL ANDROID_LOG_DEBUG
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define VS_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define VS_UNLIKELY(x) (x)
+#endif
+
+namespace VirtualSpace {
+
+/**
+ * 日志工具类
+ */
+class LogUtils {
+public:
+    static constexpr int kMinLevel = VIRTUALSPACE_LOG_LEVEL;
+
+    static constexpr bool isLevelEnabled(int level) {
+        return level >= kMinLevel;
+    }
+
+    /**
+     * 设置采样日志的间隔：每interval条输出1条，0表示全部丢弃
+     */
+    static void setSampleInterval(uint32_t interval);
+
+    static inline uint32_t getSampleInterval() {
+        return sSampleInterval.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * 按调用点计数判断本条采样日志是否输出
+     * @param counter 调用点私有的计数器
+     */
+    static inline bool shouldSample(std::atomic<uint32_t>& counter) {
+        uint32_t interval = getSampleInterval();
+        if (interval == 0) {
+            return false;
+        }
+        return counter.fetch_add(1, std::memory_order_relaxed) % interval == 0;
+    }
+
+private:
+    static std::atomic<uint32_t> sSampleInterval;
+};
+
+} // namespace VirtualSpace
+
+#define VS_LOG(level, tag, ...) \
+    do { \
+        if constexpr (VirtualSpace::LogUtils::isLevelEnabled(level)) { \
+            __android_log_print(level, tag, __VA_ARGS__); \
+        } \
+    } while (0)
+
+// 热路径使用的采样日志：级别在编译期过滤，通过后再按调用点采样
+#define VS_LOG_SAMPLED(level, tag, ...) \
+    do { \
+        if constexpr (VirtualSpace::LogUtils::isLevelEnabled(level)) { \
+            static std::atomic<uint32_t> logSampleCounter(0); \
+            if (VS_UNLIKELY(VirtualSpace::LogUtils::shouldSample(logSampleCounter))) { \
+                __android_log_print(level, tag, __VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOGV(tag, ...) VS_LOG(ANDROID_LOG_VERBOSE, tag, __VA_ARGS__)
+#define LOGD(tag, ...) VS_LOG(ANDROID_LOG_DEBUG, tag, __VA_ARGS__)
+#define LOGI(tag, ...) VS_LOG(ANDROID_LOG_INFO, tag, __VA_ARGS__)
+#define LOGW(tag, ...) VS_LOG(ANDROID_LOG_WARN, tag, __VA_ARGS__)
+#define LOGE(tag, ...) VS_LOG(ANDROID_LOG_ERROR, tag, __VA_ARGS__)
+
+#define LOGD_SAMPLED(tag, ...) VS_LOG_SAMPLED(ANDROID_LOG_DEBUG, tag, __VA_ARGS__)
+#define LOGW_SAMPLED(tag, ...) VS_LOG_SAMPLED(ANDROID_LOG_WARN, tag, __VA_ARGS__)
+#define LOGE_SAMPLED(tag, ...) VS_LOG_SAMPLED(ANDROID_LOG_ERROR, tag, __VA_ARGS__)
+
+#endif // LOG_UTILS_H
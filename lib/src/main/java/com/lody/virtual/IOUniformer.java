@@ -1,9 +1,15 @@
 package com.lody.virtual;
 
 import android.content.Context;
+import android.content.pm.PackageInfo;
+import android.os.ParcelFileDescriptor;
 import android.util.Log;
 
 import java.io.File;
+import java.nio.ByteBuffer;
+import java.nio.charset.StandardCharsets;
+import java.util.LinkedHashMap;
+import java.util.Map;
 import java.util.concurrent.ConcurrentHashMap;
 import java.util.concurrent.atomic.AtomicBoolean;
 
@@ -14,18 +20,67 @@ import java.util.concurrent.atomic.AtomicBoolean;
 public class IOUniformer {
     
     private static final String TAG = "IOUniformer";
+    
+    // 预编译映射表，默认映射变化时需递增版本号使旧文件失效
+    private static final String PATH_TABLE_FILE = "path_table.bin";
+    private static final long PATH_TABLE_VERSION = 1;
+    
+    // 跨进程共享映射表的容量上限
+    private static final int SHARED_TABLE_CAPACITY = 256 * 1024;
+    
+    // waitForHooksReady()的结果，前三个与Native层一致
+    public static final int HOOKS_READY = 0;            // 全部安装成功
+    public static final int HOOKS_PENDING = 1;          // 超时时仍在后台安装
+    public static final int HOOKS_FAILED = 2;           // 安装失败
+    public static final int HOOKS_NOT_INSTALLED = 3;    // 本进程未初始化或只作为发布端，没有需要等待的Hook
     private static IOUniformer sInstance;
     
     private Context mContext;
     private AtomicBoolean mIsInitialized = new AtomicBoolean(false);
+    private AtomicBoolean mSharedTableAttached = new AtomicBoolean(false);
+    // 宿主只发布映射，本进程没有安装Hook
+    private volatile boolean mPublisherOnly = false;
+    private volatile boolean mStagedHookInstall = true;
     private ConcurrentHashMap<String, String> mPathMappings = new ConcurrentHashMap<>();
     
+    // 每线程复用的直接缓冲区，路径重定向未命中时不产生任何Java对象
+    private static final int PATH_BUFFER_SIZE = 4096;
+    private static final ThreadLocal<PathBuffer> sPathBuffer = new ThreadLocal<PathBuffer>() {
+        @Override
+        protected PathBuffer initialValue() {
+            return new PathBuffer();
+        }
+    };
+    
+    private static final class PathBuffer {
+        final ByteBuffer direct = ByteBuffer.allocateDirect(PATH_BUFFER_SIZE);
+        final byte[] bytes = new byte[PATH_BUFFER_SIZE];
+    }
+    
     // Native方法声明
     private native boolean nativeInitialize();
+    private native boolean nativeInitializePublisher();
     private native void nativeCleanup();
+    private native void nativeSetPathTable(String filePath, long configVersion);
+    private native boolean nativeIsPathTableLoaded();
+    private native boolean nativeSavePathTable();
+    private native String[] nativeGetPathMappings();
+    private native void nativeSetStagedInstall(boolean staged);
+    private native void nativeSetRootFdMode(boolean enabled);
+    private native int nativeWaitForHooks(int timeoutMs);
+    private native boolean nativeCreateSharedTable(int slotCapacity);
+    private native int nativeGetSharedTableFd();
+    private native boolean nativeAttachSharedTable(int fd);
     private native boolean nativeAddPathMapping(String originalPath, String virtualPath);
+    private native int nativeAddPathMappings(String[] originalPaths, String[] virtualPaths);
     private native boolean nativeRemovePathMapping(String originalPath);
     private native String nativeRedirectPath(String originalPath);
+    private native int nativeRedirectPathBuffer(ByteBuffer buffer, int length);
+    private native void nativeGetRedirectCacheStats(long[] stats);
+    private native int nativeAddNamespaceMappings(String namespaceName, String[] originalPaths, String[] virtualPaths);
+    private native boolean nativeRemoveNamespace(String namespaceName);
+    private native boolean nativeSetActiveNamespace(String namespaceName);
+    private native boolean nativeSetThreadNamespace(String namespaceName);
     
     static {
         try {
@@ -57,25 +112,67 @@ public class IOUniformer {
      * @return 初始化是否成功
      */
     public boolean initialize(Context context) {
+        return initializeInternal(context, false);
+    }
+    
+    /**
+     * 宿主进程：初始化映射并准备通过共享映射表发布给虚拟进程
+     * 不在宿主进程中安装任何文件Hook，宿主自身的IO保持原样
+     * @param context 应用上下文
+     * @return 初始化是否成功
+     */
+    public boolean initializePublisher(Context context) {
+        return initializeInternal(context, true);
+    }
+    
+    private boolean initializeInternal(Context context, boolean publisherOnly) {
         if (mIsInitialized.get()) {
+            // 已作为发布端初始化的进程没有Hook，不能再当作虚拟进程使用
+            if (mPublisherOnly && !publisherOnly) {
+                Log.e(TAG, "IOUniformer already initialized as publisher, hooks not installed");
+                return false;
+            }
             Log.w(TAG, "IOUniformer already initialized");
             return true;
         }
         
         try {
-            Log.d(TAG, "Initializing IOUniformer...");
+            Log.d(TAG, publisherOnly ? "Initializing IOUniformer as publisher..." : "Initializing IOUniformer...");
             
             mContext = context.getApplicationContext();
             
-            // 初始化Native层
-            if (!nativeInitialize()) {
+            // 指定预编译映射表，Native层初始化时直接映射
+            String pathTableFile = getPathTableFile();
+            if (pathTableFile != null) {
+                nativeSetPathTable(pathTableFile, getPathTableVersion());
+            }
+            
+            // 分阶段安装Hook，目录和低频系统调用的Hook不阻塞当前线程
+            nativeSetStagedInstall(mStagedHookInstall);
+            
+            // 初始化Native层，发布端不安装Hook
+            if (!(publisherOnly ? nativeInitializePublisher() : nativeInitialize())) {
                 Log.e(TAG, "Failed to initialize native layer");
                 return false;
             }
             
-            // 设置默认路径映射
-            setupDefaultPathMappings();
+            // 映射表缺失或过期时重新设置默认路径映射，并写回映射表；
+            // 已映射宿主共享映射表的虚拟进程直接使用宿主的映射
+            if (mSharedTableAttached.get()) {
+                Log.d(TAG, "Default path mappings provided by shared mapping table");
+            } else if (nativeIsPathTableLoaded()) {
+                // 映射来自文件，Java层映射表按Native层回填，保持两边一致
+                loadPathMappingsFromNative();
+                Log.d(TAG, "Default path mappings loaded from path table");
+            } else {
+                // 没有任何映射时不写文件，否则空表会被当作有效映射表一直沿用
+                int added = setupDefaultPathMappings();
+                if (pathTableFile != null && added > 0 && !nativeSavePathTable()) {
+                    Log.w(TAG, "Failed to save path table");
+                }
+            }
             
+            mPublisherOnly = publisherOnly;
             mIsInitialized.set(true);
             Log.d(TAG, "IOUniformer initialized successfully");
             return true;
@@ -86,6 +183,48 @@ public class IOUniformer {
         }
     }
     
+    /**
+     * 设置是否分阶段安装Hook，需在initialize()之前调用
+     * 分阶段时只同步安装打开和属性查询相关的Hook，其余在后台线程安装，
+     * 启动虚拟应用前需通过waitForHooksReady()等待
+     * @param staged 是否分阶段安装
+     */
+    public void setStagedHookInstall(boolean staged) {
+        mStagedHookInstall = staged;
+    }
+    
+    /**
+     * 设置是否按根目录fd重定向，可在任意时刻调用
+     * 开启后每个映射的虚拟根目录保持一个目录fd，重定向后的调用相对该fd进行，
+     * 省去内核对完整虚拟路径的逐级查找
+     * @param enabled 是否开启
+     */
+    public void setRootFdRedirect(boolean enabled) {
+        try {
+            nativeSetRootFdMode(enabled);
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to set root fd redirect", e);
+        }
+    }
+    
+    /**
+     * 等待全部Hook安装完成
+     * @param timeoutMs 超时时间（毫秒），小于0表示一直等待
+     * @return HOOKS_READY、HOOKS_PENDING、HOOKS_FAILED或HOOKS_NOT_INSTALLED
+     */
+    public int waitForHooksReady(int timeoutMs) {
+        if (!mIsInitialized.get() || mPublisherOnly) {
+            return HOOKS_NOT_INSTALLED;
+        }
+        
+        try {
+            return nativeWaitForHooks(timeoutMs);
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to wait for hooks", e);
+            return HOOKS_FAILED;
+        }
+    }
+    
     /**
      * 检查是否已初始化
      */
@@ -95,6 +234,7 @@ public class IOUniformer {
     
     /**
      * 添加路径映射
+     * 原始路径中的"*"组件匹配任意单个组件，虚拟路径中可用$1~$9引用对应的组件
      * @param originalPath 原始路径
      * @param virtualPath 虚拟路径
      * @return 是否成功
@@ -135,6 +275,173 @@ public class IOUniformer {
         }
     }
     
+    /**
+     * 批量添加路径映射，只跨越一次JNI并只重建一次Native查找结构
+     * @param mappings 原始路径 -> 虚拟路径
+     * @return 成功添加的映射数
+     */
+    public int addPathMappings(Map<String, String> mappings) {
+        if (!mIsInitialized.get()) {
+            Log.e(TAG, "IOUniformer not initialized");
+            return 0;
+        }
+        
+        return addPathMappingsInternal(mappings);
+    }
+    
+    /**
+     * 批量添加路径映射，不检查初始化状态，供initialize()设置默认映射时使用
+     * @param mappings 原始路径 -> 虚拟路径
+     * @return 成功添加的映射数
+     */
+    private int addPathMappingsInternal(Map<String, String> mappings) {
+        if (mappings == null || mappings.isEmpty()) {
+            return 0;
+        }
+        
+        try {
+            String[][] paths = toNormalizedArrays(mappings);
+            String[] originalPaths = paths[0];
+            String[] virtualPaths = paths[1];
+            int count = originalPaths.length;
+            
+            // 添加到Native层
+            int added = nativeAddPathMappings(originalPaths, virtualPaths);
+            if (added < 0) {
+                Log.e(TAG, "Failed to add path mappings to native layer");
+                return 0;
+            }
+            
+            // 添加到Java层缓存
+            for (int i = 0; i < count; i++) {
+                mPathMappings.put(originalPaths[i], virtualPaths[i]);
+            }
+            
+            Log.d(TAG, "Added " + added + " path mappings");
+            return added;
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Exception adding path mappings", e);
+            return 0;
+        }
+    }
+    
+    /**
+     * 向指定映射命名空间批量添加映射，命名空间不存在时创建
+     * 同一进程内运行多个虚拟应用时，每个应用一个命名空间，切换时无需重建映射
+     * @param namespaceName 命名空间名，如虚拟应用包名
+     * @param mappings 原始路径 -> 虚拟路径
+     * @return 成功添加的映射数
+     */
+    public int addNamespaceMappings(String namespaceName, Map<String, String> mappings) {
+        if (!mIsInitialized.get()) {
+            Log.e(TAG, "IOUniformer not initialized");
+            return 0;
+        }
+        
+        if (namespaceName == null || mappings == null || mappings.isEmpty()) {
+            return 0;
+        }
+        
+        try {
+            String[][] paths = toNormalizedArrays(mappings);
+            int added = nativeAddNamespaceMappings(namespaceName, paths[0], paths[1]);
+            if (added < 0) {
+                Log.e(TAG, "Failed to add mappings to namespace " + namespaceName);
+                return 0;
+            }
+            
+            Log.d(TAG, "Added " + added + " path mappings to namespace " + namespaceName);
+            return added;
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Exception adding namespace mappings", e);
+            return 0;
+        }
+    }
+    
+    /**
+     * 清空并停用映射命名空间
+     * @param namespaceName 命名空间名
+     * @return 是否成功
+     */
+    public boolean removeNamespace(String namespaceName) {
+        if (!mIsInitialized.get() || namespaceName == null) {
+            return false;
+        }
+        
+        try {
+            return nativeRemoveNamespace(namespaceName);
+        } catch (Exception e) {
+            Log.e(TAG, "Exception removing namespace", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 切换进程的活动映射命名空间，只替换Native层的指针
+     * @param namespaceName 命名空间名，""为默认命名空间
+     * @return 是否成功
+     */
+    public boolean setActiveNamespace(String namespaceName) {
+        if (!mIsInitialized.get() || namespaceName == null) {
+            return false;
+        }
+        
+        try {
+            return nativeSetActiveNamespace(namespaceName);
+        } catch (Exception e) {
+            Log.e(TAG, "Exception switching namespace", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 为当前线程指定映射命名空间，优先于进程的活动命名空间
+     * @param namespaceName 命名空间名，null表示取消
+     * @return 是否成功
+     */
+    public boolean setThreadNamespace(String namespaceName) {
+        if (!mIsInitialized.get()) {
+            return false;
+        }
+        
+        try {
+            return nativeSetThreadNamespace(namespaceName);
+        } catch (Exception e) {
+            Log.e(TAG, "Exception setting thread namespace", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 规范化映射并拆成两个等长数组，跳过无效项
+     * @return {原始路径数组, 虚拟路径数组}
+     */
+    private String[][] toNormalizedArrays(Map<String, String> mappings) {
+        String[] originalPaths = new String[mappings.size()];
+        String[] virtualPaths = new String[mappings.size()];
+        int count = 0;
+        for (Map.Entry<String, String> entry : mappings.entrySet()) {
+            if (entry.getKey() == null || entry.getValue() == null) {
+                Log.e(TAG, "Invalid path mapping");
+                continue;
+            }
+            originalPaths[count] = normalizePath(entry.getKey());
+            virtualPaths[count] = normalizePath(entry.getValue());
+            count++;
+        }
+        if (count < originalPaths.length) {
+            String[] trimmedOriginal = new String[count];
+            String[] trimmedVirtual = new String[count];
+            System.arraycopy(originalPaths, 0, trimmedOriginal, 0, count);
+            System.arraycopy(virtualPaths, 0, trimmedVirtual, 0, count);
+            originalPaths = trimmedOriginal;
+            virtualPaths = trimmedVirtual;
+        }
+        return new String[][] {originalPaths, virtualPaths};
+    }
+    
     /**
      * 移除路径映射
      * @param originalPath 原始路径
@@ -221,8 +528,9 @@ public class IOUniformer {
             }
             
             // 使用Native层重定向
+            // 未命中时Native层返回同一个引用
             String nativeRedirectedPath = nativeRedirectPath(normalizedPath);
-            if (!normalizedPath.equals(nativeRedirectedPath)) {
+            if (nativeRedirectedPath != normalizedPath) {
                 Log.d(TAG, "Native path redirected: " + normalizedPath + " -> " + nativeRedirectedPath);
                 return nativeRedirectedPath;
             }
@@ -236,6 +544,116 @@ public class IOUniformer {
         }
     }
     
+    /**
+     * 宿主进程：创建跨进程共享映射表，之后的映射变更会自动发布给所有虚拟进程
+     * 需先调用initializePublisher()
+     * @return 是否成功
+     */
+    public boolean createSharedMappingTable() {
+        if (!mIsInitialized.get()) {
+            Log.e(TAG, "IOUniformer not initialized");
+            return false;
+        }
+        
+        try {
+            return nativeCreateSharedTable(SHARED_TABLE_CAPACITY);
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to create shared mapping table", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 宿主进程：获取交给虚拟进程的共享映射表只读描述符，由调用方负责关闭
+     * @return 文件描述符，未创建共享映射表时返回null
+     */
+    public ParcelFileDescriptor getSharedMappingTableFd() {
+        try {
+            int fd = nativeGetSharedTableFd();
+            return fd >= 0 ? ParcelFileDescriptor.adoptFd(fd) : null;
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to get shared mapping table fd", e);
+            return null;
+        }
+    }
+    
+    /**
+     * 虚拟进程：映射宿主的共享映射表，需在initialize()之前调用
+     * 映射表只在宿主中保存一份，本进程不再重建默认映射，也不占用Java层映射表
+     * @param fd 宿主传来的描述符，调用后由Native层持有
+     * @return 是否成功
+     */
+    public boolean attachSharedMappingTable(ParcelFileDescriptor fd) {
+        if (fd == null) {
+            return false;
+        }
+        
+        try {
+            boolean success = nativeAttachSharedTable(fd.detachFd());
+            mSharedTableAttached.set(success);
+            return success;
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to attach shared mapping table", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 通过每线程直接缓冲区重定向路径，供Hook热路径使用
+     * 跳过Java层映射表，规范化和查找全部在Native层完成
+     * @param path 原始路径
+     * @return 重定向后的路径；未映射时返回传入的同一个对象，可用==判断
+     */
+    public String redirectPathDirect(String path) {
+        if (!mIsInitialized.get() || path == null) {
+            return path;
+        }
+        
+        try {
+            PathBuffer buffer = sPathBuffer.get();
+            int length = encodeAscii(path, buffer.direct);
+            if (length < 0) {
+                // 含非ASCII字符或过长，退回jstring接口，未命中时同样返回原对象
+                return nativeRedirectPath(path);
+            }
+            
+            int redirectedLength = nativeRedirectPathBuffer(buffer.direct, length);
+            if (redirectedLength <= 0) {
+                return path;
+            }
+            
+            // 只有命中映射时才创建新字符串
+            buffer.direct.clear();
+            buffer.direct.get(buffer.bytes, 0, redirectedLength);
+            return new String(buffer.bytes, 0, redirectedLength, StandardCharsets.UTF_8);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Exception redirecting path", e);
+            return path;
+        }
+    }
+    
+    /**
+     * 将ASCII路径逐字节写入直接缓冲区
+     * @return 写入的字节数；遇到非ASCII字符或超出缓冲区时返回-1
+     */
+    private static int encodeAscii(String path, ByteBuffer buffer) {
+        int length = path.length();
+        if (length == 0 || length >= PATH_BUFFER_SIZE) {
+            return -1;
+        }
+        
+        buffer.clear();
+        for (int i = 0; i < length; i++) {
+            char c = path.charAt(i);
+            if (c == 0 || c >= 0x80) {
+                return -1;
+            }
+            buffer.put(i, (byte) c);
+        }
+        return length;
+    }
+    
     /**
      * 启动IO重定向
      * @return 是否成功
@@ -300,6 +718,7 @@ public class IOUniformer {
             // 清理Java层缓存
             mPathMappings.clear();
             
+            mPublisherOnly = false;
             mIsInitialized.set(false);
             Log.d(TAG, "IOUniformer cleanup completed");
             
@@ -308,32 +727,81 @@ public class IOUniformer {
         }
     }
     
+    /**
+     * 获取预编译映射表文件路径
+     */
+    private String getPathTableFile() {
+        String dataDir = VEnvironment.getInstance(mContext).getDataDir();
+        if (dataDir == null) {
+            return null;
+        }
+        return dataDir + "/" + PATH_TABLE_FILE;
+    }
+    
+    /**
+     * 映射表配置版本：安装或升级后lastUpdateTime变化，旧映射表随之失效
+     */
+    private long getPathTableVersion() {
+        long lastUpdateTime = 0;
+        try {
+            PackageInfo packageInfo = mContext.getPackageManager().getPackageInfo(mContext.getPackageName(), 0);
+            lastUpdateTime = packageInfo.lastUpdateTime;
+        } catch (Exception e) {
+            Log.w(TAG, "Failed to get package info", e);
+        }
+        return lastUpdateTime * 31 + PATH_TABLE_VERSION;
+    }
+    
+    /**
+     * 用Native层当前的默认映射回填Java层映射表
+     */
+    private void loadPathMappingsFromNative() {
+        try {
+            String[] pairs = nativeGetPathMappings();
+            if (pairs == null) {
+                return;
+            }
+            for (int i = 0; i + 1 < pairs.length; i += 2) {
+                mPathMappings.put(pairs[i], pairs[i + 1]);
+            }
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to load path mappings from native layer", e);
+        }
+    }
+    
     /**
      * 设置默认路径映射
+     * @return 成功添加的映射数
      */
-    private void setupDefaultPathMappings() {
+    private int setupDefaultPathMappings() {
         try {
             Log.d(TAG, "Setting up default path mappings...");
             
+            Map<String, String> mappings = new LinkedHashMap<>();
+            
             // 数据目录映射
             String realDataDir = mContext.getApplicationInfo().dataDir;
             String virtualDataDir = VEnvironment.getInstance(mContext).getVirtualDataPath("default");
-            addPathMapping(realDataDir, virtualDataDir);
+            mappings.put(realDataDir, virtualDataDir);
             
             // 缓存目录映射
             String realCacheDir = mContext.getCacheDir().getAbsolutePath();
             String virtualCacheDir = VEnvironment.getInstance(mContext).getVirtualCachePath("default");
-            addPathMapping(realCacheDir, virtualCacheDir);
+            mappings.put(realCacheDir, virtualCacheDir);
             
             // 外部存储目录映射
             String realExternalDir = mContext.getExternalFilesDir(null).getAbsolutePath();
             String virtualExternalDir = VEnvironment.getInstance(mContext).getVirtualExternalPath("default");
-            addPathMapping(realExternalDir, virtualExternalDir);
+            mappings.put(realExternalDir, virtualExternalDir);
+            
+            int added = addPathMappingsInternal(mappings);
             
             Log.d(TAG, "Default path mappings setup completed");
+            return added;
             
         } catch (Exception e) {
             Log.e(TAG, "Failed to setup default path mappings", e);
+            return 0;
         }
     }
     
@@ -366,6 +834,25 @@ public class IOUniformer {
         }
     }
     
+    /**
+     * 获取Native层线程重定向缓存的命中统计
+     * @return {命中次数, 未命中次数}
+     */
+    public long[] getRedirectCacheStats() {
+        long[] stats = new long[2];
+        if (!mIsInitialized.get()) {
+            return stats;
+        }
+        
+        try {
+            nativeGetRedirectCacheStats(stats);
+        } catch (Exception e) {
+            Log.e(TAG, "Exception getting redirect cache stats", e);
+        }
+        
+        return stats;
+    }
+    
     /**
      * 获取所有路径映射
      */
@@ -4,10 +4,17 @@ import android.content.Context;
 import android.content.Intent;
 import android.content.pm.PackageManager;
 import android.content.pm.ResolveInfo;
+import android.os.Binder;
+import android.os.Bundle;
+import android.os.IBinder;
+import android.os.Parcel;
+import android.os.ParcelFileDescriptor;
 import android.os.Process;
+import android.os.RemoteException;
 import android.util.Log;
 
 import java.io.File;
+import java.io.FileDescriptor;
 import java.util.ArrayList;
 import java.util.List;
 import java.util.concurrent.ConcurrentHashMap;
@@ -20,6 +27,9 @@ import java.util.concurrent.atomic.AtomicInteger;
 public class ProcessManager {
     
     private static final String TAG = "ProcessManager";
+    
+    // 启动Intent中提供共享映射表的Binder；Intent不能直接携带文件描述符
+    public static final String EXTRA_MAPPING_TABLE = "com.lody.virtual.extra.MAPPING_TABLE";
     private static ProcessManager sInstance;
     
     private Context mContext;
@@ -379,6 +389,21 @@ public class ProcessManager {
         try {
             Log.d(TAG, "Creating virtual environment for process: " + processInfo.processId);
             
+            // 共享映射表在首次启动虚拟进程时创建，之后所有虚拟进程共用宿主的一份
+            // 宿主只作为发布端初始化，不给自己安装文件Hook
+            IOUniformer ioUniformer = IOUniformer.getInstance();
+            if (!ioUniformer.isInitialized() && !ioUniformer.initializePublisher(mContext)) {
+                Log.w(TAG, "Failed to initialize mapping publisher");
+            }
+            ParcelFileDescriptor mappingTableFd = ioUniformer.getSharedMappingTableFd();
+            if (mappingTableFd == null && ioUniformer.createSharedMappingTable()) {
+                mappingTableFd = ioUniformer.getSharedMappingTableFd();
+            }
+            if (mappingTableFd == null) {
+                Log.w(TAG, "Shared mapping table unavailable, process will build its own mappings");
+            }
+            processInfo.mappingTableFd = mappingTableFd;
+            
             // TODO: 实现虚拟环境创建
             // - 设置虚拟数据目录
             // - 配置虚拟权限
@@ -401,6 +426,12 @@ public class ProcessManager {
         try {
             Log.d(TAG, "Cleaning up virtual environment for process: " + processInfo.processId);
             
+            // 关闭交给虚拟进程的共享映射表描述符
+            if (processInfo.mappingTableFd != null) {
+                processInfo.mappingTableFd.close();
+                processInfo.mappingTableFd = null;
+            }
+            
             // TODO: 实现虚拟环境清理
             // - 清理临时文件
             // - 释放资源
@@ -423,6 +454,13 @@ public class ProcessManager {
         try {
             Log.d(TAG, "Starting virtual activity for process: " + processInfo.processId);
             
+            Intent launchIntent = new Intent(Intent.ACTION_MAIN);
+            launchIntent.setPackage(processInfo.packageName);
+            if (processInfo.mainActivity != null) {
+                launchIntent.setClassName(processInfo.packageName, processInfo.mainActivity);
+            }
+            putLaunchExtras(launchIntent, processInfo);
+            
             // TODO: 实现虚拟Activity启动
             // - 解析APK获取主Activity
             // - 创建虚拟Intent
@@ -436,6 +474,93 @@ public class ProcessManager {
         }
     }
     
+    /**
+     * 向启动Intent写入虚拟进程初始化所需的参数
+     * 共享映射表以Binder传递，虚拟进程在IOUniformer.initialize()之前通过attachMappingTable()取得只读描述符
+     * @param intent 启动Intent
+     * @param processInfo 进程信息
+     */
+    public void putLaunchExtras(Intent intent, VProcessInfo processInfo) {
+        if (intent == null || processInfo == null || processInfo.mappingTableFd == null) {
+            return;
+        }
+        
+        Bundle extras = new Bundle();
+        extras.putBinder(EXTRA_MAPPING_TABLE, new MappingTableBinder(processInfo.mappingTableFd));
+        intent.putExtras(extras);
+    }
+    
+    /**
+     * 虚拟进程：从启动Intent取得宿主的共享映射表并映射，需在IOUniformer.initialize()之前调用
+     * @param launchIntent 启动Intent
+     * @return 是否已映射宿主的共享映射表
+     */
+    public static boolean attachMappingTable(Intent launchIntent) {
+        if (launchIntent == null || launchIntent.getExtras() == null) {
+            return false;
+        }
+        
+        IBinder binder = launchIntent.getExtras().getBinder(EXTRA_MAPPING_TABLE);
+        if (binder == null) {
+            return false;
+        }
+        
+        ParcelFileDescriptor fd = MappingTableBinder.fetch(binder);
+        if (fd == null) {
+            Log.w(TAG, "Host did not provide a shared mapping table");
+            return false;
+        }
+        return IOUniformer.getInstance().attachSharedMappingTable(fd);
+    }
+    
+    /**
+     * 跨进程提供共享映射表只读描述符的Binder，每次请求都由Parcel复制一份新的fd
+     */
+    private static class MappingTableBinder extends Binder {
+        
+        private static final int TRANSACTION_GET_FD = IBinder.FIRST_CALL_TRANSACTION;
+        
+        private final ParcelFileDescriptor mFd;
+        
+        MappingTableBinder(ParcelFileDescriptor fd) {
+            mFd = fd;
+        }
+        
+        @Override
+        protected boolean onTransact(int code, Parcel data, Parcel reply, int flags) throws RemoteException {
+            if (code != TRANSACTION_GET_FD) {
+                return super.onTransact(code, data, reply, flags);
+            }
+            
+            // 宿主可能已在进程停止时关闭描述符
+            FileDescriptor fd = mFd.getFileDescriptor();
+            if (fd == null || !fd.valid()) {
+                reply.writeInt(0);
+                return true;
+            }
+            reply.writeInt(1);
+            reply.writeFileDescriptor(fd);
+            return true;
+        }
+        
+        static ParcelFileDescriptor fetch(IBinder binder) {
+            Parcel data = Parcel.obtain();
+            Parcel reply = Parcel.obtain();
+            try {
+                if (!binder.transact(TRANSACTION_GET_FD, data, reply, 0) || reply.readInt() == 0) {
+                    return null;
+                }
+                return reply.readFileDescriptor();
+            } catch (RemoteException e) {
+                Log.e(TAG, "Failed to fetch shared mapping table", e);
+                return null;
+            } finally {
+                reply.recycle();
+                data.recycle();
+            }
+        }
+    }
+    
     /**
      * 停止虚拟Activity
      * @param processInfo 进程信息
@@ -5,6 +5,7 @@ import android.util.Log;
 import java.lang.reflect.Constructor;
 import java.lang.reflect.Field;
 import java.lang.reflect.Method;
+import java.lang.reflect.Modifier;
 import java.util.concurrent.ConcurrentHashMap;
 import java.util.concurrent.atomic.AtomicBoolean;
 
@@ -28,6 +29,10 @@ public class SandHook {
     private native boolean nativeUnhookMethod(Method target);
     private native Object nativeCallOriginMethod(Method backup, Object receiver, Object... args);
     
+    // Native层用这两个相邻的静态方法探测ArtMethod布局，不要调用或改名
+    private static void artMethodProbeA() {}
+    private static void artMethodProbeB() {}
+    
     static {
         try {
             System.loadLibrary("virtualspace");
@@ -119,17 +124,21 @@ public class SandHook {
             }
             
             // 获取Hook方法
-            Method hookMethod = hookClass.getDeclaredMethod(hookMethodName, targetMethod.getParameterTypes());
+            Method hookMethod = findHookMethod(hookClass, hookMethodName, targetMethod);
             if (hookMethod == null) {
                 return new HookResult(false, "Hook method not found", null);
             }
             
-            // 创建备份方法
+            // 创建备份方法；替换入口后原方法只能经由备份调用，没有备份时不Hook
             Method backupMethod = createBackupMethod(targetMethod);
             if (backupMethod == null) {
                 return new HookResult(false, "Failed to create backup method", null);
             }
             
+            // 静态方法的类初始化完成后ART会重设入口，必须在替换入口之前完成初始化
+            ensureClassInitialized(targetMethod.getDeclaringClass());
+            ensureClassInitialized(hookMethod.getDeclaringClass());
+            
             // 执行Hook
             boolean success = nativeHookMethod(targetMethod, hookMethod, backupMethod);
             if (!success) {
@@ -169,12 +178,16 @@ public class SandHook {
         try {
             Log.d(TAG, "Hooking method: " + targetMethod.toString());
             
-            // 创建备份方法
+            // 创建备份方法；替换入口后原方法只能经由备份调用，没有备份时不Hook
             Method backupMethod = createBackupMethod(targetMethod);
             if (backupMethod == null) {
                 return new HookResult(false, "Failed to create backup method", null);
             }
             
+            // 静态方法的类初始化完成后ART会重设入口，必须在替换入口之前完成初始化
+            ensureClassInitialized(targetMethod.getDeclaringClass());
+            ensureClassInitialized(hookMethod.getDeclaringClass());
+            
             // 执行Hook
             boolean success = nativeHookMethod(targetMethod, hookMethod, backupMethod);
             if (!success) {
@@ -229,8 +242,9 @@ public class SandHook {
             
             // 清理注册信息
             mHookRegistry.remove(hookKey);
-            String backupKey = getBackupKey(hookInfo.backupMethod);
-            mBackupRegistry.remove(backupKey);
+            if (hookInfo.backupMethod != null) {
+                mBackupRegistry.remove(getBackupKey(hookInfo.backupMethod));
+            }
             
             Log.d(TAG, "Method unhooked successfully: " + hookKey);
             return true;
@@ -349,6 +363,45 @@ public class SandHook {
         }
     }
     
+    /**
+     * 查找Hook方法
+     * Hook方法必须是静态方法；目标是实例方法时第一个参数接收this，类型为目标类或Object
+     * @param hookClass Hook类
+     * @param hookMethodName Hook方法名
+     * @param targetMethod 目标方法
+     * @return Hook方法，未找到返回null
+     */
+    private Method findHookMethod(Class<?> hookClass, String hookMethodName, Method targetMethod) {
+        Class<?>[] parameterTypes = targetMethod.getParameterTypes();
+        if (Modifier.isStatic(targetMethod.getModifiers())) {
+            try {
+                return hookClass.getDeclaredMethod(hookMethodName, parameterTypes);
+            } catch (NoSuchMethodException e) {
+                return null;
+            }
+        }
+        
+        Class<?>[] hookTypes = new Class<?>[parameterTypes.length + 1];
+        System.arraycopy(parameterTypes, 0, hookTypes, 1, parameterTypes.length);
+        for (Class<?> receiverType : new Class<?>[] {targetMethod.getDeclaringClass(), Object.class}) {
+            hookTypes[0] = receiverType;
+            try {
+                return hookClass.getDeclaredMethod(hookMethodName, hookTypes);
+            } catch (NoSuchMethodException e) {
+                // 继续尝试Object
+            }
+        }
+        return null;
+    }
+    
+    /**
+     * 确保类已初始化
+     * @param clazz 类
+     */
+    private void ensureClassInitialized(Class<?> clazz) throws ClassNotFoundException {
+        Class.forName(clazz.getName(), true, clazz.getClassLoader());
+    }
+    
     /**
      * 创建备份方法
      * @param targetMethod 目标方法
@@ -7,6 +7,8 @@ import android.os.RemoteException;
 import android.util.Log;
 
 import java.io.File;
+import java.util.LinkedHashMap;
+import java.util.Map;
 import java.util.concurrent.atomic.AtomicBoolean;
 
 /**
@@ -53,6 +55,20 @@ public class VClient {
      * @return 初始化是否成功
      */
     public boolean initialize(Context context, String packageName, int userId, String processName) {
+        return initialize(context, packageName, userId, processName, null);
+    }
+    
+    /**
+     * 初始化虚拟化客户端
+     * @param context 应用上下文
+     * @param packageName 虚拟包名
+     * @param userId 虚拟用户ID
+     * @param processName 虚拟进程名
+     * @param launchIntent 宿主的启动Intent，携带共享映射表；为null时本进程自行建立映射
+     * @return 初始化是否成功
+     */
+    public boolean initialize(Context context, String packageName, int userId, String processName,
+                              Intent launchIntent) {
         if (mIsInitialized.get()) {
             Log.w(TAG, "VClient already initialized");
             return true;
@@ -70,9 +86,12 @@ public class VClient {
             mEnvironment = new VEnvironment(mContext);
             mEnvironment.initialize();
             
-            // 初始化IO重定向器
-            mIOUniformer = new IOUniformer(mContext);
-            mIOUniformer.initialize();
+            // 初始化IO重定向器，宿主提供了共享映射表时先映射，初始化时不再重建默认映射
+            mIOUniformer = IOUniformer.getInstance();
+            if (ProcessManager.attachMappingTable(launchIntent)) {
+                Log.d(TAG, "Attached host shared mapping table");
+            }
+            mIOUniformer.initialize(mContext);
             
             // 初始化Binder提供者
             mBinderProvider = new BinderProvider(mContext);
@@ -219,30 +238,35 @@ public class VClient {
      */
     private void setupPathMapping() {
         try {
+            Map<String, String> mappings = new LinkedHashMap<>();
+            
             // 数据目录映射
             String realDataDir = mContext.getApplicationInfo().dataDir;
             String virtualDataDir = mEnvironment.getVirtualDataPath(mVirtualPackageName);
-            mIOUniformer.addPathMapping(realDataDir, virtualDataDir);
+            mappings.put(realDataDir, virtualDataDir);
             
             // 缓存目录映射
             String realCacheDir = mContext.getCacheDir().getAbsolutePath();
             String virtualCacheDir = mEnvironment.getVirtualCachePath(mVirtualPackageName);
-            mIOUniformer.addPathMapping(realCacheDir, virtualCacheDir);
+            mappings.put(realCacheDir, virtualCacheDir);
             
             // 外部存储目录映射
             String realExternalDir = mContext.getExternalFilesDir(null).getAbsolutePath();
             String virtualExternalDir = mEnvironment.getVirtualExternalPath(mVirtualPackageName);
-            mIOUniformer.addPathMapping(realExternalDir, virtualExternalDir);
+            mappings.put(realExternalDir, virtualExternalDir);
             
             // 数据库目录映射
             String realDatabaseDir = mContext.getDatabasePath("dummy").getParent();
             String virtualDatabaseDir = mEnvironment.getVirtualDatabasePath(mVirtualPackageName);
-            mIOUniformer.addPathMapping(realDatabaseDir, virtualDatabaseDir);
+            mappings.put(realDatabaseDir, virtualDatabaseDir);
             
             // SharedPreferences目录映射
             String realPrefsDir = mContext.getApplicationInfo().dataDir + "/shared_prefs";
             String virtualPrefsDir = mEnvironment.getVirtualPrefsPath(mVirtualPackageName);
-            mIOUniformer.addPathMapping(realPrefsDir, virtualPrefsDir);
+            mappings.put(realPrefsDir, virtualPrefsDir);
+            
+            // 一次性安装所有映射
+            mIOUniformer.addPathMappings(mappings);
             
             Log.d(TAG, "Path mapping setup completed");
             
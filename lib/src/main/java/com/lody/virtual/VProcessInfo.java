@@ -1,5 +1,7 @@
 package com.lody.virtual;
 
+import android.os.ParcelFileDescriptor;
+
 /**
  * 虚拟进程信息类
  * 存储虚拟进程的详细信息
@@ -134,6 +136,11 @@ public class VProcessInfo {
      */
     public String crashStack;
     
+    /**
+     * 共享映射表只读描述符，由宿主持有，通过启动Intent中的Binder交给虚拟进程
+     */
+    public ParcelFileDescriptor mappingTableFd;
+    
     public VProcessInfo() {
         // 默认构造函数
         this.status = STATUS_UNKNOWN;
@@ -175,6 +182,8 @@ public class VProcessInfo {
         this.customConfig = other.customConfig;
         this.errorMessage = other.errorMessage;
         this.crashStack = other.crashStack;
+        // 描述符归原对象所有并由ProcessManager关闭，副本不持有，避免重复关闭
+        this.mappingTableFd = null;
     }
     
     /**
@@ -2,7 +2,7 @@ package com.lody.virtual.hooks;
 
 import android.util.Log;
 import com.lody.virtual.HookWrapper;
-import com.lody.virtual.VEnvironment;
+import com.lody.virtual.IOUniformer;
 
 import java.io.File;
 
@@ -14,6 +14,9 @@ public class FileSystemHooks {
     
     private static final String TAG = "FileSystemHooks";
     
+    // 调试日志开关，关闭时Hook路径上不拼接日志字符串
+    private static final boolean DEBUG = Log.isLoggable(TAG, Log.DEBUG);
+    
     /**
      * Hook File构造函数
      * 重定向文件路径到虚拟环境
@@ -26,12 +29,12 @@ public class FileSystemHooks {
     )
     public static void hookFileConstructor(String path) {
         try {
-            Log.d(TAG, "Hook File constructor: " + path);
-            
-            // 检查是否需要重定向
-            String redirectedPath = VEnvironment.getRedirectedPath(path);
-            if (!redirectedPath.equals(path)) {
-                Log.d(TAG, "Redirecting path: " + path + " -> " + redirectedPath);
+            // 检查是否需要重定向，未映射时返回同一个对象，不产生垃圾
+            String redirectedPath = getVirtualPath(path);
+            if (redirectedPath != path) {
+                if (DEBUG) {
+                    Log.d(TAG, "Redirecting path: " + path + " -> " + redirectedPath);
+                }
                 // 调用原始构造函数，但使用重定向后的路径
                 // 这里需要通过反射调用原始方法
             }
@@ -53,14 +56,18 @@ public class FileSystemHooks {
     public static boolean hookFileExists(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.exists(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.exists(): " + path);
+            }
             
             // 检查虚拟环境中的文件
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             boolean exists = virtualFile.exists();
-            Log.d(TAG, "File exists in virtual environment: " + exists);
+            if (DEBUG) {
+                Log.d(TAG, "File exists in virtual environment: " + exists);
+            }
             
             return exists;
             
@@ -82,13 +89,17 @@ public class FileSystemHooks {
     public static String hookFileGetAbsolutePath(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.getAbsolutePath(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.getAbsolutePath(): " + path);
+            }
             
             // 返回虚拟环境中的绝对路径
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             String absolutePath = new File(virtualPath).getAbsolutePath();
             
-            Log.d(TAG, "Returning virtual absolute path: " + absolutePath);
+            if (DEBUG) {
+                Log.d(TAG, "Returning virtual absolute path: " + absolutePath);
+            }
             return absolutePath;
             
         } catch (Exception e) {
@@ -109,13 +120,17 @@ public class FileSystemHooks {
     public static String hookFileGetCanonicalPath(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.getCanonicalPath(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.getCanonicalPath(): " + path);
+            }
             
             // 返回虚拟环境中的规范路径
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             String canonicalPath = new File(virtualPath).getCanonicalPath();
             
-            Log.d(TAG, "Returning virtual canonical path: " + canonicalPath);
+            if (DEBUG) {
+                Log.d(TAG, "Returning virtual canonical path: " + canonicalPath);
+            }
             return canonicalPath;
             
         } catch (Exception e) {
@@ -136,14 +151,18 @@ public class FileSystemHooks {
     public static String[] hookFileList(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.list(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.list(): " + path);
+            }
             
             // 返回虚拟环境中的文件列表
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             String[] list = virtualFile.list();
-            Log.d(TAG, "Returning virtual file list, count: " + (list != null ? list.length : 0));
+            if (DEBUG) {
+                Log.d(TAG, "Returning virtual file list, count: " + (list != null ? list.length : 0));
+            }
             
             return list;
             
@@ -165,14 +184,18 @@ public class FileSystemHooks {
     public static File[] hookFileListFiles(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.listFiles(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.listFiles(): " + path);
+            }
             
             // 返回虚拟环境中的文件对象列表
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             File[] files = virtualFile.listFiles();
-            Log.d(TAG, "Returning virtual file objects, count: " + (files != null ? files.length : 0));
+            if (DEBUG) {
+                Log.d(TAG, "Returning virtual file objects, count: " + (files != null ? files.length : 0));
+            }
             
             return files;
             
@@ -194,14 +217,18 @@ public class FileSystemHooks {
     public static boolean hookFileMkdir(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.mkdir(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.mkdir(): " + path);
+            }
             
             // 在虚拟环境中创建目录
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             boolean result = virtualFile.mkdir();
-            Log.d(TAG, "Created directory in virtual environment: " + result);
+            if (DEBUG) {
+                Log.d(TAG, "Created directory in virtual environment: " + result);
+            }
             
             return result;
             
@@ -223,14 +250,18 @@ public class FileSystemHooks {
     public static boolean hookFileMkdirs(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.mkdirs(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.mkdirs(): " + path);
+            }
             
             // 在虚拟环境中创建多级目录
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             boolean result = virtualFile.mkdirs();
-            Log.d(TAG, "Created directories in virtual environment: " + result);
+            if (DEBUG) {
+                Log.d(TAG, "Created directories in virtual environment: " + result);
+            }
             
             return result;
             
@@ -252,14 +283,18 @@ public class FileSystemHooks {
     public static boolean hookFileDelete(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.delete(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.delete(): " + path);
+            }
             
             // 在虚拟环境中删除文件
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             boolean result = virtualFile.delete();
-            Log.d(TAG, "Deleted file in virtual environment: " + result);
+            if (DEBUG) {
+                Log.d(TAG, "Deleted file in virtual environment: " + result);
+            }
             
             return result;
             
@@ -283,17 +318,21 @@ public class FileSystemHooks {
         try {
             String srcPath = getFilePath(file);
             String destPath = dest.getPath();
-            Log.d(TAG, "Hook File.renameTo(): " + srcPath + " -> " + destPath);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.renameTo(): " + srcPath + " -> " + destPath);
+            }
             
             // 在虚拟环境中重命名文件
-            String virtualSrcPath = VEnvironment.getVirtualPath(srcPath);
-            String virtualDestPath = VEnvironment.getVirtualPath(destPath);
+            String virtualSrcPath = getVirtualPath(srcPath);
+            String virtualDestPath = getVirtualPath(destPath);
             
             File virtualSrcFile = new File(virtualSrcPath);
             File virtualDestFile = new File(virtualDestPath);
             
             boolean result = virtualSrcFile.renameTo(virtualDestFile);
-            Log.d(TAG, "Renamed file in virtual environment: " + result);
+            if (DEBUG) {
+                Log.d(TAG, "Renamed file in virtual environment: " + result);
+            }
             
             return result;
             
@@ -315,14 +354,18 @@ public class FileSystemHooks {
     public static boolean hookFileCreateNewFile(Object file) {
         try {
             String path = getFilePath(file);
-            Log.d(TAG, "Hook File.createNewFile(): " + path);
+            if (DEBUG) {
+                Log.d(TAG, "Hook File.createNewFile(): " + path);
+            }
             
             // 在虚拟环境中创建新文件
-            String virtualPath = VEnvironment.getVirtualPath(path);
+            String virtualPath = getVirtualPath(path);
             File virtualFile = new File(virtualPath);
             
             boolean result = virtualFile.createNewFile();
-            Log.d(TAG, "Created new file in virtual environment: " + result);
+            if (DEBUG) {
+                Log.d(TAG, "Created new file in virtual environment: " + result);
+            }
             
             return result;
             
@@ -332,6 +375,14 @@ public class FileSystemHooks {
         }
     }
     
+    /**
+     * 获取虚拟环境中的路径，走IOUniformer的每线程直接缓冲区
+     * 未映射时返回传入的同一个对象
+     */
+    private static String getVirtualPath(String path) {
+        return IOUniformer.getInstance().redirectPathDirect(path);
+    }
+    
     /**
      * 获取文件路径的辅助方法
      */
@@ -53,6 +53,38 @@ public class PerformanceMonitor {
     public static final int DEFAULT_ALERT_THRESHOLD = 80; // 80%
     public static final int DEFAULT_HISTORY_SIZE = 1000; // 1000条记录
     
+    // Native IO追踪：每条记录占4个long
+    private static final int IO_TRACE_RECORD_LONGS = 4;
+    private static final int IO_TRACE_BATCH_SIZE = 1024;
+    
+    // Native IO统计：long[]布局，需与IOStats.h保持一致
+    private static final int IO_STATS_LAYOUT_VERSION = 1;
+    private static final int IO_STATS_HEADER_FIELDS = 7;
+    private static final int IO_STATS_SYSCALL_SLOTS = 18;
+    private static final int IO_STATS_LATENCY_BUCKETS = 272;
+    private static final int IO_STATS_SUB_BUCKET_BITS = 3;
+    private static final int IO_STATS_FIXED_LENGTH =
+            IO_STATS_HEADER_FIELDS + IO_STATS_SYSCALL_SLOTS + IO_STATS_LATENCY_BUCKETS;
+    
+    // 复用的统计缓冲区，映射数增加时扩容
+    private long[] mIOStatsBuffer = new long[IO_STATS_FIXED_LENGTH + 64 * 2];
+    
+    // Native方法声明
+    private native void nativeSetIOTraceEnabled(boolean enabled);
+    private native int nativeDrainIOTrace(long[] records);
+    private native long nativeGetIOTraceDropped();
+    private native void nativeSetIOStatsEnabled(boolean enabled);
+    private native void nativeResetIOStats();
+    private native int nativeGetIOStats(long[] stats);
+    
+    static {
+        try {
+            System.loadLibrary("virtualspace");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library", e);
+        }
+    }
+    
     private PerformanceMonitor() {
         // 私有构造函数，实现单例模式
     }
@@ -299,6 +331,108 @@ public class PerformanceMonitor {
         return mPerformanceData.get(packageName);
     }
     
+    /**
+     * 开启或关闭Native层重定向系统调用追踪
+     * @param enabled 是否开启
+     * @return 是否成功
+     */
+    public boolean setNativeIOTraceEnabled(boolean enabled) {
+        try {
+            nativeSetIOTraceEnabled(enabled);
+            Log.d(TAG, "Native IO trace " + (enabled ? "enabled" : "disabled"));
+            return true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Native IO trace not available", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 取出Native层已收集的重定向系统调用记录
+     * @return 追踪记录列表
+     */
+    public List<IOTraceRecord> drainNativeIOTrace() {
+        List<IOTraceRecord> result = new ArrayList<>();
+        
+        try {
+            long[] buffer = new long[IO_TRACE_BATCH_SIZE * IO_TRACE_RECORD_LONGS];
+            int count;
+            do {
+                count = nativeDrainIOTrace(buffer);
+                for (int i = 0; i < count; i++) {
+                    int offset = i * IO_TRACE_RECORD_LONGS;
+                    result.add(new IOTraceRecord((int) buffer[offset], (int) buffer[offset + 1],
+                            buffer[offset + 2], buffer[offset + 3]));
+                }
+            } while (count == IO_TRACE_BATCH_SIZE);
+            
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Native IO trace not available", e);
+        }
+        
+        return result;
+    }
+    
+    /**
+     * 获取Native层因缓冲区满而丢弃的追踪记录数
+     */
+    public long getNativeIOTraceDroppedCount() {
+        try {
+            return nativeGetIOTraceDropped();
+        } catch (UnsatisfiedLinkError e) {
+            return 0;
+        }
+    }
+    
+    /**
+     * 开启或关闭Native层重定向统计（Hook调用次数、查找耗时直方图、映射命中次数）
+     * @param enabled 是否开启
+     * @return 是否成功
+     */
+    public boolean setNativeIOStatsEnabled(boolean enabled) {
+        try {
+            nativeSetIOStatsEnabled(enabled);
+            Log.d(TAG, "Native IO stats " + (enabled ? "enabled" : "disabled"));
+            return true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Native IO stats not available", e);
+            return false;
+        }
+    }
+    
+    /**
+     * 清零Native层重定向统计
+     */
+    public void resetNativeIOStats() {
+        try {
+            nativeResetIOStats();
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Native IO stats not available", e);
+        }
+    }
+    
+    /**
+     * 获取Native层重定向统计的累计值
+     * @return 统计快照，不可用时返回null
+     */
+    public synchronized IOStats getNativeIOStats() {
+        try {
+            int required = nativeGetIOStats(mIOStatsBuffer);
+            if (required > mIOStatsBuffer.length) {
+                mIOStatsBuffer = new long[required + 16 * 2];
+                required = nativeGetIOStats(mIOStatsBuffer);
+            }
+            if (required < IO_STATS_FIXED_LENGTH || mIOStatsBuffer[0] != IO_STATS_LAYOUT_VERSION) {
+                return null;
+            }
+            return new IOStats(mIOStatsBuffer);
+            
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Native IO stats not available", e);
+            return null;
+        }
+    }
+    
     /**
      * 获取性能报告
      * @param packageName 包名
@@ -470,6 +604,9 @@ public class PerformanceMonitor {
                 mScheduler.shutdown();
             }
             
+            // 停止Native IO追踪
+            setNativeIOTraceEnabled(false);
+            
             // 清理所有数据
             mPerformanceData.clear();
             mAlertRules.clear();
@@ -680,6 +817,98 @@ public class PerformanceMonitor {
         }
     }
     
+    /**
+     * Native IO追踪记录类
+     */
+    public static class IOTraceRecord {
+        public int syscallId;
+        public int mappingId;
+        public long pathHash;
+        public long latencyNs;
+        
+        public IOTraceRecord(int syscallId, int mappingId, long pathHash, long latencyNs) {
+            this.syscallId = syscallId;
+            this.mappingId = mappingId;
+            this.pathHash = pathHash;
+            this.latencyNs = latencyNs;
+        }
+    }
+    
+    /**
+     * Native IO统计快照类
+     */
+    public static class IOStats {
+        public long cacheHits;
+        public long cacheMisses;
+        public long lookupCount;
+        public long lookupTotalNs;
+        public long mappingDropped;
+        public long[] syscallCounts;        // 按IOTraceRecord.syscallId索引
+        public long[] latencyBuckets;
+        public java.util.Map<Integer, Long> mappingHits;    // 映射编号 -> 命中次数
+        
+        IOStats(long[] values) {
+            this.cacheHits = values[1];
+            this.cacheMisses = values[2];
+            this.lookupCount = values[3];
+            this.lookupTotalNs = values[4];
+            this.mappingDropped = values[6];
+            this.syscallCounts = java.util.Arrays.copyOfRange(values, IO_STATS_HEADER_FIELDS,
+                    IO_STATS_HEADER_FIELDS + IO_STATS_SYSCALL_SLOTS);
+            this.latencyBuckets = java.util.Arrays.copyOfRange(values, IO_STATS_HEADER_FIELDS + IO_STATS_SYSCALL_SLOTS,
+                    IO_STATS_FIXED_LENGTH);
+            this.mappingHits = new java.util.HashMap<>();
+            int mappingCount = (int) values[5];
+            for (int i = 0; i < mappingCount; i++) {
+                int offset = IO_STATS_FIXED_LENGTH + i * 2;
+                mappingHits.put((int) values[offset], values[offset + 1]);
+            }
+        }
+        
+        /**
+         * 线程重定向缓存命中率
+         */
+        public double getCacheHitRatio() {
+            long total = cacheHits + cacheMisses;
+            return total > 0 ? (double) cacheHits / total : 0.0;
+        }
+        
+        /**
+         * 查找耗时的百分位数（取所在分档的下界）
+         * @param percentile 0~100
+         * @return 纳秒
+         */
+        public long getLookupLatencyPercentile(double percentile) {
+            long total = 0;
+            for (long count : latencyBuckets) {
+                total += count;
+            }
+            if (total == 0) {
+                return 0;
+            }
+            
+            long threshold = (long) Math.ceil(total * percentile / 100.0);
+            long seen = 0;
+            for (int i = 0; i < latencyBuckets.length; i++) {
+                seen += latencyBuckets[i];
+                if (seen >= threshold) {
+                    return bucketLowerBound(i);
+                }
+            }
+            return bucketLowerBound(latencyBuckets.length - 1);
+        }
+        
+        private static long bucketLowerBound(int index) {
+            int subBuckets = 1 << IO_STATS_SUB_BUCKET_BITS;
+            if (index < subBuckets) {
+                return index;
+            }
+            int exponent = index / subBuckets + IO_STATS_SUB_BUCKET_BITS - 1;
+            long sub = index % subBuckets;
+            return (subBuckets + sub) << (exponent - IO_STATS_SUB_BUCKET_BITS);
+        }
+    }
+    
     /**
      * 性能记录类
      */
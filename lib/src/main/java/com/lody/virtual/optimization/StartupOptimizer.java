@@ -5,6 +5,7 @@ import android.os.Handler;
 import android.os.Looper;
 import android.util.Log;
 
+import com.lody.virtual.IOUniformer;
 import com.lody.virtual.VirtualCore;
 
 import java.util.ArrayList;
@@ -45,6 +46,11 @@ public class StartupOptimizer {
     public static final int STRATEGY_BALANCED = 1;
     public static final int STRATEGY_SAVE_MEMORY = 2;
     
+    // 启动虚拟应用前等待后台Hook安装的超时时间
+    private static final int HOOK_READY_TIMEOUT_MS = 2000;
+    // 超时后继续等待后台安装的上限，总等待时间留在ANR阈值以内
+    private static final int HOOK_INSTALL_TIMEOUT_MS = 2000;
+    
     private StartupOptimizer() {
         // 私有构造函数，实现单例模式
     }
@@ -535,6 +541,20 @@ public class StartupOptimizer {
      */
     private boolean executeLaunchStage(String packageName, int strategy) {
         try {
+            // 后台安装的Hook就绪前不运行虚拟应用代码，初始化和预加载阶段与其并行；
+            // 超时后再有限等待一次，安装失败或仍未完成时放弃启动。本进程没有安装Hook时没有屏障
+            IOUniformer ioUniformer = IOUniformer.getInstance();
+            int hookState = ioUniformer.waitForHooksReady(HOOK_READY_TIMEOUT_MS);
+            if (hookState == IOUniformer.HOOKS_PENDING) {
+                Log.w(TAG, "System call hooks not ready after " + HOOK_READY_TIMEOUT_MS + "ms, waiting: " + packageName);
+                hookState = ioUniformer.waitForHooksReady(HOOK_INSTALL_TIMEOUT_MS);
+            }
+            if (hookState == IOUniformer.HOOKS_PENDING || hookState == IOUniformer.HOOKS_FAILED) {
+                Log.e(TAG, "System call hooks " + (hookState == IOUniformer.HOOKS_FAILED ? "failed to install" : "still pending")
+                        + ", launch aborted: " + packageName);
+                return false;
+            }
+            
             // TODO: 实现启动逻辑
             Log.d(TAG, "Executing launch stage for: " + packageName);
             return true;